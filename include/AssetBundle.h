@@ -0,0 +1,69 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+/*
+ * Copyright (C) 2025 Robert Wendlandt
+ */
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+// label of the data partition holding the bundle (see the partition table)
+#ifndef CONFIG_THINGY_ASSETS_PARTITION
+  #define CONFIG_THINGY_ASSETS_PARTITION "assets"
+#endif
+
+// has to match tools/assets.py
+#define ASSET_BUNDLE_MAGIC     0x54534154 // 'TAST'
+#define ASSET_BUNDLE_VERSION   1
+#define ASSET_BUNDLE_ALIGNMENT 16
+#define ASSET_PATH_SIZE        40
+#define ASSET_TYPE_SIZE        24
+// the blob is gzipped (served with Content-Encoding: gzip)
+#define ASSET_FLAG_GZIP 0x01
+
+class AsyncWebServerRequest;
+
+namespace Soylent {
+  // The web assets as a single read-only bundle in a flash partition of its own:
+  // a header, an index sorted by path and the blobs (aligned), generated by tools/assets.py at build time
+  // the partition is memory-mapped, so the assets are served right from flash (through the cache) without any copy
+  // it is written by SafeBoot (filesystem mode, it tells the bundle by its magic), independently of the app
+  namespace AssetBundle {
+    struct __attribute__((packed)) Header {
+        uint32_t magic;
+        uint16_t version;
+        uint16_t count;
+        // of the whole bundle, including the header
+        uint32_t size;
+        // of everything after the header
+        uint32_t crc;
+    };
+
+    struct __attribute__((packed)) Entry {
+        // from the start of the bundle
+        uint32_t offset;
+        uint32_t length;
+        // of the blob, served as its ETag
+        uint32_t crc;
+        uint8_t flags;
+        uint8_t reserved[3];
+        char path[ASSET_PATH_SIZE];
+        char type[ASSET_TYPE_SIZE];
+    };
+
+    static_assert(sizeof(Header) == 16 && sizeof(Entry) == 80, "the layout has to match tools/assets.py");
+
+    // map the partition and check the bundle, false if there is none (or it's broken)
+    bool begin();
+    bool isAvailable();
+    // there is a partition for the bundle (a partition table from before the bundle has none, see README)
+    bool hasPartition();
+    // the mapped bundle (nullptr if not available)
+    const Header* getHeader();
+    // by its path (e.g. "/favicon.svg"), nullptr if not in the bundle
+    const Entry* find(const char* path);
+    const uint8_t* getData(const Entry& entry);
+    // send an asset (or 304 when the client has it already), false if it's not in the bundle
+    bool send(AsyncWebServerRequest* request, const char* path, const char* cacheControl = nullptr);
+  } // namespace AssetBundle
+} // namespace Soylent
@@ -0,0 +1,114 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+/*
+ * Copyright (C) 2025 Robert Wendlandt
+ */
+#pragma once
+
+#include <TaskSchedulerDeclarations.h>
+#include <string>
+#include <vector>
+
+// changed settings are written to NVS once there were no more changes for as long (in ms)
+#ifndef CONFIG_THINGY_CONFIG_FLUSH_DELAY
+  #define CONFIG_THINGY_CONFIG_FLUSH_DELAY 10000
+#endif
+
+// ...but no later than this after the first change (in ms), even if they keep on changing
+#ifndef CONFIG_THINGY_CONFIG_FLUSH_MAX_DELAY
+  #define CONFIG_THINGY_CONFIG_FLUSH_MAX_DELAY 60000
+#endif
+
+// larger blobs are only kept in RAM until they are written (in bytes)
+#ifndef CONFIG_THINGY_CONFIG_CACHE_SIZE
+  #define CONFIG_THINGY_CONFIG_CACHE_SIZE 128
+#endif
+
+// NVS keeps 126 entries of 32 bytes per page of 4 kB
+#define NVS_ENTRY_BYTES  32
+#define NVS_PAGE_ENTRIES 126
+
+namespace Soylent {
+  // Settings held in RAM and written to NVS lazily: a value is only written when it differs from what's
+  // in NVS, a few changes in a row end up as a single write once it got quiet (or right before a restart)
+  // NVS is only read on the first access of a setting
+  // only to be used from the loop task (setup() and the tasks of the scheduler)
+  // builds without Preferences (the host tests in tests/) keep NVS in a map instead, with the same accounting
+  class ConfigClass {
+    public:
+      struct Statistics {
+          // values written to NVS
+          uint32_t writes;
+          // values not written, as they were unchanged
+          uint32_t writesAvoided;
+          // values changed again before they were written
+          uint32_t writesCoalesced;
+          uint32_t flushes;
+          // NVS entries and bytes written (a page of NVS is erased once its entries are used up)
+          uint32_t entriesWritten;
+          uint32_t bytesWritten;
+          uint32_t errors;
+      };
+
+      ConfigClass();
+      void begin(Scheduler* scheduler);
+      // write what's pending
+      void end();
+
+      std::string getString(const char* space, const char* key, const std::string& defaultValue = std::string());
+      uint32_t getULong(const char* space, const char* key, uint32_t defaultValue = 0);
+      bool getBool(const char* space, const char* key, bool defaultValue = false);
+      // copies at most len bytes, returns how many there are (0 if not set)
+      size_t getBytes(const char* space, const char* key, void* buffer, size_t len);
+
+      void putString(const char* space, const char* key, const std::string& value);
+      void putULong(const char* space, const char* key, uint32_t value);
+      void putBool(const char* space, const char* key, bool value);
+      void putBytes(const char* space, const char* key, const void* value, size_t len);
+
+      // write all changes (or those of a namespace) to NVS right away (e.g. before a restart), true if there were any
+      bool flush(const char* space = nullptr);
+      // settings changed, but not written yet
+      uint16_t getPending();
+      const Statistics& getStatistics();
+      // page erases caused by the writes so far (estimated)
+      float getEstimatedPageErases();
+
+    private:
+      enum class Type : uint8_t {
+        STRING = 0,
+        ULONG = 1,
+        BOOL = 2,
+        BYTES = 3
+      };
+
+      struct Entry {
+          // namespace and key (at most 15 characters each)
+          std::string space;
+          std::string key;
+          Type type;
+          // set in NVS (or about to be)
+          bool present;
+          // value holds the value (large blobs are dropped once written)
+          bool cached;
+          // changed, but not written yet
+          bool dirty;
+          std::string value;
+          uint32_t size;
+          uint32_t crc;
+      };
+
+      Entry* _load(const char* space, const char* key, Type type);
+      void _put(const char* space, const char* key, Type type, const void* value, size_t len);
+      void _flushCallback();
+      static uint32_t _entriesOf(Type type, size_t size);
+      static bool _read(const std::string& space, const std::string& key, Type type, std::string* value);
+      static bool _write(const std::string& space, const std::string& key, Type type, const std::string& value);
+      Task* _flushTask;
+      Scheduler* _scheduler;
+      std::vector<Entry> _entries;
+      uint16_t _pending;
+      // millis() of the first change not written yet
+      uint32_t _pendingSince;
+      Statistics _statistics;
+  };
+} // namespace Soylent
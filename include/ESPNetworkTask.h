@@ -6,6 +6,12 @@
 
 #include <TaskSchedulerDeclarations.h>
 
+// ESPConnect is looped this often (in ms), all its timeouts are in seconds anyway
+// (looping it immediately would keep the main loop from ever sleeping, see PowerTask.h)
+#ifndef CONFIG_THINGY_NETWORK_LOOP_INTERVAL
+  #define CONFIG_THINGY_NETWORK_LOOP_INTERVAL 50
+#endif
+
 namespace Soylent {
   class ESPNetworkClass {
     public:
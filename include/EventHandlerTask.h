@@ -14,11 +14,14 @@ namespace Soylent {
       void begin(Scheduler* scheduler);
       void end();
       Soylent::ESPConnect::State getState();
+      // micros() since start-up when the network (or the AP) first came up (0 if not yet)
+      uint32_t getConnectedAt();
 
     private:
       void _stateCallback(Soylent::ESPConnect::State state);
       Soylent::ESPConnect::State _state;
       Scheduler* _scheduler;
       Soylent::ESPNetworkClass* _espNetwork;
+      uint32_t _connectedAt;
   };
 } // namespace Soylent
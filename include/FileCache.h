@@ -0,0 +1,78 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+/*
+ * Copyright (C) 2025 Robert Wendlandt
+ */
+#pragma once
+
+#include <FS.h>
+#include <atomic>
+#include <memory>
+#include <string>
+#include <vector>
+
+// bytes of small files kept in RAM (e.g. the images of the LED states on LittleFS), 0 to always read them from the file system
+#ifndef CONFIG_THINGY_FILE_CACHE_SIZE
+  #define CONFIG_THINGY_FILE_CACHE_SIZE 16384
+#endif
+
+// larger files are not kept, they are streamed from the file system (in bytes)
+#ifndef CONFIG_THINGY_FILE_CACHE_MAX_FILE
+  #define CONFIG_THINGY_FILE_CACHE_MAX_FILE 6144
+#endif
+
+class AsyncWebServerRequest;
+
+namespace Soylent {
+  // Small files of a file system kept in RAM, the least recently used one is dropped when running out of space
+  // every file carries its crc as ETag, a client asking again with it gets a 304 (on a hit)
+  // a response holds on to the content of its file, so dropping a file while it's still being sent is fine
+  // only to be used from the async_tcp task (the requests), but for invalidate()
+  class FileCache {
+    public:
+      struct Statistics {
+          uint32_t hits;
+          // read from the file system (and kept)
+          uint32_t misses;
+          // too large, streamed from the file system
+          uint32_t bypassed;
+          // hits answered with a 304
+          uint32_t notModified;
+          uint32_t evictions;
+          uint32_t invalidations;
+          uint16_t files;
+          uint32_t bytes;
+      };
+
+      explicit FileCache(fs::FS& fs, size_t capacity = CONFIG_THINGY_FILE_CACHE_SIZE, size_t maxFile = CONFIG_THINGY_FILE_CACHE_MAX_FILE);
+      // send a file (path on the file system), from RAM if possible, 404 if there is none
+      void send(AsyncWebServerRequest* request, const std::string& path, const char* cacheControl = nullptr);
+      // drop everything, e.g. when the file system is about to change (from any task, takes effect with the next request)
+      void invalidate();
+      const Statistics& getStatistics();
+
+    private:
+      struct Entry {
+          std::string path;
+          std::shared_ptr<const std::vector<uint8_t>> content;
+          const char* type;
+          bool gzip;
+          uint32_t crc;
+          // of the last request
+          uint32_t usedAt;
+      };
+
+      Entry* _find(const std::string& path);
+      Entry* _load(const std::string& path);
+      void _evict(size_t needed);
+      static const char* _typeOf(const std::string& path);
+      fs::FS* _fs;
+      size_t _capacity;
+      size_t _maxFile;
+      std::vector<Entry> _entries;
+      // counts the requests, for finding the least recently used entry
+      uint32_t _clock;
+      std::atomic<uint32_t> _generation;
+      uint32_t _cachedGeneration;
+      Statistics _statistics;
+  };
+} // namespace Soylent
@@ -0,0 +1,117 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+/*
+ * Copyright (C) 2025 Robert Wendlandt
+ */
+#pragma once
+
+#include <Arduino.h>
+
+namespace Soylent {
+  // Histogram of latencies (in us) with logarithmic buckets, HDR-style:
+  // values below 8 get a bucket each, every power of two above is split into 8 buckets,
+  // so a value is off by 12.5 % at most (values beyond ~67 s all end up in the last bucket)
+  // recorded from any task, read (and reset) at once, e.g. when being scraped
+  class LatencyHistogram {
+    public:
+      static constexpr uint8_t SUB_BITS = 3;
+      static constexpr uint8_t SUB_BUCKETS = 1 << SUB_BITS;
+      static constexpr uint8_t MAX_MAGNITUDE = 25;
+      static constexpr uint16_t BUCKETS = (MAX_MAGNITUDE - SUB_BITS + 2) * SUB_BUCKETS;
+
+      struct Summary {
+          uint32_t count;
+          uint32_t min;
+          uint32_t avg;
+          uint32_t p50;
+          uint32_t p90;
+          uint32_t p99;
+          uint32_t max;
+          // millis() the values were recorded since
+          uint32_t since;
+      };
+
+      void record(uint32_t value) {
+        uint16_t bucket = bucketOf(value);
+        taskENTER_CRITICAL(&_lock);
+        _buckets[bucket]++;
+        if (_count == 0 || value < _min) {
+          _min = value;
+        }
+        if (value > _max) {
+          _max = value;
+        }
+        _sum += value;
+        _count++;
+        taskEXIT_CRITICAL(&_lock);
+      }
+
+      // percentiles are the highest value of the bucket they are in (but never above the max)
+      Summary summarize(bool reset) {
+        Summary summary;
+        taskENTER_CRITICAL(&_lock);
+        summary.count = _count;
+        summary.min = _min;
+        summary.max = _max;
+        summary.avg = _count ? _sum / _count : 0;
+        summary.since = _since;
+        summary.p50 = _percentile(50);
+        summary.p90 = _percentile(90);
+        summary.p99 = _percentile(99);
+        if (reset) {
+          memset(_buckets, 0, sizeof(_buckets));
+          _count = 0;
+          _min = 0;
+          _max = 0;
+          _sum = 0;
+          _since = millis();
+        }
+        taskEXIT_CRITICAL(&_lock);
+        return summary;
+      }
+
+      static uint16_t bucketOf(uint32_t value) {
+        if (value < SUB_BUCKETS) {
+          return value;
+        }
+        uint8_t magnitude = 31 - __builtin_clz(value);
+        if (magnitude > MAX_MAGNITUDE) {
+          return BUCKETS - 1;
+        }
+        return (magnitude - SUB_BITS + 1) * SUB_BUCKETS + ((value >> (magnitude - SUB_BITS)) & (SUB_BUCKETS - 1));
+      }
+
+      // highest value ending up in a bucket
+      static uint32_t highestOf(uint16_t bucket) {
+        if (bucket < SUB_BUCKETS) {
+          return bucket;
+        }
+        uint8_t shift = bucket / SUB_BUCKETS - 1;
+        return ((static_cast<uint32_t>(SUB_BUCKETS + bucket % SUB_BUCKETS) + 1) << shift) - 1;
+      }
+
+    private:
+      // (with the lock taken)
+      uint32_t _percentile(uint8_t percent) {
+        if (_count == 0) {
+          return 0;
+        }
+        uint32_t rank = (static_cast<uint64_t>(_count) * percent + 99) / 100;
+        uint32_t seen = 0;
+        for (uint16_t bucket = 0; bucket < BUCKETS; bucket++) {
+          seen += _buckets[bucket];
+          if (seen >= rank) {
+            return std::min(highestOf(bucket), _max);
+          }
+        }
+        return _max;
+      }
+
+      uint32_t _buckets[BUCKETS] = {};
+      uint32_t _count = 0;
+      uint32_t _min = 0;
+      uint32_t _max = 0;
+      uint64_t _sum = 0;
+      uint32_t _since = 0;
+      portMUX_TYPE _lock = portMUX_INITIALIZER_UNLOCKED;
+  };
+} // namespace Soylent
@@ -0,0 +1,101 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+/*
+ * Copyright (C) 2025 Robert Wendlandt
+ */
+#pragma once
+
+#include <FS.h>
+#include <FastLED.h>
+
+// bytes read from the file at once while playing an animation
+#ifndef CONFIG_THINGY_LED_ANIMATION_READAHEAD
+  #define CONFIG_THINGY_LED_ANIMATION_READAHEAD 512
+#endif
+
+// longest path of an animation file on LittleFS (including the terminating 0)
+#ifndef CONFIG_THINGY_LED_ANIMATION_PATH
+  #define CONFIG_THINGY_LED_ANIMATION_PATH 64
+#endif
+
+#define LED_ANIMATION_MAGIC   "LEDA"
+#define LED_ANIMATION_VERSION 1
+// most bytes of ops encoding the difference of two frames of size bytes
+#define LED_ANIMATION_OPS_SIZE(size) ((size) + (size) / 128 + 1)
+
+namespace Soylent {
+  namespace LedAnimation {
+    // An animation file (written by tools/animation.py, all numbers little endian):
+    //   the header, followed by frameCount frames of
+    //     uint8_t type (KEYFRAME or DELTA), uint16_t length, length bytes of ops
+    //   each frame is XOR'ed onto the previous one (a keyframe onto black) by its ops:
+    //     0x00..0x7F: skip op + 1 bytes (unchanged)
+    //     0x80..0xFF: op - 127 bytes follow, XOR them onto the frame
+    //   the first frame is a keyframe, playback loops back to it after the last one
+    struct __attribute__((packed)) Header {
+        char magic[4];
+        uint8_t version;
+        // frames per second
+        uint8_t frameRate;
+        uint16_t pixelCount;
+        uint32_t frameCount;
+        // frames from one keyframe to the next (informational)
+        uint16_t keyframeInterval;
+        uint16_t reserved;
+    };
+
+    enum FrameType : uint8_t {
+      KEYFRAME = 'K',
+      DELTA = 'D'
+    };
+
+    struct Statistics {
+        volatile uint32_t frames;
+        volatile uint32_t keyframes;
+        // reads from the file (i.e. read-ahead buffers filled)
+        volatile uint32_t reads;
+        volatile uint32_t errors;
+        volatile uint32_t decodeTimeSum;
+        volatile uint32_t decodeTimeMax;
+    };
+
+    // Encode the difference from one frame to another into ops (as in animation files)
+    // at most LED_ANIMATION_OPS_SIZE(size) bytes, returns their number
+    size_t encode(const uint8_t* from, const uint8_t* to, uint32_t size, uint8_t* ops);
+
+    // Plays an animation frame by frame, reading ahead a few hundred bytes at a time (not the whole file)
+    class Player {
+      public:
+        explicit Player(Statistics* statistics) : _statistics(statistics) {}
+        ~Player() {
+          close();
+        }
+
+        bool open(const char* path);
+        void close();
+        // decode the next frame into pixels (still holding the previous one), false on errors
+        bool next(CRGB* pixels);
+
+        // time per frame (in us)
+        uint32_t getFramePeriod() const {
+          return 1000000 / _header.frameRate;
+        }
+
+        const Header& getHeader() const {
+          return _header;
+        }
+
+      private:
+        bool _refill();
+        int _read();
+        bool _xor(uint8_t* raw, uint32_t offset, uint16_t count);
+
+        Statistics* _statistics;
+        fs::File _file;
+        Header _header = {};
+        uint32_t _frame = 0;
+        uint16_t _length = 0;
+        uint16_t _position = 0;
+        uint8_t _buffer[CONFIG_THINGY_LED_ANIMATION_READAHEAD];
+    };
+  } // namespace LedAnimation
+} // namespace Soylent
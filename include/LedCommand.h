@@ -0,0 +1,58 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+/*
+ * Copyright (C) 2025 Robert Wendlandt
+ */
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#define LED_COMMAND_MAGIC   0x4C // 'L'
+#define LED_COMMAND_VERSION 1
+
+namespace Soylent {
+  // Compact binary LED command (and reply), alternative to the JSON-API
+  // fixed little-endian layout, 4 bytes on the wire
+  // commands on /led/ws don't pass admission (the socket takes over its connection), they are rate limited
+  // per client like any other request (see WebServerClass::admitMessage()), unlike PUT /led/command
+  struct __attribute__((packed)) LedCommand {
+      enum Opcode : uint8_t {
+        GET_STATE = 0,
+        SET_STATE = 1
+      };
+
+      enum Status : uint8_t {
+        OK = 0,
+        BAD_REQUEST = 1,
+        OUT_OF_BOUNDS = 2,
+        UNAVAILABLE = 3,
+        RATE_LIMITED = 4
+      };
+
+      uint8_t magic;
+      uint8_t version;
+      // opcode in commands, status in replies
+      uint8_t code;
+      uint8_t stateIdx;
+
+      /// Interpret received bytes as command (in place)
+      /// @return nullptr when not a valid command
+      static const LedCommand* decode(const uint8_t* data, size_t len) {
+        if (len != sizeof(LedCommand)) {
+          return nullptr;
+        }
+        auto command = reinterpret_cast<const LedCommand*>(data);
+        if (command->magic != LED_COMMAND_MAGIC || command->version != LED_COMMAND_VERSION) {
+          return nullptr;
+        }
+        return command;
+      }
+
+      /// Assemble a reply
+      constexpr inline __attribute__((always_inline)) LedCommand(Status status, uint8_t stateIdx)
+          : magic(LED_COMMAND_MAGIC), version(LED_COMMAND_VERSION), code(status), stateIdx(stateIdx) {
+      }
+  };
+
+  static_assert(sizeof(LedCommand) == 4, "LedCommand must be 4 bytes on the wire");
+} // namespace Soylent
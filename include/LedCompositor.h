@@ -0,0 +1,74 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+/*
+ * Copyright (C) 2025 Robert Wendlandt
+ */
+#pragma once
+
+#include <FastLED.h>
+#include <PixelKernels.h>
+
+// number of layers on top of the LED state (e.g. notifications)
+#ifndef CONFIG_THINGY_LED_LAYERS
+  #define CONFIG_THINGY_LED_LAYERS 4
+#endif
+
+namespace Soylent {
+  namespace LedCompositor {
+    enum class BlendMode : uint8_t {
+      ALPHA = 0,
+      ADD = 1,
+      MULTIPLY = 2,
+      SCREEN = 3
+    };
+
+    // a layer shows one of the LED states (see LedClass::LedState)
+    struct Layer {
+        // LedClass::LedState, NONE (-1) if the layer is unused
+        int8_t ledState;
+        uint8_t hue;
+        uint8_t opacity;
+        BlendMode blendMode;
+        uint32_t timeConstant;
+        // millis() when the layer is removed again, 0 for never
+        uint32_t until;
+    };
+
+    struct LayerStack {
+        Layer layers[CONFIG_THINGY_LED_LAYERS];
+        // statistics of composited frames (rendering and showing them)
+        volatile uint32_t frames;
+        volatile uint32_t frameTimeSum;
+        volatile uint32_t frameTimeMax;
+    };
+
+    // Blend the pixels of a layer onto the ones below (8-bit fixed point)
+    static inline void blend(CRGB* below, const CRGB* layer, uint16_t count, uint8_t opacity, BlendMode blendMode) {
+      // keep the switch out of the pixel loop
+      switch (blendMode) {
+        case BlendMode::ADD:
+          for (uint16_t i = 0; i < count; i++) {
+            for (uint8_t c = 0; c < 3; c++) {
+              below[i].raw[c] = qadd8(below[i].raw[c], scale8(layer[i].raw[c], opacity));
+            }
+          }
+          break;
+        case BlendMode::MULTIPLY:
+          for (uint16_t i = 0; i < count; i++) {
+            for (uint8_t c = 0; c < 3; c++) {
+              below[i].raw[c] = blend8(below[i].raw[c], scale8(below[i].raw[c], layer[i].raw[c]), opacity);
+            }
+          }
+          break;
+        case BlendMode::SCREEN:
+          for (uint16_t i = 0; i < count; i++) {
+            for (uint8_t c = 0; c < 3; c++) {
+              below[i].raw[c] = blend8(below[i].raw[c], 255 - scale8(255 - below[i].raw[c], 255 - layer[i].raw[c]), opacity);
+            }
+          }
+          break;
+        default:
+          Soylent::PixelKernels::Selected::blend(below, layer, count, opacity);
+      }
+    }
+  } // namespace LedCompositor
+} // namespace Soylent
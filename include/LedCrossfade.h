@@ -0,0 +1,69 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+/*
+ * Copyright (C) 2025 Robert Wendlandt
+ */
+#pragma once
+
+#include <cstdint>
+
+// duration of the crossfade between two LED states (in ms, 0 to switch at once)
+#ifndef CONFIG_THINGY_LED_TRANSITION_TIME
+  #define CONFIG_THINGY_LED_TRANSITION_TIME 400
+#endif
+
+// frames per second rendered during a crossfade
+#ifndef CONFIG_THINGY_LED_FRAME_RATE
+  #define CONFIG_THINGY_LED_FRAME_RATE 50
+#endif
+
+namespace Soylent {
+  namespace LedCrossfade {
+    // When the frames of a crossfade are due and how far they blend over to the new state, in ticks of any clock
+    // (frames are counted from the start, so rendering time doesn't add up)
+    class Timeline {
+      public:
+        Timeline(uint32_t start, uint32_t duration, uint32_t frameTicks) : _start(start), _duration(duration), _frameTicks(frameTicks > 0 ? frameTicks : 1) {}
+
+        // frames shown when none is late
+        static constexpr uint32_t framesOf(uint32_t duration, uint32_t frameTicks) {
+          return (duration + frameTicks - 1) / frameTicks;
+        }
+
+        bool isRunning(uint32_t now) const {
+          return now - _start < _duration;
+        }
+
+        // blend amount of the new state (as blend8) for a frame rendered at now, from 0 to 255 at the end
+        uint8_t amountAt(uint32_t now) const {
+          uint32_t elapsed = now - _start;
+          return elapsed < _duration ? static_cast<uint64_t>(elapsed) * 255 / _duration : 255;
+        }
+
+        // a frame was shown at now, returns the ticks to wait for the next one
+        uint32_t next(uint32_t now) {
+          _frames++;
+          int32_t wait = static_cast<int32_t>(_start + _frames * _frameTicks - now);
+          if (wait < 0) {
+            _late++;
+            return 0;
+          }
+          return wait;
+        }
+
+        uint32_t getFrames() const {
+          return _frames;
+        }
+
+        uint32_t getLate() const {
+          return _late;
+        }
+
+      private:
+        uint32_t _start;
+        uint32_t _duration;
+        uint32_t _frameTicks;
+        uint32_t _frames = 0;
+        uint32_t _late = 0;
+    };
+  } // namespace LedCrossfade
+} // namespace Soylent
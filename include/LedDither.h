@@ -0,0 +1,125 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+/*
+ * Copyright (C) 2025 Robert Wendlandt
+ */
+#pragma once
+
+#include <FastLED.h>
+
+// temporal dithering of outputs supporting it (see LedOutput.h), 0 to switch it off
+#ifndef CONFIG_THINGY_LED_DITHER
+  #define CONFIG_THINGY_LED_DITHER 1
+#endif
+
+// frames per second shown while dithering, in between the steps of an effect
+#ifndef CONFIG_THINGY_LED_DITHER_RATE
+  #define CONFIG_THINGY_LED_DITHER_RATE 200
+#endif
+
+namespace Soylent {
+  namespace LedDither {
+    // Shows 16-bit intensities on 8-bit outputs, by carrying over what was cut off to the next frame
+    // over 256 frames the sum of the 8-bit values shown is exactly the 16-bit intensity
+    class Dither {
+      public:
+        void reset() {
+          memset(_error, 0, sizeof(_error));
+          _uniform = true;
+          _fractional = false;
+          _steady = false;
+          _frames = 0;
+          _frameTimeSum = 0;
+          _frameTimeMax = 0;
+        }
+
+        // all pixels are showing the same color, scaled per channel and by a brightness
+        void setTarget(const CRGB& color, const CRGB& adjustment, uint8_t brightness) {
+          _uniform = true;
+          _fractional = _setTarget(0, color, adjustment, brightness);
+        }
+
+        void setTarget(const CRGB* pixels, const CRGB& adjustment, uint8_t brightness) {
+          _uniform = false;
+          _fractional = false;
+          for (uint16_t i = 0; i < CONFIG_THINGY_LED_COUNT; i++) {
+            _fractional |= _setTarget(i, pixels[i], adjustment, brightness);
+          }
+        }
+
+        // is there anything in between two 8-bit values to be dithered?
+        bool isFractional() const {
+          return _fractional;
+        }
+
+        // the LED task is done but for dithering what it has shown last (so the LED isn't animated)
+        void setSteady(bool steady) {
+          _steady = steady;
+        }
+
+        bool isSteady() const {
+          return _steady;
+        }
+
+        // all pixels of the frame are the same (only the first one is valid then)
+        bool isUniform() const {
+          return _uniform;
+        }
+
+        // put the next 8-bit frame to show into frame (just the first pixel, if uniform)
+        void next(CRGB* frame) {
+          uint16_t count = _uniform ? 1 : CONFIG_THINGY_LED_COUNT;
+          for (uint16_t i = 0; i < count; i++) {
+            for (uint8_t c = 0; c < 3; c++) {
+              // can't overflow: the target is at most 255 * 256
+              uint16_t value = _target[i][c] + _error[i][c];
+              frame[i].raw[c] = value >> 8;
+              _error[i][c] = value;
+            }
+          }
+        }
+
+        // time taken for dithering a frame and handing it over to the output (in us)
+        void account(uint32_t frameTime) {
+          _frameTimeSum += frameTime;
+          if (frameTime > _frameTimeMax) {
+            _frameTimeMax = frameTime;
+          }
+          _frames++;
+        }
+
+        uint32_t getFrames() const {
+          return _frames;
+        }
+
+        uint32_t getFrameTimeAvg() const {
+          uint32_t frames = _frames;
+          return frames ? _frameTimeSum / frames : 0;
+        }
+
+        uint32_t getFrameTimeMax() const {
+          return _frameTimeMax;
+        }
+
+      private:
+        // returns true, if the target of the pixel is in between two 8-bit values
+        bool _setTarget(uint16_t i, const CRGB& color, const CRGB& adjustment, uint8_t brightness) {
+          uint8_t fraction = 0;
+          for (uint8_t c = 0; c < 3; c++) {
+            _target[i][c] = (static_cast<uint32_t>(color.raw[c]) * (adjustment.raw[c] + 1) * (brightness + 1)) >> 8;
+            fraction |= _target[i][c] & 0xFF;
+          }
+          return fraction != 0;
+        }
+
+        uint16_t _target[CONFIG_THINGY_LED_COUNT][3];
+        uint8_t _error[CONFIG_THINGY_LED_COUNT][3];
+        bool _uniform = true;
+        bool _fractional = false;
+        volatile bool _steady = false;
+        // statistics
+        volatile uint32_t _frames = 0;
+        volatile uint32_t _frameTimeSum = 0;
+        volatile uint32_t _frameTimeMax = 0;
+    };
+  } // namespace LedDither
+} // namespace Soylent
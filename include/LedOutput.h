@@ -0,0 +1,183 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+/*
+ * Copyright (C) 2025 Robert Wendlandt
+ */
+#pragma once
+
+#include <FastLED.h>
+#include <LedDither.h>
+#include <LedGamma.h>
+#include <algorithm>
+
+// Output policies of the LED, selected at compile time via CONFIG_THINGY_LED_OUTPUT
+#define LED_OUTPUT_NONE  0
+#define LED_OUTPUT_MONO  1
+#define LED_OUTPUT_RGB   2
+#define LED_OUTPUT_STRIP 3
+#define LED_OUTPUT_PWM   4
+
+// default to what the board has on-board
+#ifndef CONFIG_THINGY_LED_OUTPUT
+  #if defined(RGB_BUILTIN)
+    #define CONFIG_THINGY_LED_OUTPUT LED_OUTPUT_RGB
+  #elif defined(LED_BUILTIN)
+    #define CONFIG_THINGY_LED_OUTPUT LED_OUTPUT_PWM
+  #else
+    #define CONFIG_THINGY_LED_OUTPUT LED_OUTPUT_NONE
+  #endif
+#endif
+
+// PWM frequency of a dimmable LED (in Hz)
+#ifndef CONFIG_THINGY_LED_PWM_FREQUENCY
+  #define CONFIG_THINGY_LED_PWM_FREQUENCY 5000
+#endif
+
+// duration of soft transitions of a dimmable LED (in ms)
+#ifndef CONFIG_THINGY_LED_FADE_TIME
+  #define CONFIG_THINGY_LED_FADE_TIME 150
+#endif
+
+#ifndef CONFIG_THINGY_LED_PIN
+  #ifdef LED_BUILTIN
+    #define CONFIG_THINGY_LED_PIN LED_BUILTIN
+  #else
+    #define CONFIG_THINGY_LED_PIN 0
+  #endif
+#endif
+
+namespace Soylent {
+  namespace LedOutput {
+    // Every policy is providing:
+    //   present - is there anything to output to at all?
+    //   rgb      - can it show colors (otherwise only the brightness is used)?
+    //   dimmable - can it fade between brightnesses on its own (otherwise fading just switches)?
+    //   dither   - is it worth dithering in time (see LedDither.h)?
+    //   begin()  - set up the output
+    //   fill()   - show one color on all pixels (scaled by brightness)
+    //   show()   - show the pixels of a frame buffer (scaled by brightness)
+    //   level()  - brightness last shown (only kept track of when dimmable)
+    //   fade()   - start fading from level() to another brightness, returns immediately
+
+    // No LED at all
+    struct None {
+        static constexpr bool present = false;
+        static constexpr bool rgb = false;
+        static constexpr bool dimmable = false;
+        static constexpr bool dither = false;
+        static inline void begin(__unused uint8_t pin) {}
+        static inline void fill(__unused uint8_t pin, __unused const CRGB& color, __unused uint8_t brightness = 255) {}
+        static inline void show(__unused uint8_t pin, __unused const CRGB* pixels, __unused uint16_t count, __unused uint8_t brightness = 255) {}
+        static inline uint8_t level() { return 0; }
+        static inline void fade(__unused uint8_t pin, __unused uint8_t to, __unused uint32_t duration) {}
+    };
+
+    // Plain LED on a GPIO, either on or off
+    struct Mono {
+        static constexpr bool present = true;
+        static constexpr bool rgb = false;
+        static constexpr bool dimmable = false;
+        static constexpr bool dither = false;
+        static inline void begin(uint8_t pin) {
+          pinMode(pin, OUTPUT);
+        }
+        static inline void fill(uint8_t pin, const CRGB& color, uint8_t brightness = 255) {
+          digitalWrite(pin, scale8(color.getLuma(), brightness) > 127 ? HIGH : LOW);
+        }
+        static inline void show(uint8_t pin, const CRGB* pixels, __unused uint16_t count, uint8_t brightness = 255) {
+          fill(pin, pixels[0], brightness);
+        }
+        static inline uint8_t level() { return 0; }
+        static inline void fade(uint8_t pin, uint8_t to, __unused uint32_t duration) {
+          fill(pin, CRGB(to, to, to));
+        }
+    };
+
+    // Single (on-board) RGB-LED
+    struct RGB {
+        static constexpr bool present = true;
+        static constexpr bool rgb = true;
+        static constexpr bool dimmable = false;
+        static constexpr bool dither = CONFIG_THINGY_LED_DITHER != 0;
+        static inline void begin(__unused uint8_t pin) {}
+        static inline void fill(uint8_t pin, const CRGB& color, uint8_t brightness = 255) {
+          rgbLedWrite(pin, scale8(color.red, brightness), scale8(color.green, brightness), scale8(color.blue, brightness));
+        }
+        static inline void show(uint8_t pin, const CRGB* pixels, __unused uint16_t count, uint8_t brightness = 255) {
+          fill(pin, pixels[0], brightness);
+        }
+        static inline uint8_t level() { return 0; }
+        static inline void fade(uint8_t pin, uint8_t to, __unused uint32_t duration) {
+          fill(pin, CRGB(to, to, to));
+        }
+    };
+
+#if CONFIG_THINGY_LED_OUTPUT == LED_OUTPUT_STRIP
+    // WS2812B-strip of CONFIG_THINGY_LED_COUNT pixels on CONFIG_THINGY_LED_PIN
+    struct Strip {
+        static constexpr bool present = true;
+        static constexpr bool rgb = true;
+        static constexpr bool dimmable = false;
+        static constexpr bool dither = CONFIG_THINGY_LED_DITHER != 0;
+        static inline CRGB pixels[CONFIG_THINGY_LED_COUNT];
+        static inline void begin(__unused uint8_t pin) {
+          FastLED.addLeds<WS2812B, CONFIG_THINGY_LED_PIN, GRB>(pixels, CONFIG_THINGY_LED_COUNT);
+        }
+        static inline void fill(__unused uint8_t pin, const CRGB& color, uint8_t brightness = 255) {
+          fill_solid(pixels, CONFIG_THINGY_LED_COUNT, color);
+          FastLED.show(brightness);
+        }
+        static inline void show(__unused uint8_t pin, const CRGB* frame, uint16_t count, uint8_t brightness = 255) {
+          memcpy(pixels, frame, sizeof(CRGB) * std::min<uint16_t>(count, CONFIG_THINGY_LED_COUNT));
+          FastLED.show(brightness);
+        }
+        static inline uint8_t level() { return 0; }
+        static inline void fade(uint8_t pin, uint8_t to, __unused uint32_t duration) {
+          fill(pin, CRGB(to, to, to));
+        }
+    };
+#endif
+
+    // Dimmable LED on a PWM-capable GPIO, gamma-corrected and faded by the LEDC hardware
+    struct PWM {
+        static constexpr bool present = true;
+        static constexpr bool rgb = false;
+        static constexpr bool dimmable = true;
+        // the 12-bit duty is fine enough already
+        static constexpr bool dither = false;
+        static inline volatile uint8_t brightness = 0;
+        static inline void begin(uint8_t pin) {
+          ledcAttach(pin, CONFIG_THINGY_LED_PWM_FREQUENCY, LED_GAMMA_RESOLUTION);
+          brightness = 0;
+        }
+        static inline void fill(uint8_t pin, const CRGB& color, uint8_t scale = 255) {
+          brightness = scale8(color.getLuma(), scale);
+          ledcWrite(pin, LedGamma::table[brightness]);
+        }
+        static inline void show(uint8_t pin, const CRGB* pixels, __unused uint16_t count, uint8_t scale = 255) {
+          fill(pin, pixels[0], scale);
+        }
+        static inline uint8_t level() { return brightness; }
+        // the duty is ramped linearly, so longer fades are better split into a few segments
+        static inline void fade(uint8_t pin, uint8_t to, uint32_t duration) {
+          if (duration == 0 || to == brightness) {
+            fill(pin, CRGB(to, to, to));
+            return;
+          }
+          ledcFade(pin, LedGamma::table[brightness], LedGamma::table[to], duration);
+          brightness = to;
+        }
+    };
+
+#if CONFIG_THINGY_LED_OUTPUT == LED_OUTPUT_MONO
+    typedef Mono Selected;
+#elif CONFIG_THINGY_LED_OUTPUT == LED_OUTPUT_RGB
+    typedef RGB Selected;
+#elif CONFIG_THINGY_LED_OUTPUT == LED_OUTPUT_STRIP
+    typedef Strip Selected;
+#elif CONFIG_THINGY_LED_OUTPUT == LED_OUTPUT_PWM
+    typedef PWM Selected;
+#else
+    typedef None Selected;
+#endif
+  } // namespace LedOutput
+} // namespace Soylent
@@ -0,0 +1,249 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+/*
+ * Copyright (C) 2025 Robert Wendlandt
+ */
+#pragma once
+
+#include <Arduino.h>
+#include <FastLED.h>
+#include <LatencyHistogram.h>
+#include <atomic>
+
+// render and output the LEDs in separate tasks (rendering goes on while the output waits for the hardware)
+#ifndef CONFIG_THINGY_LED_PIPELINE
+  #ifdef CONFIG_FREERTOS_UNICORE
+    #define CONFIG_THINGY_LED_PIPELINE 0
+  #else
+    #define CONFIG_THINGY_LED_PIPELINE 1
+  #endif
+#endif
+
+// core of the render stage (effects, layers, crossfades, dithering), away from AsyncTCP (see CONFIG_ASYNC_TCP_RUNNING_CORE)
+// so neither a burst of requests delays the frames nor an effect the requests
+#ifndef CONFIG_THINGY_LED_RENDER_CORE
+  #if defined(CONFIG_ASYNC_TCP_RUNNING_CORE) && CONFIG_ASYNC_TCP_RUNNING_CORE == 0
+    #define CONFIG_THINGY_LED_RENDER_CORE 1
+  #else
+    #define CONFIG_THINGY_LED_RENDER_CORE 0
+  #endif
+#endif
+
+// core of the output stage, the other one (rendering goes on there while the output waits for the hardware)
+#ifndef CONFIG_THINGY_LED_OUTPUT_CORE
+  #define CONFIG_THINGY_LED_OUTPUT_CORE (1 - CONFIG_THINGY_LED_RENDER_CORE)
+#endif
+// priority of the output stage, above AsyncTCP (which it shares its core with by default), it mostly waits anyway
+#ifndef CONFIG_THINGY_LED_OUTPUT_PRIORITY
+  #ifdef CONFIG_ASYNC_TCP_PRIORITY
+    #define CONFIG_THINGY_LED_OUTPUT_PRIORITY (CONFIG_ASYNC_TCP_PRIORITY + 1)
+  #else
+    #define CONFIG_THINGY_LED_OUTPUT_PRIORITY 11
+  #endif
+#endif
+
+namespace Soylent {
+  namespace LedPipeline {
+    // a frame as it is shipped to the output
+    struct Frame {
+        CRGB pixels[CONFIG_THINGY_LED_COUNT];
+        uint8_t brightness;
+        // only the first pixel is valid, it's shown on all of them
+        bool uniform;
+        // micros() when the command this frame is the first response to arrived, 0 for any other frame
+        uint32_t commandAt;
+    };
+
+    // The render stage writes the back frame while the output stage shows the front frame,
+    // a third one is handed over in between. Frames are swapped lock-free, so neither stage ever waits for the other.
+    class Pipeline {
+      public:
+        void reset() {
+          _back = 0;
+          _ready.store(1);
+          _front = 2;
+          _expectedAt = 0;
+          _frames = 0;
+          _dropped = 0;
+          _scheduled = 0;
+          _jitterSum = 0;
+          _jitterMax = 0;
+          _previewing = false;
+          _previewSequence = 0;
+          _commanded.store(0);
+          _armed.store(0);
+          _firstShownAt = 0;
+        }
+
+        // where the render stage puts its next frame
+        Frame* back() {
+          return &_slots[_back];
+        }
+
+        // hand the back frame over to the output stage (and wake it up)
+        void publish() {
+          uint32_t previous = _ready.exchange(_back | FRESH);
+          if (previous & FRESH) {
+            // the output stage didn't even get to see it
+            _dropped++;
+          }
+          _back = previous & INDEX;
+
+          if (_consumer != nullptr) {
+            xTaskNotifyGive(_consumer);
+          }
+        }
+
+        // take the latest frame published, nullptr if there is none
+        const Frame* acquire() {
+          if (!(_ready.load() & FRESH)) {
+            return nullptr;
+          }
+          _front = _ready.exchange(_front) & INDEX;
+          return &_slots[_front];
+        }
+
+        void setConsumer(TaskHandle_t consumer) {
+          _consumer = consumer;
+        }
+
+        // the render stage is scheduled to show its next frame at micros()
+        void expect(uint32_t at) {
+          _expectedAt = at;
+        }
+
+        // a command changing what's shown arrived at micros()
+        void command(uint32_t at) {
+          _commanded.store(at);
+        }
+
+        // the LED task carrying out the latest command has taken over, its next frame is the response to it
+        void takeOver() {
+          _armed.store(_commanded.exchange(0));
+        }
+
+        // when the command answered by the next frame arrived (0 if there is none), by the render stage
+        uint32_t stamp() {
+          return _armed.load() != 0 ? _armed.exchange(0) : 0;
+        }
+
+        // the response to a command was shown without a frame (e.g. a dimmable LED starting to fade)
+        void shownDirectly(uint32_t at) {
+          if (_firstShownAt == 0) {
+            _firstShownAt = at;
+          }
+          uint32_t commandAt = stamp();
+          if (commandAt != 0) {
+            _commandLatency.record(at - commandAt);
+          }
+        }
+
+        // from a command arriving until its response was shown
+        LatencyHistogram& getCommandLatency() {
+          return _commandLatency;
+        }
+
+        // when the very first frame was shown (0 if none was shown yet)
+        uint32_t getFirstShownAt() {
+          return _firstShownAt;
+        }
+
+        // keep a copy of every frame shown for the live preview (it's not for free)
+        void setPreview(bool enabled) {
+          _previewing = enabled;
+        }
+
+        // copy of the latest frame shown, returns its sequence number (changing with every frame)
+        uint32_t getPreview(Frame* copy) {
+          taskENTER_CRITICAL(&_previewLock);
+          memcpy(copy, &_preview, sizeof(Frame));
+          uint32_t sequence = _previewSequence;
+          taskEXIT_CRITICAL(&_previewLock);
+          return sequence;
+        }
+
+        // a frame was shown at micros(), account for how far off it was from its schedule
+        void shown(const Frame* frame, uint32_t at) {
+          if (_previewing) {
+            taskENTER_CRITICAL(&_previewLock);
+            memcpy(&_preview, frame, sizeof(Frame));
+            _previewSequence++;
+            taskEXIT_CRITICAL(&_previewLock);
+          }
+
+          if (_firstShownAt == 0) {
+            _firstShownAt = at;
+          }
+          if (frame->commandAt != 0) {
+            _commandLatency.record(at - frame->commandAt);
+          }
+
+          uint32_t expectedAt = _expectedAt;
+          if (expectedAt != 0) {
+            _expectedAt = 0;
+            int32_t jitter = static_cast<int32_t>(at - expectedAt);
+            uint32_t absJitter = jitter < 0 ? -jitter : jitter;
+            _jitterSum += absJitter;
+            if (absJitter > _jitterMax) {
+              _jitterMax = absJitter;
+            }
+            _scheduled++;
+          }
+          _frames++;
+        }
+
+        uint32_t getFrames() const {
+          return _frames;
+        }
+
+        uint32_t getDropped() const {
+          return _dropped;
+        }
+
+        // frames shown on a schedule (the others are shown as soon as possible, e.g. streamed ones)
+        uint32_t getScheduled() const {
+          return _scheduled;
+        }
+
+        uint32_t getJitterSum() const {
+          return _jitterSum;
+        }
+
+        uint32_t getJitterAvg() const {
+          uint32_t scheduled = _scheduled;
+          return scheduled ? _jitterSum / scheduled : 0;
+        }
+
+        uint32_t getJitterMax() const {
+          return _jitterMax;
+        }
+
+      private:
+        static constexpr uint32_t INDEX = 0x03;
+        static constexpr uint32_t FRESH = 0x04;
+
+        Frame _slots[3];
+        uint32_t _back = 0;
+        // index of the frame in between, FRESH until it's taken by the output stage
+        std::atomic<uint32_t> _ready{1};
+        uint32_t _front = 2;
+        TaskHandle_t _consumer = nullptr;
+        // the latest frame shown, while previewing
+        Frame _preview = {};
+        volatile bool _previewing = false;
+        uint32_t _previewSequence = 0;
+        portMUX_TYPE _previewLock = portMUX_INITIALIZER_UNLOCKED;
+        // arrival of the latest command, until its LED task takes over (and stamps its first frame with it)
+        std::atomic<uint32_t> _commanded{0};
+        std::atomic<uint32_t> _armed{0};
+        LatencyHistogram _commandLatency;
+        volatile uint32_t _firstShownAt = 0;
+        // statistics
+        volatile uint32_t _expectedAt = 0;
+        volatile uint32_t _frames = 0;
+        volatile uint32_t _dropped = 0;
+        volatile uint32_t _scheduled = 0;
+        volatile uint32_t _jitterSum = 0;
+        volatile uint32_t _jitterMax = 0;
+    };
+  } // namespace LedPipeline
+} // namespace Soylent
@@ -0,0 +1,140 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+/*
+ * Copyright (C) 2025 Robert Wendlandt
+ */
+#pragma once
+
+#include <FastLED.h>
+
+// current the LEDs may draw (in mA, 0 for no limit)
+#ifndef CONFIG_THINGY_LED_POWER_BUDGET
+  #define CONFIG_THINGY_LED_POWER_BUDGET 0
+#endif
+
+// current of a single channel (r, g or b) at full brightness (in mA)
+#ifndef CONFIG_THINGY_LED_CHANNEL_CURRENT
+  #define CONFIG_THINGY_LED_CHANNEL_CURRENT 20
+#endif
+
+// current of a pixel even when it's dark (in mA)
+#ifndef CONFIG_THINGY_LED_IDLE_CURRENT
+  #define CONFIG_THINGY_LED_IDLE_CURRENT 1
+#endif
+
+namespace Soylent {
+  namespace LedPower {
+    // Estimates the current drawn by the pixels and the brightness keeping it within the budget
+    // only changed pixels are accounted for, a single color for all of them is O(1)
+    class Budget {
+      public:
+        void reset() {
+          _uniform = true;
+          _uniformSum = 0;
+          _total = 0;
+          _estimates = 0;
+          _limited = 0;
+          _updateTimeSum = 0;
+          _updateTimeMax = 0;
+          _updates = 0;
+        }
+
+        // all pixels are showing the same color
+        void fill(const CRGB& color) {
+          _uniform = true;
+          _uniformSum = _sum(color);
+          _total = static_cast<uint32_t>(_uniformSum) * CONFIG_THINGY_LED_COUNT;
+          _estimates++;
+        }
+
+        // the sums of the pixels don't match what's shown any more (e.g. other pixels are taken over)
+        void invalidate() {
+          _uniform = true;
+        }
+
+        // the pixels [first, first + count) might have changed
+        // (the first update after a single color, or after invalidate(), accounts for all of them)
+        void update(const CRGB* pixels, uint16_t first, uint16_t count) {
+          uint32_t startedAt = micros();
+          if (_uniform) {
+            // the sums of all pixels are needed from now on, none of them is known yet
+            // (the pixels outside the range might not show the single color any more)
+            memset(_sums, 0, sizeof(_sums));
+            _total = 0;
+            first = 0;
+            count = CONFIG_THINGY_LED_COUNT;
+            _uniform = false;
+          }
+
+          for (uint16_t i = first; i < first + count && i < CONFIG_THINGY_LED_COUNT; i++) {
+            uint16_t sum = _sum(pixels[i]);
+            _total += sum - _sums[i];
+            _sums[i] = sum;
+          }
+          _estimates++;
+
+          uint32_t updateTime = micros() - startedAt;
+          _updateTimeSum += updateTime;
+          if (updateTime > _updateTimeMax) {
+            _updateTimeMax = updateTime;
+          }
+          _updates++;
+        }
+
+        // estimated current at full brightness (in mA)
+        uint32_t getMilliamps() const {
+          return CONFIG_THINGY_LED_IDLE_CURRENT * CONFIG_THINGY_LED_COUNT + static_cast<uint64_t>(_total) * CONFIG_THINGY_LED_CHANNEL_CURRENT / 255;
+        }
+
+        // brightness (as scale8) keeping the current within the budget
+        uint8_t getBrightness() {
+          if constexpr (CONFIG_THINGY_LED_POWER_BUDGET == 0) {
+            return 255;
+          }
+
+          constexpr uint32_t idle = CONFIG_THINGY_LED_IDLE_CURRENT * CONFIG_THINGY_LED_COUNT;
+          constexpr uint32_t available = CONFIG_THINGY_LED_POWER_BUDGET > idle ? CONFIG_THINGY_LED_POWER_BUDGET - idle : 0;
+          uint32_t channels = static_cast<uint64_t>(_total) * CONFIG_THINGY_LED_CHANNEL_CURRENT / 255;
+          if (channels <= available) {
+            return 255;
+          }
+
+          _limited++;
+          return static_cast<uint64_t>(available) * 255 / channels;
+        }
+
+        uint32_t getEstimates() const {
+          return _estimates;
+        }
+
+        uint32_t getLimited() const {
+          return _limited;
+        }
+
+        // time taken for updating the estimate from a frame (in us)
+        uint32_t getUpdateTimeAvg() const {
+          uint32_t updates = _updates;
+          return updates ? _updateTimeSum / updates : 0;
+        }
+
+        uint32_t getUpdateTimeMax() const {
+          return _updateTimeMax;
+        }
+
+      private:
+        static inline uint16_t _sum(const CRGB& color) {
+          return color.red + color.green + color.blue;
+        }
+
+        uint16_t _sums[CONFIG_THINGY_LED_COUNT];
+        uint32_t _total = 0;
+        uint16_t _uniformSum = 0;
+        bool _uniform = true;
+        // statistics
+        volatile uint32_t _estimates = 0;
+        volatile uint32_t _limited = 0;
+        volatile uint32_t _updates = 0;
+        volatile uint32_t _updateTimeSum = 0;
+        volatile uint32_t _updateTimeMax = 0;
+    };
+  } // namespace LedPower
+} // namespace Soylent
@@ -0,0 +1,57 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+/*
+ * Copyright (C) 2025 Robert Wendlandt
+ */
+#pragma once
+
+#include <LedAnimation.h>
+
+// bring the LED back up as it was before a restart, 0 to always start with the LED off
+#ifndef CONFIG_THINGY_LED_RESUME
+  #define CONFIG_THINGY_LED_RESUME 1
+#endif
+
+#define LED_RESUME_MAGIC   0x4C52534D // 'LRSM'
+#define LED_RESUME_VERSION 1
+
+namespace Soylent {
+  namespace LedResume {
+    // where the LED state was resumed from
+    enum class Source : uint8_t {
+      NONE = 0,
+      // RTC memory: survives restarts and watchdog resets, but no power loss (the clock is resumed as well)
+      RTC = 1,
+      // NVS: survives anything, but is written lazily (see ConfigTask.h)
+      NVS = 2
+    };
+
+    struct __attribute__((packed)) Snapshot {
+        uint32_t magic;
+        uint8_t version;
+        // LedClass::LedState
+        int8_t ledState;
+        uint8_t hue;
+        uint8_t reserved;
+        uint32_t timeConstant;
+        // network time minus the time of day (in us), blinking and rainbow pick up where they were
+        int64_t clockOffset;
+        char animationPath[CONFIG_THINGY_LED_ANIMATION_PATH];
+        // of all of the above
+        uint32_t crc;
+    };
+
+    // Keeps the latest LED state in RTC memory right away and hands it to Config for NVS
+    // (a few LED changes in a row end up as a single write, or none when nothing changed in the end)
+    class Store {
+      public:
+        // RTC memory first, NVS after a power loss
+        Source load(Snapshot* snapshot);
+        // from the loop task
+        void save(const Snapshot& snapshot);
+
+      private:
+        static uint32_t _crcOf(const Snapshot& snapshot);
+        static bool _isValid(const Snapshot& snapshot);
+    };
+  } // namespace LedResume
+} // namespace Soylent
@@ -0,0 +1,51 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+/*
+ * Copyright (C) 2025 Robert Wendlandt
+ */
+#pragma once
+
+#include <AsyncUDP.h>
+#include <TaskSchedulerDeclarations.h>
+
+#define DDP_PORT  4048
+#define E131_PORT 5568
+
+namespace Soylent {
+  class LedStreamClass {
+    public:
+      enum class Protocol {
+        NONE = 0,
+        DDP = 1,
+        E131 = 2
+      };
+
+      LedStreamClass();
+      void begin(Scheduler* scheduler);
+      void end();
+      bool isStreaming();
+      Protocol getProtocol();
+      uint32_t getPacketsReceived();
+      uint32_t getPacketsDropped();
+
+    private:
+      void _watchdogCallback();
+      void _packetReceived(Protocol protocol);
+      void _onDDPPacket(AsyncUDPPacket& packet);
+      void _onE131Packet(AsyncUDPPacket& packet);
+      bool _acceptSequence(uint16_t& lastSequence, uint16_t sequence, uint16_t range);
+      void _writePixels(uint32_t offset, const uint8_t* data, size_t length);
+      Task* _watchdogTask;
+      Scheduler* _scheduler;
+      AsyncUDP _ddp;
+      AsyncUDP _e131;
+      volatile Protocol _protocol;
+      volatile uint32_t _lastPacketAt;
+      volatile uint32_t _packetsReceived;
+      volatile uint32_t _packetsDropped;
+      // (each protocol counts on its own)
+      uint16_t _lastDdpSequence;
+      uint16_t _lastE131Sequence;
+      bool _streaming;
+      LedClass::LedState _previousLedState;
+  };
+} // namespace Soylent
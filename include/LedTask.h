@@ -6,11 +6,25 @@
 
 #include <TaskSchedulerDeclarations.h>
 #include <FastLED.h>
+#include <LedAnimation.h>
+#include <LedCompositor.h>
+#include <LedCrossfade.h>
+#include <LedDither.h>
+#include <LedOutput.h>
+#include <LedPipeline.h>
+#include <LedPower.h>
+#include <LedResume.h>
+#include <PixelKernels.h>
 
 // plain simple led-states (off/on/blink) more might be added from led_states.json
 #define LED_STATES_PLAIN   3
 #define TERMINATE_YOURSELF 1
 
+// number of pixels in the frame buffer (the on-board LED is just one)
+#ifndef CONFIG_THINGY_LED_COUNT
+  #define CONFIG_THINGY_LED_COUNT 1
+#endif
+
 namespace Soylent {
   class LedClass {
     public:
@@ -20,18 +34,82 @@ namespace Soylent {
         ON = 1,
         BLINK = 2,
         // defined here, but is only useful for RGB-LEDs
-        RAINBOW = 3
+        RAINBOW = 3,
+        // pixels are pushed into the frame buffer from outside (e.g. DDP / E1.31)
+        STREAM = 4,
+        // frames are played from an animation file (see LedAnimation.h)
+        PLAYBACK = 5
+      };
+
+      // frame buffer for pixels coming from external sources
+      struct FrameBuffer {
+          CRGB pixels[CONFIG_THINGY_LED_COUNT];
+          // given whenever a new frame is ready to be shown
+          SemaphoreHandle_t ready;
+          // micros() when the latest frame was pushed
+          volatile uint32_t pushedAt;
+          // statistics, updated when a frame is shown
+          volatile uint32_t shown;
+          volatile uint32_t latencySum;
+          volatile uint32_t latencyMax;
+          // pixels [changedFirst, changedEnd) were changed since the last frame shown
+          volatile uint16_t changedFirst;
+          volatile uint16_t changedEnd;
       };
 
+      // the output is chosen at compile time (see LedOutput.h)
+      typedef Soylent::LedOutput::Selected Output;
+      // as are the pixel kernels (see PixelKernels.h)
+      typedef Soylent::PixelKernels::Selected Kernels;
+      // frames are shown by an output task of their own (see LedPipeline.h)
+      // a dimmable LED is just a register write away, and it's fading on its own
+      static constexpr bool pipelined = CONFIG_THINGY_LED_PIPELINE && Output::present && !Output::dimmable;
+      // stack of the LED task, with room for the frames rendered while crossfading or compositing (and for playing animations)
+      static constexpr uint32_t taskStackSize = CONFIG_THINGY_TASKS_STACK_SIZE + 3 * sizeof(CRGB) * CONFIG_THINGY_LED_COUNT +
+                                                sizeof(Soylent::LedCompositor::Layer) * CONFIG_THINGY_LED_LAYERS + sizeof(Soylent::LedAnimation::Player) +
+                                                CONFIG_THINGY_LED_ANIMATION_PATH;
+
       LedClass();
-      LedClass(uint8_t LED_Pin, bool is_RGB);
+      explicit LedClass(uint8_t LED_Pin);
       void begin(Scheduler* scheduler);
       void end();
-      void setLedState(LedState ledState);
+      // commandAt: micros() the command arrived, to account for the latency until it's shown
+      void setLedState(LedState ledState, uint32_t commandAt = 0);
       LedState getLedState();
       bool isInitialized();
       bool isBusy();
       bool isAnimated();
+      // nothing changes on the LED by itself (light sleep wouldn't disturb it)
+      bool isStatic();
+      CRGB* getFrameBuffer();
+      uint16_t getFrameBufferSize();
+      void showFrame();
+      void frameChanged(uint16_t first, uint16_t count);
+      const Soylent::LedPower::Budget& getPowerBudget();
+      const Soylent::LedDither::Dither& getDither();
+      Soylent::LedPipeline::Pipeline& getPipeline();
+      uint32_t getFramesShown();
+      uint32_t getFrameLatencyAvg();
+      uint32_t getFrameLatencyMax();
+      void playAnimation(const char* path, uint32_t commandAt = 0);
+      const char* getAnimation();
+      const Soylent::LedAnimation::Statistics& getAnimationStatistics();
+      void setLayer(uint8_t layer, LedState ledState, uint8_t opacity, Soylent::LedCompositor::BlendMode blendMode, uint32_t duration = 0);
+      void clearLayer(uint8_t layer);
+      bool getLayer(uint8_t layer, Soylent::LedCompositor::Layer* copy);
+      uint32_t getLayerFrames();
+      uint32_t getLayerFrameTimeAvg();
+      uint32_t getLayerFrameTimeMax();
+      // least free stack of the LED task and of the output task since they were started (in bytes, -1 when not running)
+      int32_t getTaskStackHighWater();
+      int32_t getOutputTaskStackHighWater();
+      // keep the LED state as it is right now, with the clock (e.g. right before a restart)
+      void persist();
+      // where the LED state was resumed from after starting up (see LedResume.h)
+      Soylent::LedResume::Source getResumedFrom();
+      // micros() since start-up when the LED was initialized and when the first frame was shown (0 if not yet)
+      uint32_t getInitializedAt();
+      uint32_t getFirstShownAt();
 
     private:
       // struct for passing parameters to async LED tasks
@@ -39,43 +117,135 @@ namespace Soylent {
           struct {
               StatusRequest* srBusy;
               StatusRequest* srAnimated;
+              FrameBuffer* frameBuffer;
+              Soylent::LedCompositor::LayerStack* layerStack;
+              Soylent::LedPower::Budget* power;
+              Soylent::LedDither::Dither* dither;
+              Soylent::LedPipeline::Pipeline* pipeline;
+              Soylent::LedAnimation::Statistics* animation;
+              const char* animationPath;
               LedState ledState;
               uint8_t ledPin;
-              bool rgbLed;
               uint32_t timeConstant;
-              uint8_t hue; // still being ignored
+              uint8_t hue;
+              // what was shown before, to crossfade from
+              LedState previousState;
+              uint32_t previousTimeConstant;
+              uint8_t previousHue;
           };
 
           /// Default constructor
           /// @warning Default values are UNITIALIZED!
           constexpr inline __attribute__((always_inline)) LEDTaskParams()
-              : srBusy(nullptr), srAnimated(nullptr), ledState(LedState::NONE), ledPin(0), rgbLed(false), timeConstant(0), hue(0) {
+              : srBusy(nullptr),
+                srAnimated(nullptr),
+                frameBuffer(nullptr),
+                layerStack(nullptr),
+                power(nullptr),
+                dither(nullptr),
+                pipeline(nullptr),
+                animation(nullptr),
+                animationPath(nullptr),
+                ledState(LedState::NONE),
+                ledPin(0),
+                timeConstant(0),
+                hue(0),
+                previousState(LedState::NONE),
+                previousTimeConstant(0),
+                previousHue(0) {
           }
 
           /// Allow construction from values
           constexpr inline __attribute__((always_inline)) LEDTaskParams(StatusRequest* srBusy,
                                                                         StatusRequest* srAnimated,
+                                                                        FrameBuffer* frameBuffer,
+                                                                        Soylent::LedCompositor::LayerStack* layerStack,
+                                                                        Soylent::LedPower::Budget* power,
+                                                                        Soylent::LedDither::Dither* dither,
+                                                                        Soylent::LedPipeline::Pipeline* pipeline,
+                                                                        Soylent::LedAnimation::Statistics* animation,
+                                                                        const char* animationPath,
                                                                         LedState ledState,
                                                                         uint8_t ledPin,
-                                                                        bool rgbLed,
                                                                         uint32_t timeConstant,
-                                                                        uint8_t hue)
-              : srBusy(srBusy), srAnimated(srAnimated), ledState(ledState), ledPin(ledPin), rgbLed(rgbLed), timeConstant(timeConstant), hue(hue) {
+                                                                        uint8_t hue,
+                                                                        LedState previousState,
+                                                                        uint32_t previousTimeConstant,
+                                                                        uint8_t previousHue)
+              : srBusy(srBusy),
+                srAnimated(srAnimated),
+                frameBuffer(frameBuffer),
+                layerStack(layerStack),
+                power(power),
+                dither(dither),
+                pipeline(pipeline),
+                animation(animation),
+                animationPath(animationPath),
+                ledState(ledState),
+                ledPin(ledPin),
+                timeConstant(timeConstant),
+                hue(hue),
+                previousState(previousState),
+                previousTimeConstant(previousTimeConstant),
+                previousHue(previousHue) {
           }
       };
 
       void _initializeLedCallback();
-      void _setLedCallback();
+      void _resetFrameBuffer();
+      void _resetLayers();
+      void _setLedCallback(uint16_t traceId = 0);
+      void _restartLed();
+      void _resumeState();
+      void _saveState();
+      static uint32_t _timeConstantOf(LedState ledState);
       static void _async_setLedTask(void* pvParameters);
+      static void _exitTask();
+      void _stopTask();
+      static void _outputTask(void* pvParameters);
+      static void _output(uint8_t pin, const Soylent::LedPipeline::Frame* frame);
       static void _adjustLed(CRGB* led, const CRGB& adjustment);
+      static TickType_t _ticksUntilNextPeriod(uint32_t now, uint32_t timeConstant);
+      static bool _fadeLed(uint8_t pin, uint8_t to, uint32_t duration);
+      static bool _renderFrame(LedState ledState, uint32_t timeConstant, uint8_t hue, uint32_t now, const FrameBuffer* frameBuffer, CRGB* pixels);
+      static void _show(const LEDTaskParams& task_params, const CRGB* pixels, const CRGB& adjustment, uint16_t first = 0, uint16_t count = CONFIG_THINGY_LED_COUNT);
+      static void _fill(const LEDTaskParams& task_params, const CRGB& color, const CRGB& adjustment);
+      static void _showDithered(const LEDTaskParams& task_params);
+      static void _submit(const LEDTaskParams& task_params);
+      static bool _wait(const LEDTaskParams& task_params, TickType_t ticks);
+      static bool _crossfade(const LEDTaskParams& task_params, const CRGB& adjustment);
+      static bool _composite(const LEDTaskParams& task_params, const CRGB& adjustment);
+      static bool _hasLayers(Soylent::LedCompositor::LayerStack* layerStack);
+      static bool _play(const LEDTaskParams& task_params, CRGB* pixels);
       StatusRequest _srInitialized;
       StatusRequest _srBusy;
       StatusRequest _srAnimated;
+      FrameBuffer _frameBuffer;
+      Soylent::LedCompositor::LayerStack _layerStack;
+      Soylent::LedPower::Budget _power;
+      Soylent::LedDither::Dither _dither;
+      Soylent::LedPipeline::Pipeline _pipeline;
+      Soylent::LedAnimation::Statistics _animation;
+      Soylent::LedResume::Store _resume;
+      Soylent::LedResume::Source _resumedFrom;
+      uint32_t _initializedAt;
+      char _animationPath[CONFIG_THINGY_LED_ANIMATION_PATH];
       Scheduler* _scheduler;
       LedState _ledState;
       uint8_t _ledPin;
-      bool _rgbLed;
       uint32_t _timeConstant;
+      uint8_t _hue;
+      LedState _previousState;
+      uint32_t _previousTimeConstant;
+      uint8_t _previousHue;
       TaskHandle_t _async_task_handle;
+      // the LED task tells when it's gone, it doesn't go while it's held by the loop task (e.g. its stack being walked)
+      static volatile bool _taskRunning;
+      static volatile bool _taskHeld;
+      static SemaphoreHandle_t _taskStopped;
+      TaskHandle_t _output_task_handle;
+      // the output task is asked to stop (instead of being deleted while it's showing a frame), and tells when it did
+      volatile bool _outputStopping;
+      SemaphoreHandle_t _outputStopped;
   };
 } // namespace Soylent
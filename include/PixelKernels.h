@@ -0,0 +1,119 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+/*
+ * Copyright (C) 2025 Robert Wendlandt
+ */
+#pragma once
+
+#include <FastLED.h>
+
+namespace Soylent {
+  namespace PixelKernels {
+    // Every implementation is providing (bit-exact to each other, see tests/test/test_pixel_kernels):
+    //   scale() - scale all channels by one factor, or each channel by its own (as scale8)
+    //   blend() - blend a layer onto the pixels below (as blend8)
+    //   gamma() - look up all channels in a table
+    //   hsv()   - convert from HSV (rainbow) to RGB
+
+    // One channel at a time, straight from lib8tion (the reference)
+    struct Portable {
+        static inline void scale(CRGB* pixels, uint16_t count, uint8_t scale) {
+          uint8_t* raw = pixels[0].raw;
+          for (uint32_t i = 0; i < count * 3u; i++) {
+            raw[i] = scale8(raw[i], scale);
+          }
+        }
+        static inline void scale(CRGB* pixels, uint16_t count, const CRGB& adjustment) {
+          for (uint16_t i = 0; i < count; i++) {
+            for (uint8_t c = 0; c < 3; c++) {
+              pixels[i].raw[c] = scale8(pixels[i].raw[c], adjustment.raw[c]);
+            }
+          }
+        }
+        static inline void blend(CRGB* below, const CRGB* layer, uint16_t count, uint8_t amount) {
+          uint8_t* raw = below[0].raw;
+          const uint8_t* over = layer[0].raw;
+          for (uint32_t i = 0; i < count * 3u; i++) {
+            raw[i] = blend8(raw[i], over[i], amount);
+          }
+        }
+        static inline void gamma(CRGB* pixels, uint16_t count, const uint8_t* table) {
+          uint8_t* raw = pixels[0].raw;
+          for (uint32_t i = 0; i < count * 3u; i++) {
+            raw[i] = table[raw[i]];
+          }
+        }
+        static inline void hsv(const CHSV* hsv, CRGB* pixels, uint16_t count) {
+          hsv2rgb_rainbow(hsv, pixels, count);
+        }
+    };
+
+    // Two channels per 32-bit multiply, each in a 16-bit lane (which can't overflow)
+    // table lookups and the branchy HSV conversion gain nothing from it and stay as they are
+    struct Packed : Portable {
+        static inline uint32_t pack(uint8_t low, uint8_t high) {
+          return low | (static_cast<uint32_t>(high) << 16);
+        }
+        // (x * (1 + scale)) >> 8 in both lanes
+        static inline uint32_t scale8x2(uint32_t lanes, uint8_t scale) {
+          return ((lanes * (1u + scale)) >> 8) & 0x00FF00FF;
+        }
+        // (a * 256 + b + (b - a) * amount) >> 8, i.e. (a * (256 - amount) + b * (1 + amount)) >> 8 in both lanes
+        static inline uint32_t blend8x2(uint32_t a, uint32_t b, uint8_t amount) {
+          return ((a * (256u - amount) + b * (1u + amount)) >> 8) & 0x00FF00FF;
+        }
+
+        static inline void scale(CRGB* pixels, uint16_t count, uint8_t scale) {
+          uint8_t* raw = pixels[0].raw;
+          uint32_t channels = count * 3u;
+          uint32_t i = 0;
+          for (; i + 1 < channels; i += 2) {
+            uint32_t lanes = scale8x2(pack(raw[i], raw[i + 1]), scale);
+            raw[i] = lanes;
+            raw[i + 1] = lanes >> 16;
+          }
+          if (i < channels) {
+            raw[i] = scale8(raw[i], scale);
+          }
+        }
+        // a channel and the same one of the next pixel are sharing their factor
+        static inline void scale(CRGB* pixels, uint16_t count, const CRGB& adjustment) {
+          uint16_t i = 0;
+          for (; i + 1 < count; i += 2) {
+            for (uint8_t c = 0; c < 3; c++) {
+              uint32_t lanes = scale8x2(pack(pixels[i].raw[c], pixels[i + 1].raw[c]), adjustment.raw[c]);
+              pixels[i].raw[c] = lanes;
+              pixels[i + 1].raw[c] = lanes >> 16;
+            }
+          }
+          if (i < count) {
+            Portable::scale(&pixels[i], 1, adjustment);
+          }
+        }
+        static inline void blend(CRGB* below, const CRGB* layer, uint16_t count, uint8_t amount) {
+          uint8_t* raw = below[0].raw;
+          const uint8_t* over = layer[0].raw;
+          uint32_t channels = count * 3u;
+          uint32_t i = 0;
+          for (; i + 1 < channels; i += 2) {
+            uint32_t lanes = blend8x2(pack(raw[i], raw[i + 1]), pack(over[i], over[i + 1]), amount);
+            raw[i] = lanes;
+            raw[i + 1] = lanes >> 16;
+          }
+          if (i < channels) {
+            raw[i] = blend8(raw[i], over[i], amount);
+          }
+        }
+    };
+
+#ifdef ESP_PLATFORM
+    typedef Packed Selected;
+#else
+    typedef Portable Selected;
+#endif
+
+#ifdef CONFIG_THINGY_PIXEL_KERNELS_CHECK
+    // compare the implementations and log their throughput (in pixels/s)
+    bool check();
+#endif
+  } // namespace PixelKernels
+} // namespace Soylent
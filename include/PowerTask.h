@@ -0,0 +1,139 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+/*
+ * Copyright (C) 2025 Robert Wendlandt
+ */
+#pragma once
+
+#include <TaskSchedulerDeclarations.h>
+#if CONFIG_PM_ENABLE
+  #include <esp_pm.h>
+#endif
+
+// block the main loop until the next task is due (instead of spinning), 0 to keep on spinning
+#ifndef CONFIG_THINGY_IDLE_SLEEP
+  #define CONFIG_THINGY_IDLE_SLEEP 1
+#endif
+
+// longest the main loop blocks at once (in ms), in case a wake-up goes missing
+#ifndef CONFIG_THINGY_IDLE_MAX_SLEEP
+  #define CONFIG_THINGY_IDLE_MAX_SLEEP 250
+#endif
+
+// automatic light sleep while the LED is static
+// only when power management and tickless idle are in the sdkconfig (see platformio.ini)
+#ifndef CONFIG_THINGY_LIGHT_SLEEP
+  #define CONFIG_THINGY_LIGHT_SLEEP 1
+#endif
+
+// raise the CPU clock while there is work to do and drop it when idle, 0 to keep it where it is
+#ifndef CONFIG_THINGY_CPU_SCALING
+  #define CONFIG_THINGY_CPU_SCALING 1
+#endif
+
+// CPU clock while busy (in MHz, 0 for the clock at start-up)
+#ifndef CONFIG_THINGY_CPU_MAX_FREQ
+  #define CONFIG_THINGY_CPU_MAX_FREQ 0
+#endif
+
+// CPU clock while idle (in MHz, Wi-Fi needs at least 80)
+#ifndef CONFIG_THINGY_CPU_MIN_FREQ
+  #define CONFIG_THINGY_CPU_MIN_FREQ 80
+#endif
+
+// the clock is only dropped after there was nothing to do for as long (in ms)
+#ifndef CONFIG_THINGY_CPU_BOOST_HOLD
+  #define CONFIG_THINGY_CPU_BOOST_HOLD 2000
+#endif
+
+// concurrent HTTP requests raising the clock
+#ifndef CONFIG_THINGY_CPU_BOOST_REQUESTS
+  #define CONFIG_THINGY_CPU_BOOST_REQUESTS 2
+#endif
+
+// LEDs an animation needs to raise the clock (a single LED is rendered in no time)
+#ifndef CONFIG_THINGY_CPU_BOOST_PIXELS
+  #define CONFIG_THINGY_CPU_BOOST_PIXELS 32
+#endif
+
+namespace Soylent {
+  // Lets the main loop (and the CPU) sleep whenever there is nothing to do
+  // TaskScheduler tells how long until the next task is due (_TASK_TICKLESS), the loop blocks as long
+  // HTTP requests, LED commands and network events wake it up early
+  // The CPU clock follows the workload: it's raised as soon as there is demand for it
+  // and dropped again once there was none for CONFIG_THINGY_CPU_BOOST_HOLD ms
+  class PowerClass {
+    public:
+      // what raises the clock
+      enum Demand : uint8_t {
+        // an animation on many LEDs
+        DEMAND_LED = 0,
+        // concurrent HTTP requests
+        DEMAND_HTTP = 1,
+        DEMAND_COUNT = 2
+      };
+
+      PowerClass();
+      void begin(Scheduler* scheduler);
+      void end();
+      // from loop(), after each pass of the scheduler (idleRun: no task was due)
+      void idle(bool idleRun);
+      // there is something new to do for the main loop (from any task)
+      void wake();
+      // raise the clock until the demand is released again (from any task)
+      void boost(Demand demand);
+      void release(Demand demand);
+
+      bool isLightSleepSupported();
+      bool isLightSleepAllowed();
+      // times the main loop has blocked, woken up early and time blocked (in us)
+      uint32_t getSleeps();
+      uint32_t getEarlyWakeups();
+      uint64_t getSleepTime();
+      // time light sleep was allowed (in us)
+      uint64_t getLightSleepTime();
+      bool isScaling();
+      bool isBoosted();
+      uint32_t getMinFrequency();
+      uint32_t getMaxFrequency();
+      // times the clock was raised
+      uint32_t getBoosts();
+      // demands right now
+      uint16_t getDemand(Demand demand);
+      // time spent at the raised and at the lower clock (in us)
+      uint64_t getBoostedTime();
+      uint64_t getUnboostedTime();
+      // share of time the idle task of a core ran since start-up (in %, -1 without run time stats)
+      int getIdlePercent(uint8_t core);
+
+    private:
+      void _allowLightSleep(bool allow);
+      uint32_t _govern();
+      void _setFrequency(bool boosted);
+      Scheduler* _scheduler;
+      TaskHandle_t _loopTask;
+#if CONFIG_PM_ENABLE
+      esp_pm_lock_handle_t _noLightSleep;
+      esp_pm_lock_handle_t _cpuFreqMax;
+#endif
+      // esp_pm scales the clock (otherwise the main loop does)
+      bool _pmScaling;
+      uint32_t _minFrequency;
+      uint32_t _maxFrequency;
+      volatile uint16_t _demands[DEMAND_COUNT];
+      bool _ledDemand;
+      volatile bool _boosted;
+      volatile uint32_t _lastDemandAt;
+      // when the clock was last changed
+      int64_t _frequencySince;
+      uint64_t _boostedTime;
+      uint64_t _unboostedTime;
+      uint32_t _boosts;
+      bool _lightSleepSupported;
+      volatile bool _lightSleepAllowed;
+      int64_t _lightSleepSince;
+      uint64_t _lightSleepTime;
+      volatile uint32_t _sleeps;
+      volatile uint32_t _earlyWakeups;
+      volatile uint64_t _sleepTime;
+  };
+} // namespace Soylent
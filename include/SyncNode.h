@@ -0,0 +1,180 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+/*
+ * Copyright (C) 2025 Robert Wendlandt
+ */
+#pragma once
+
+#include <cstdint>
+#include <cstdlib>
+
+// samples per window, only the one with the shortest round trip is used
+#define SYNC_WINDOW 4
+// offsets further off are stepped instead of slewed (us)
+#define SYNC_STEP_THRESHOLD 20000
+
+namespace Soylent {
+  // What a node of the time sync knows: whom it follows and how its clock is off from the network time
+  // (the packets are up to TimeSyncClass, which holds the lock while calling any of this)
+  // the node with the lowest id is leading, all others follow its clock
+  // (a follower keeps its leader until it's gone, even if a node with a lower id shows up)
+  class SyncNode {
+    public:
+      // what a beacon changed
+      enum class Beacon : uint8_t {
+        NONE = 0,
+        // from the leader followed
+        LEADER_SEEN = 1,
+        // from a node leading with a lower id, it's followed from now on
+        FOLLOWING = 2,
+        // the leader followed follows another one now, the node leads on its own until it hears from that one
+        LEADER_LEFT = 3
+      };
+
+      // leading on its own, with the clock as it is
+      void begin(uint32_t nodeId) {
+        _nodeId = nodeId;
+        _leaderId = nodeId;
+      }
+
+      void end() {
+        _leaderId = _nodeId;
+      }
+
+      // (a node is never announcing itself with id 0, see TimeSyncClass::begin())
+      Beacon onBeacon(uint32_t nodeId, uint32_t leaderId, uint32_t now) {
+        if (leaderId != nodeId) {
+          if (nodeId == _leaderId) {
+            _leaderId = _nodeId;
+            return Beacon::LEADER_LEFT;
+          }
+        } else if (nodeId == _leaderId) {
+          _leaderSeenAt = now;
+          return Beacon::LEADER_SEEN;
+        } else if (_leaderId == _nodeId && nodeId < _nodeId) {
+          // only a node leading on its own looks for another leader (lowest id wins),
+          // a follower sticks to its leader until it's gone, so a node joining doesn't step the clocks
+          _leaderId = nodeId;
+          _leaderSeenAt = now;
+          _synced = false;
+          _samples = 0;
+          _bestDelay = INT64_MAX;
+          return Beacon::FOLLOWING;
+        }
+        return Beacon::NONE;
+      }
+
+      // the leader has gone silent for longer than timeout, take over (keeping the clock as it is)
+      // returns the id of the leader gone, 0 if there is none
+      uint32_t checkLeader(uint32_t now, uint32_t timeout) {
+        if (_leaderId == _nodeId || now - _leaderSeenAt <= timeout) {
+          return 0;
+        }
+        uint32_t goneLeaderId = _leaderId;
+        _leaderId = _nodeId;
+        return goneLeaderId;
+      }
+
+      // a response of a node to our request, NTP-style: t1 / t4 are local, t2 / t3 are the network time of the responder
+      // returns true, if it was taken (the best of each window, the first one at once)
+      bool onResponse(uint32_t nodeId, int64_t t1, int64_t t2, int64_t t3, int64_t t4) {
+        if (nodeId != _leaderId) {
+          return false;
+        }
+
+        int64_t offset = ((t2 - t1) + (t3 - t4)) / 2;
+        int64_t delay = (t4 - t1) - (t3 - t2);
+        if (delay < _bestDelay) {
+          _bestDelay = delay;
+          _bestOffset = offset;
+        }
+        if (++_samples < SYNC_WINDOW && _synced) {
+          return false;
+        }
+
+        _delay = _bestDelay;
+        _applySample(_bestOffset, t4);
+        _samples = 0;
+        _bestDelay = INT64_MAX;
+        return true;
+      }
+
+      // network time = local time + offset at that time
+      int64_t getOffsetAt(int64_t localTime) const {
+        return _offset + static_cast<int64_t>(_drift * static_cast<float>(localTime - _offsetAt));
+      }
+
+      // start out from a network time, until synced to a leader
+      void setOffset(int64_t offset, int64_t localTime) {
+        _offset = offset;
+        _offsetAt = localTime;
+        _drift = 0;
+      }
+
+      bool isLeader() const {
+        return _leaderId == _nodeId;
+      }
+
+      bool isSynced() const {
+        return isLeader() || _synced;
+      }
+
+      uint32_t getNodeId() const {
+        return _nodeId;
+      }
+
+      uint32_t getLeaderId() const {
+        return _leaderId;
+      }
+
+      int64_t getOffset() const {
+        return _offset;
+      }
+
+      int64_t getDelay() const {
+        return _delay;
+      }
+
+      // (as a fraction, not in ppm)
+      float getDrift() const {
+        return _drift;
+      }
+
+    private:
+      // Update the clock model by a new offset sample
+      void _applySample(int64_t offset, int64_t localTime) {
+        int64_t predicted = getOffsetAt(localTime);
+        if (!_synced || llabs(offset - predicted) > SYNC_STEP_THRESHOLD) {
+          // (re)start from scratch
+          _offset = offset;
+          _offsetAt = localTime;
+          _drift = 0;
+        } else {
+          // estimate the drift from consecutive samples...
+          float drift = static_cast<float>(offset - _lastSample) / static_cast<float>(localTime - _lastSampleAt);
+          _drift += (drift - _drift) / 4;
+          // ...and slew towards the sample
+          _offset = predicted + (offset - predicted) / 2;
+          _offsetAt = localTime;
+        }
+        _lastSample = offset;
+        _lastSampleAt = localTime;
+        _synced = true;
+      }
+
+      uint32_t _nodeId = 0;
+      uint32_t _leaderId = 0;
+      uint32_t _leaderSeenAt = 0;
+      bool _synced = false;
+      // network time = local time + offset + drift * (local time - offset taken)
+      int64_t _offset = 0;
+      int64_t _offsetAt = 0;
+      float _drift = 0;
+      int64_t _delay = 0;
+      int64_t _lastSample = 0;
+      int64_t _lastSampleAt = 0;
+      // best (i.e. shortest round trip) sample of the current window
+      int64_t _bestOffset = 0;
+      int64_t _bestDelay = INT64_MAX;
+      uint8_t _samples = 0;
+  };
+} // namespace Soylent
@@ -1,47 +1,64 @@
 // SPDX-License-Identifier: GPL-3.0-or-later
 /*
- * Copyright (C) 2024 Robert Wendlandt
+ * Copyright (C) 2024-2025 Robert Wendlandt
  */
 #pragma once
 
 #include <esp_system.h>
-#include <map>
-#include <string>
+#include <cstddef>
+
+// bytes /sysinfo is rendered into (it's rendered just once, nothing in there changes while running)
+#ifndef CONFIG_THINGY_SYSINFO_SIZE
+  #define CONFIG_THINGY_SYSINFO_SIZE 2048
+#endif
 
 namespace Soylent {
-  class SystemInfoClass {
-    public:
-      SystemInfoClass() {};
+  // What the thingy is running on and why it (re)started, without any allocation
+  // the tables are constexpr (i.e. in flash), there is nothing to be constructed at start-up
+  namespace SystemInfo {
+    struct ResetReason {
+        esp_reset_reason_t reason;
+        // short, for JSON
+        const char* name;
+        const char* description;
+    };
+
+    // (the first entry is the fallback for anything unknown)
+    inline constexpr ResetReason RESET_REASONS[] = {
+      {ESP_RST_UNKNOWN, "unknown", "Reset reason cannot be determined"},
+      {ESP_RST_POWERON, "power_on", "Reset due to power-on event"},
+      {ESP_RST_EXT, "external", "Reset by external pin"},
+      {ESP_RST_SW, "software", "Software reset via esp_restart"},
+      {ESP_RST_PANIC, "panic", "Software reset due to exception/panic"},
+      {ESP_RST_INT_WDT, "interrupt_wdt", "Reset (software or hardware) due to interrupt watchdog"},
+      {ESP_RST_TASK_WDT, "task_wdt", "Reset due to task watchdog"},
+      {ESP_RST_WDT, "wdt", "Reset due to other watchdogs"},
+      {ESP_RST_DEEPSLEEP, "deep_sleep", "Reset after exiting deep sleep mode"},
+      {ESP_RST_BROWNOUT, "brownout", "Brownout reset (software or hardware)"},
+      {ESP_RST_SDIO, "sdio", "Reset over SDIO"},
+      {ESP_RST_USB, "usb", "Reset by USB peripheral"},
+      {ESP_RST_JTAG, "jtag", "Reset by JTAG"},
+      {ESP_RST_EFUSE, "efuse", "Reset due to efuse error"},
+      {ESP_RST_PWR_GLITCH, "power_glitch", "Reset due to power glitch detected"},
+      {ESP_RST_CPU_LOCKUP, "cpu_lockup", "Reset due to CPU lock up (double exception)"},
+    };
 
-      // Get Reset reason as String
-      std::string getResetReasonString() {
-        if (auto resetReason = _resetReasonMap.find(esp_reset_reason()); resetReason != _resetReasonMap.end()) {
-          return resetReason->second;
-        } else {
-          return _resetReasonMap[ESP_RST_UNKNOWN];
+    constexpr const ResetReason& resetReasonOf(esp_reset_reason_t reason) {
+      for (const ResetReason& entry : RESET_REASONS) {
+        if (entry.reason == reason) {
+          return entry;
         }
       }
+      return RESET_REASONS[0];
+    }
 
-    private:
-      std::map<esp_reset_reason_t, std::string> _resetReasonMap = {
-        {ESP_RST_UNKNOWN, "Reset reason cannot be determined"},
-        {ESP_RST_POWERON, "Reset due to power-on event"},
-        {ESP_RST_EXT, "Reset by external pin"},
-        {ESP_RST_SW, "Software reset via esp_restart"},
-        {ESP_RST_PANIC, "Software reset due to exception/panic"},
-        {ESP_RST_INT_WDT, "Reset (software or hardware) due to interrupt watchdog"},
-        {ESP_RST_TASK_WDT, "Reset due to task watchdog"},
-        {ESP_RST_WDT, "Reset due to other watchdogs"},
-        {ESP_RST_DEEPSLEEP, "Reset after exiting deep sleep mode"},
-        {ESP_RST_BROWNOUT, "Brownout reset (software or hardware)"},
-        {ESP_RST_SDIO, "Reset over SDIO"},
-        {ESP_RST_USB, "Reset by USB peripheral"},
-        {ESP_RST_JTAG, "Reset by JTAG"},
-        {ESP_RST_EFUSE, "Reset due to efuse error"},
-        {ESP_RST_PWR_GLITCH, "Reset due to power glitch detected"},
-        {ESP_RST_CPU_LOCKUP, "Reset due to CPU lock up (double exception)"},
-      };
-  };
-}
+    static_assert(resetReasonOf(ESP_RST_POWERON).reason == ESP_RST_POWERON, "the reset reasons have to be looked up at compile time");
 
-Soylent::SystemInfoClass SystemInfo;
+    // why we (re)started this time
+    const ResetReason& getResetReason();
+    // reset reason, chip, flash and partitions and the build as JSON, rendered once (only from the async_tcp task)
+    const char* getJson(size_t* length);
+    // render it into a buffer, returns the length it takes (like snprintf: size or more when it didn't fit)
+    size_t write(char* buffer, size_t size);
+  } // namespace SystemInfo
+} // namespace Soylent
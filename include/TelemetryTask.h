@@ -0,0 +1,64 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+/*
+ * Copyright (C) 2025 Robert Wendlandt
+ */
+#pragma once
+
+#include <TaskSchedulerDeclarations.h>
+
+// stacks and heap are sampled this often (in ms)
+#ifndef CONFIG_THINGY_TELEMETRY_INTERVAL
+  #define CONFIG_THINGY_TELEMETRY_INTERVAL 10000
+#endif
+
+// samples kept (the oldest ones are overwritten)
+#ifndef CONFIG_THINGY_TELEMETRY_SAMPLES
+  #define CONFIG_THINGY_TELEMETRY_SAMPLES 32
+#endif
+
+namespace Soylent {
+  // Samples how much of their stacks the tasks use and how much (and how fragmented) heap is left
+  // to right-size CONFIG_THINGY_TASKS_STACK_SIZE, CONFIG_ASYNC_TCP_STACK_SIZE,... by what's actually used
+  class TelemetryClass {
+    public:
+      enum Stack : uint8_t {
+        STACK_LOOP = 0,
+        STACK_LED = 1,
+        STACK_LED_OUTPUT = 2,
+        STACK_ASYNC_TCP = 3,
+        STACK_COUNT = 4
+      };
+
+      struct Sample {
+          // millis() when sampled
+          uint32_t at;
+          uint32_t heapFree;
+          // lowest free heap ever
+          uint32_t heapMinFree;
+          uint32_t heapLargestBlock;
+          // least free stack of each task since it was started (in bytes, -1 when not running)
+          int32_t stackFree[STACK_COUNT];
+      };
+
+      TelemetryClass();
+      void begin(Scheduler* scheduler);
+      void end();
+      static const char* getStackName(Stack stack);
+      // the stack a task was created with (in bytes, 0 when there is no such task)
+      static uint32_t getStackSize(Stack stack);
+      // least free stack seen in any sample (in bytes, -1 when never seen running)
+      int32_t getStackMinFree(Stack stack);
+      // samples in the buffer and a copy of one of them (0 is the oldest)
+      uint16_t getSampleCount();
+      bool getSample(uint16_t index, Sample* copy);
+
+    private:
+      void _sampleCallback();
+      Task* _sampleTask;
+      Scheduler* _scheduler;
+      Sample _samples[CONFIG_THINGY_TELEMETRY_SAMPLES];
+      uint16_t _next;
+      uint16_t _count;
+      int32_t _stackMinFree[STACK_COUNT];
+  };
+} // namespace Soylent
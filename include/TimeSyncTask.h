@@ -0,0 +1,61 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+/*
+ * Copyright (C) 2025 Robert Wendlandt
+ */
+#pragma once
+
+#include <AsyncUDP.h>
+#include <SyncNode.h>
+#include <TaskSchedulerDeclarations.h>
+
+namespace Soylent {
+  // Share a common clock between LEDThingys in the same network (see SyncNode.h)
+  class TimeSyncClass {
+    public:
+      TimeSyncClass();
+      void begin(Scheduler* scheduler);
+      void end();
+      // network time (local time when not synced)
+      int64_t getMicros();
+      uint32_t getMillis();
+      // start out from a network time (e.g. the one before a restart), until synced to a leader
+      void setMicros(int64_t networkTime);
+      bool isLeader();
+      bool isSynced();
+      uint32_t getNodeId();
+      uint32_t getLeaderId();
+      int64_t getOffset();
+      int32_t getDelay();
+      float getDrift();
+
+    private:
+      // packed little-endian packets on the wire
+      struct __attribute__((packed)) SyncPacket {
+          char magic[4];
+          uint8_t version;
+          uint8_t type;
+          uint16_t reserved;
+          uint32_t nodeId;
+          uint32_t leaderId;
+          int64_t t1;
+          int64_t t2;
+          int64_t t3;
+      };
+
+      enum class PacketType : uint8_t {
+        BEACON = 1,
+        REQUEST = 2,
+        RESPONSE = 3
+      };
+
+      void _syncCallback();
+      void _onPacket(AsyncUDPPacket& packet);
+      void _send(PacketType type, int64_t t1, int64_t t2, const IPAddress& address, uint16_t port);
+      Task* _syncTask;
+      Scheduler* _scheduler;
+      AsyncUDP _udp;
+      // (guarded by cs_spinlock, packets arrive in the async_udp task)
+      SyncNode _node;
+      IPAddress _leaderAddress;
+  };
+} // namespace Soylent
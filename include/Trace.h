@@ -0,0 +1,99 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+/*
+ * Copyright (C) 2025 Robert Wendlandt
+ */
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+// record trace points of what the firmware is doing, 0 to compile them away
+#ifndef CONFIG_THINGY_TRACE
+  #define CONFIG_THINGY_TRACE 1
+#endif
+
+// events kept per core (the oldest ones are overwritten)
+#ifndef CONFIG_THINGY_TRACE_EVENTS
+  #define CONFIG_THINGY_TRACE_EVENTS 128
+#endif
+
+#define TRACE_CONCAT_(a, b) a##b
+#define TRACE_CONCAT(a, b)  TRACE_CONCAT_(a, b)
+
+#if CONFIG_THINGY_TRACE
+  // time spent in the rest of the enclosing scope (name has to be a string literal)
+  #define TRACE_SCOPE(name)          Soylent::Trace::Scope TRACE_CONCAT(_traceScope, __LINE__)(name)
+  // something happening right now
+  #define TRACE_INSTANT(name)        Soylent::Trace::record(Soylent::Trace::INSTANT, name, 0)
+  // something taking a while, across tasks: begun here and ended elsewhere with the same id
+  #define TRACE_ASYNC_BEGIN(name, id) Soylent::Trace::record(Soylent::Trace::ASYNC_BEGIN, name, id)
+  #define TRACE_ASYNC_END(name, id)   Soylent::Trace::record(Soylent::Trace::ASYNC_END, name, id)
+  #define TRACE_NEXT_ID()             Soylent::Trace::nextId()
+#else
+  #define TRACE_SCOPE(name)
+  #define TRACE_INSTANT(name)
+  #define TRACE_ASYNC_BEGIN(name, id)
+  #define TRACE_ASYNC_END(name, id)
+  #define TRACE_NEXT_ID() 0
+#endif
+
+namespace Soylent {
+  // Trace points recorded into a ring buffer per core, exported as Chrome trace events
+  // (open them in chrome://tracing or https://ui.perfetto.dev)
+  // a slot is claimed by an atomic increment, so any task (or the host) may record without locking
+  // builds without FreeRTOS (e.g. on the host) use the clock and thread of the host instead
+  namespace Trace {
+    enum Phase : uint8_t {
+      // "X": a scope with its duration
+      COMPLETE = 'X',
+      INSTANT = 'i',
+      ASYNC_BEGIN = 'b',
+      ASYNC_END = 'e'
+    };
+
+    struct Event {
+        // a string literal
+        const char* name;
+        // in us
+        uint32_t start;
+        uint32_t duration;
+        // the task (thread) recording it
+        uint32_t task;
+        // async events only
+        uint16_t id;
+        uint8_t core;
+        uint8_t phase;
+    };
+
+    // now, in us (wrapping around after ~71 minutes)
+    uint32_t now();
+    void record(Phase phase, const char* name, uint16_t id, uint32_t start = now(), uint32_t duration = 0);
+    // an id for a pair of async events, never 0 (0 is for what's not traced)
+    uint16_t nextId();
+    // events recorded (including those overwritten meanwhile)
+    uint32_t getRecorded();
+    void clear();
+    // export all events kept as JSON in the Chrome trace event format, chunk by chunk
+    void write(void (*out)(const char* chunk, void* context), void* context);
+
+    template <class Output>
+    void write(Output& output) {
+      write([](const char* chunk, void* context) { static_cast<Output*>(context)->print(chunk); }, &output);
+    }
+
+    class Scope {
+      public:
+        explicit Scope(const char* name) : _name(name), _start(now()) {}
+        ~Scope() {
+          record(COMPLETE, _name, 0, _start, now() - _start);
+        }
+        Scope(const Scope&) = delete;
+        Scope& operator=(const Scope&) = delete;
+
+      private:
+        const char* _name;
+        uint32_t _start;
+    };
+  } // namespace Trace
+} // namespace Soylent
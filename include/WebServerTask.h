@@ -12,12 +12,43 @@ namespace Soylent {
       explicit WebServerClass(AsyncWebServer& webServer);
       void begin(Scheduler* scheduler);
       void end();
+      // stop listening, but keep all registered routes and handlers alive
+      void suspend();
+      bool isSuspended();
       StatusRequest* getStatusRequest();
+      // micros() the headers of a request were in, before its body was received and parsed and before admission
+      // (micros() for a request that wasn't stamped)
+      static uint32_t getArrivedAt(AsyncWebServerRequest* request);
+      // rate limit of the messages on a WebSocket (they don't pass admission), per client like requests
+      // returns false, if the message is to be rejected
+      bool admitMessage(AsyncWebSocketClient* client);
 
     private:
+      // token bucket per client, tokens in 1/1000
+      struct ClientBucket {
+          uint32_t address;
+          uint32_t tokens;
+          uint32_t lastSeen;
+      };
+
+      bool _admitRequest(AsyncWebServerRequest* request);
+      ClientBucket* _getBucket(uint32_t address, uint32_t now);
+      bool _takeToken(uint32_t address);
       void _webServerCallback();
+      void _resumeCallback();
+      void _registerNotFoundHandler();
       StatusRequest _sr;
       Scheduler* _scheduler;
       AsyncWebServer* _webServer;
+      bool _routesRegistered;
+      bool _notFoundRegistered;
+      bool _suspended;
+      uint32_t _resumeRequestedAt;
+      uint32_t _suspendedHeap;
+      bool _admissionRegistered;
+      ClientBucket _buckets[CONFIG_THINGY_HTTP_CLIENTS];
+      uint16_t _activeRequests;
+      uint32_t _rejectedRateLimit;
+      uint32_t _rejectedBusy;
   };
 } // namespace Soylent
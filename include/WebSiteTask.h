@@ -4,25 +4,99 @@
  */
 #pragma once
 
+#include <FileCache.h>
+#include <LedAnimation.h>
+#include <LedCommand.h>
+#include <LedPipeline.h>
 #include <TaskSchedulerDeclarations.h>
 
+// subscribers of the live preview of the LED (/led/preview/ws)
+#ifndef CONFIG_THINGY_LED_PREVIEW_CLIENTS
+  #define CONFIG_THINGY_LED_PREVIEW_CLIENTS 2
+#endif
+
+// frames per second sent to a subscriber, unless it asks for another rate (up to the maximum)
+#ifndef CONFIG_THINGY_LED_PREVIEW_RATE
+  #define CONFIG_THINGY_LED_PREVIEW_RATE 10
+#endif
+
+#ifndef CONFIG_THINGY_LED_PREVIEW_MAX_RATE
+  #define CONFIG_THINGY_LED_PREVIEW_MAX_RATE 25
+#endif
+
 namespace Soylent {
   class WebSiteClass {
     public:
       explicit WebSiteClass(AsyncWebServer& webServer);
       void begin(Scheduler* scheduler);
       void end();
+#if defined(RGB_BUILTIN) && CONFIG_THINGY_FILE_CACHE_SIZE
+      // the images on LittleFS
+      FileCache& getImageCache() { return _imageCache; }
+#endif
 
     private:
+      // a subscriber of the live preview, and what it has seen so far
+      struct PreviewClient {
+          // 0 for none
+          uint32_t id;
+          // frames per second (0 to pause)
+          uint8_t rate;
+          // millis() the next frame is due
+          uint32_t dueAt;
+          uint32_t sequence;
+          bool keyframe;
+          CRGB pixels[CONFIG_THINGY_LED_COUNT];
+      };
+
+      // a binary command received on /led/command, kept until its request has passed admission
+      struct CommandSlot {
+          // nullptr for none
+          const AsyncWebServerRequest* request;
+          // millis() the command was received
+          uint32_t receivedAt;
+          // all of the body is in the command
+          bool complete;
+          uint8_t command[sizeof(Soylent::LedCommand)];
+      };
+
       void _webSiteCallback();
+      CommandSlot* _getCommandSlot(const AsyncWebServerRequest* request, bool take);
+      void _previewEvent(AsyncWebSocketClient* client, AwsEventType type, void* arg, uint8_t* data, size_t len);
+      void _sendPreview();
+      // commandAt: micros() the command arrived (0 if it's not to be accounted for)
+      Soylent::LedCommand::Status _setLedStateIdx(int32_t led_state_idx, uint32_t commandAt);
+      Soylent::LedCommand _dispatchLedCommand(const uint8_t* data, size_t len, uint32_t commandAt);
+      static int _httpCodeOf(Soylent::LedCommand::Status status);
+      int32_t _ledStateIdxOf(Soylent::LedClass::LedState ledState);
       AsyncCallbackJsonWebHandler* _setLEDHandler;
+      AsyncCallbackJsonWebHandler* _setLayerHandler;
+      AsyncWebSocket* _ledSocket;
+      AsyncWebSocket* _previewSocket;
+      Task* _previewTask;
+      PreviewClient _previewClients[CONFIG_THINGY_LED_PREVIEW_CLIENTS];
+      // a slot per request which may be handled at once, without allocating (a request rejected never frees its slot,
+      // the least recently received one is taken over)
+      CommandSlot _commandSlots[CONFIG_THINGY_HTTP_MAX_CONNECTIONS + CONFIG_THINGY_HTTP_RESERVED_CONNECTIONS];
+      // the frame shown and the message being sent (growing with the LEDs, so not on the stack of the loop task)
+      Soylent::LedPipeline::Frame _previewFrame;
+      uint8_t _previewMessage[4 + LED_ANIMATION_OPS_SIZE(sizeof(CRGB) * CONFIG_THINGY_LED_COUNT)];
+      // statistics of the live preview
+      uint32_t _previewFrames;
+      uint32_t _previewBytes;
+      uint32_t _previewSkipped;
+      uint32_t _previewTimeSum;
       Scheduler* _scheduler;
       AsyncWebServer* _webServer;
       int32_t _ledStateCount;
 #ifdef RGB_BUILTIN
       bool _fsMounted = false;
       JsonDocument* _ledStatesJson;
+  #if CONFIG_THINGY_FILE_CACHE_SIZE
+      FileCache _imageCache;
+  #endif
 #endif
       int32_t _ledStateIdx;
+      bool _routesRegistered;
   };
 } // namespace Soylent
@@ -17,10 +17,18 @@
   #include <FastLED.h>
 #endif
 
+#include <AssetBundle.h>
+#include <ConfigTask.h>
 #include <ESPNetworkTask.h>
 #include <ESPRestartTask.h>
 #include <EventHandlerTask.h>
 #include <LedTask.h>
+#include <LedStreamTask.h>
+#include <PowerTask.h>
+#include <SystemInfo.h>
+#include <TelemetryTask.h>
+#include <Trace.h>
+#include <TimeSyncTask.h>
 #include <WebServerTask.h>
 #include <WebSiteTask.h>
 
@@ -31,6 +39,11 @@ extern Soylent::EventHandlerClass EventHandler;
 extern Soylent::WebServerClass WebServer;
 extern Soylent::WebSiteClass WebSite;
 extern Soylent::LedClass Led;
+extern Soylent::LedStreamClass LedStream;
+extern Soylent::TimeSyncClass TimeSync;
+extern Soylent::PowerClass Power;
+extern Soylent::TelemetryClass Telemetry;
+extern Soylent::ConfigClass Config;
 
 // Spinlock for critical sections
 extern portMUX_TYPE cs_spinlock;
@@ -7,8 +7,13 @@
 #include <DNSServer.h>
 #include <ESPAsyncWebServer.h>
 #include <Ticker.h>
+#include <esp_partition.h>
 #include <string>
 
+// the asset bundle of the app (see AssetBundle.h there) is uploaded in filesystem mode and goes to a partition of its own
+#define ASSET_BUNDLE_MAGIC     0x54534154 // 'TAST'
+#define ASSET_BUNDLE_PARTITION "assets"
+
 class SafeBootOTAConnect {
   public:
     enum class State {
@@ -148,6 +153,10 @@ class SafeBootOTAConnect {
     std::string _boardName;
     uint32_t _logo_len;
     uint8_t* _logo;
+    // set while an asset bundle is being uploaded
+    const esp_partition_t* _assetsPartition = nullptr;
+    size_t _assetsWritten = 0;
+    std::string _assetsError;
 
   private:
     void _startSTA();
@@ -159,5 +168,7 @@ class SafeBootOTAConnect {
     void _doCleanupAndRestart();
     void _doCleanup();
     void _onArduinoOTAStarted();
+    void _beginAssets();
+    void _writeAssets(const uint8_t* data, size_t len);
     void _setState(State state);
 };
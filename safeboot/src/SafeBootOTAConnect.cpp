@@ -300,23 +300,36 @@ void SafeBootOTAConnect::_enableOTAServices() {
 
   // handle firmware upload
   _httpd->on("/update", HTTP_POST, [&](AsyncWebServerRequest* request) {
-        _otaResultString = Update.hasError() ? Update.errorString() : "OTA successful! Restarting now...";
+        bool failed = _assetsPartition != nullptr ? !_assetsError.empty() : Update.hasError();
+        _otaResultString = !failed ? "OTA successful! Restarting now..." : _assetsPartition != nullptr ? _assetsError.c_str() : Update.errorString();
         log_d("/update: %s", _otaResultString.c_str());
-        AsyncWebServerResponse* response = request->beginResponse(Update.hasError() ? 502 : 200, "text/plain",
+        AsyncWebServerResponse* response = request->beginResponse(failed ? 502 : 200, "text/plain",
             _otaResultString.c_str());
         response->addHeader("Connection", "close");
         request->send(response);
         _restartDelayed(1000, 1000); }, [&](AsyncWebServerRequest* request, String filename, size_t index, uint8_t* data, size_t len, bool final) {
         if (!index) {
             _lastTime = -1;
+            _assetsPartition = nullptr;
 
             log_d("otaStarted: %s", static_cast<int>(_otaMode) == U_FLASH ? "Firmware" : "Filesystem");
             log_i("Receiving Update: %s, Size: %d", filename.c_str(), len);
 
-            if (!Update.begin(UPDATE_SIZE_UNKNOWN, static_cast<int>(_otaMode))) {
+            uint32_t magic = 0;
+            memcpy(&magic, data, len < sizeof(magic) ? len : sizeof(magic));
+            if (static_cast<int>(_otaMode) == U_SPIFFS && magic == ASSET_BUNDLE_MAGIC) {
+                _beginAssets();
+            } else if (!Update.begin(UPDATE_SIZE_UNKNOWN, static_cast<int>(_otaMode))) {
                 log_e("Update error: %s", Update.errorString());
             }
         }
+        if (_assetsPartition != nullptr) {
+            _writeAssets(data, len);
+            if (final && _assetsError.empty()) {
+                log_i("Asset bundle written: %uB", index+len);
+            }
+            return;
+        }
         if (!Update.hasError()) {
             if (Update.write(data, len) != len) {
                 log_e("Update error: %s", Update.errorString());
@@ -496,6 +509,45 @@ void SafeBootOTAConnect::_onWiFiEvent(WiFiEvent_t event) {
   }
 }
 
+// the app checks the bundle (its crc) when mapping it, a broken one is ignored there
+void SafeBootOTAConnect::_beginAssets() {
+  _assetsWritten = 0;
+  _assetsError.clear();
+  _assetsPartition = esp_partition_find_first(ESP_PARTITION_TYPE_DATA, ESP_PARTITION_SUBTYPE_ANY, ASSET_BUNDLE_PARTITION);
+  if (_assetsPartition == nullptr) {
+    _assetsError = "No partition for the asset bundle!";
+    log_e("%s", _assetsError.c_str());
+  }
+}
+
+void SafeBootOTAConnect::_writeAssets(const uint8_t* data, size_t len) {
+  if (!_assetsError.empty()) {
+    return;
+  }
+  if (_assetsWritten + len > _assetsPartition->size) {
+    _assetsError = "Asset bundle too large!";
+    log_e("%s", _assetsError.c_str());
+    return;
+  }
+
+  // erase the sectors as they are reached
+  size_t erased = (_assetsWritten + _assetsPartition->erase_size - 1) / _assetsPartition->erase_size * _assetsPartition->erase_size;
+  if (_assetsWritten + len > erased) {
+    size_t eraseLen = (_assetsWritten + len - erased + _assetsPartition->erase_size - 1) / _assetsPartition->erase_size * _assetsPartition->erase_size;
+    if (esp_partition_erase_range(_assetsPartition, erased, eraseLen) != ESP_OK) {
+      _assetsError = "Erasing the asset bundle failed!";
+      log_e("%s", _assetsError.c_str());
+      return;
+    }
+  }
+  if (esp_partition_write(_assetsPartition, _assetsWritten, data, len) != ESP_OK) {
+    _assetsError = "Writing the asset bundle failed!";
+    log_e("%s", _assetsError.c_str());
+    return;
+  }
+  _assetsWritten += len;
+}
+
 void SafeBootOTAConnect::setOTAMode(SafeBootOTAConnect::OTAMode otaMode) {
   switch (otaMode) {
     case OTAMode::Filesystem:
@@ -0,0 +1,121 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+/*
+ * Copyright (C) 2025 Robert Wendlandt
+ */
+#include <thingy.h>
+#include <esp_partition.h>
+#include <cinttypes>
+#include <cstring>
+#define TAG "AssetBundle"
+
+// the mapped bundle, stays mapped for good
+static const Soylent::AssetBundle::Header* bundle = nullptr;
+static bool partitionFound = false;
+
+bool Soylent::AssetBundle::begin() {
+  if (bundle != nullptr) {
+    return true;
+  }
+
+  const esp_partition_t* partition = esp_partition_find_first(ESP_PARTITION_TYPE_DATA, ESP_PARTITION_SUBTYPE_ANY, CONFIG_THINGY_ASSETS_PARTITION);
+  if (partition == nullptr) {
+    LOGE(TAG, "No partition \"%s\" for the assets!", CONFIG_THINGY_ASSETS_PARTITION);
+    return false;
+  }
+  partitionFound = true;
+
+  const void* mapped = nullptr;
+  esp_partition_mmap_handle_t handle;
+  if (esp_partition_mmap(partition, 0, partition->size, ESP_PARTITION_MMAP_DATA, &mapped, &handle) != ESP_OK) {
+    LOGE(TAG, "Mapping partition \"%s\" failed!", CONFIG_THINGY_ASSETS_PARTITION);
+    return false;
+  }
+
+  // check it once, so the index can be trusted from now on
+  const Header* header = static_cast<const Header*>(mapped);
+  const uint8_t* bytes = static_cast<const uint8_t*>(mapped);
+  bool valid = header->magic == ASSET_BUNDLE_MAGIC && header->version == ASSET_BUNDLE_VERSION &&
+               header->size <= partition->size && sizeof(Header) + header->count * sizeof(Entry) <= header->size &&
+               crcx::crc32(bytes + sizeof(Header), header->size - sizeof(Header)) == header->crc;
+  const Entry* entries = reinterpret_cast<const Entry*>(bytes + sizeof(Header));
+  for (uint16_t i = 0; valid && i < header->count; i++) {
+    valid = entries[i].offset % ASSET_BUNDLE_ALIGNMENT == 0 && entries[i].length <= header->size && entries[i].offset <= header->size - entries[i].length &&
+            memchr(entries[i].path, 0, ASSET_PATH_SIZE) != nullptr && memchr(entries[i].type, 0, ASSET_TYPE_SIZE) != nullptr &&
+            (i == 0 || strcmp(entries[i - 1].path, entries[i].path) < 0);
+  }
+  if (!valid) {
+    LOGE(TAG, "No valid asset bundle in partition \"%s\", upload one in SafeBoot (filesystem mode)!", CONFIG_THINGY_ASSETS_PARTITION);
+    esp_partition_munmap(handle);
+    return false;
+  }
+
+  bundle = header;
+  LOGI(TAG, "%u assets (%" PRIu32 " bytes) mapped from partition \"%s\"", header->count, header->size, CONFIG_THINGY_ASSETS_PARTITION);
+  return true;
+}
+
+bool Soylent::AssetBundle::isAvailable() {
+  return bundle != nullptr;
+}
+
+bool Soylent::AssetBundle::hasPartition() {
+  return partitionFound;
+}
+
+const Soylent::AssetBundle::Header* Soylent::AssetBundle::getHeader() {
+  return bundle;
+}
+
+// the index is sorted by path (see tools/assets.py)
+const Soylent::AssetBundle::Entry* Soylent::AssetBundle::find(const char* path) {
+  if (bundle == nullptr) {
+    return nullptr;
+  }
+  const Entry* entries = reinterpret_cast<const Entry*>(reinterpret_cast<const uint8_t*>(bundle) + sizeof(Header));
+  uint16_t low = 0;
+  uint16_t high = bundle->count;
+  while (low < high) {
+    uint16_t middle = (low + high) / 2;
+    int order = strcmp(entries[middle].path, path);
+    if (order == 0) {
+      return &entries[middle];
+    }
+    if (order < 0) {
+      low = middle + 1;
+    } else {
+      high = middle;
+    }
+  }
+  return nullptr;
+}
+
+const uint8_t* Soylent::AssetBundle::getData(const Entry& entry) {
+  return reinterpret_cast<const uint8_t*>(bundle) + entry.offset;
+}
+
+bool Soylent::AssetBundle::send(AsyncWebServerRequest* request, const char* path, const char* cacheControl) {
+  const Entry* entry = find(path);
+  if (entry == nullptr) {
+    return false;
+  }
+
+  char etag[11];
+  snprintf(etag, sizeof(etag), "\"%08" PRIx32 "\"", entry->crc);
+  AsyncWebServerResponse* response;
+  const AsyncWebHeader* ifNoneMatch = request->getHeader("If-None-Match");
+  if (ifNoneMatch != nullptr && strstr(ifNoneMatch->value().c_str(), etag) != nullptr) {
+    response = request->beginResponse(304);
+  } else {
+    // straight from the mapped flash, chunk by chunk into the TCP buffers
+    response = request->beginResponse(200, entry->type, getData(*entry), entry->length);
+    if (entry->flags & ASSET_FLAG_GZIP) {
+      response->addHeader("Content-Encoding", "gzip");
+    }
+  }
+  response->addHeader("ETag", etag);
+  if (cacheControl != nullptr) {
+    response->addHeader("Cache-Control", cacheControl);
+  }
+  request->send(response);
+  return true;
+}
@@ -0,0 +1,310 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+/*
+ * Copyright (C) 2025 Robert Wendlandt
+ */
+#include <thingy.h>
+#include <cstring>
+#ifndef ARDUINO
+  #include <map>
+#endif
+#define TAG "Config"
+
+Soylent::ConfigClass::ConfigClass()
+    : _flushTask(nullptr), _scheduler(nullptr), _pending(0), _pendingSince(0), _statistics() {
+}
+
+void Soylent::ConfigClass::begin(Scheduler* scheduler) {
+  LOGD(TAG, "Starting Config...");
+  _scheduler = scheduler;
+  if (_flushTask == nullptr) {
+    _flushTask = new Task(CONFIG_THINGY_CONFIG_FLUSH_DELAY * TASK_MILLISECOND, TASK_ONCE, [&] { _flushCallback(); }, _scheduler, false, NULL, NULL, false);
+  }
+  // (settings might have been changed in setup() already)
+  if (_pending > 0) {
+    _flushTask->restartDelayed(CONFIG_THINGY_CONFIG_FLUSH_DELAY * TASK_MILLISECOND);
+  }
+  LOGD(TAG, "...done!");
+}
+
+void Soylent::ConfigClass::end() {
+  LOGD(TAG, "Stopping Config...");
+  flush();
+  if (_flushTask != nullptr) {
+    _flushTask->disable();
+  }
+  LOGD(TAG, "...done!");
+}
+
+std::string Soylent::ConfigClass::getString(const char* space, const char* key, const std::string& defaultValue) {
+  Entry* entry = _load(space, key, Type::STRING);
+  return entry->present && entry->type == Type::STRING ? entry->value : defaultValue;
+}
+
+uint32_t Soylent::ConfigClass::getULong(const char* space, const char* key, uint32_t defaultValue) {
+  Entry* entry = _load(space, key, Type::ULONG);
+  if (!entry->present || entry->type != Type::ULONG || entry->size != sizeof(uint32_t)) {
+    return defaultValue;
+  }
+  uint32_t value;
+  memcpy(&value, entry->value.data(), sizeof(value));
+  return value;
+}
+
+bool Soylent::ConfigClass::getBool(const char* space, const char* key, bool defaultValue) {
+  Entry* entry = _load(space, key, Type::BOOL);
+  if (!entry->present || entry->type != Type::BOOL || entry->size != 1) {
+    return defaultValue;
+  }
+  return entry->value[0] != 0;
+}
+
+size_t Soylent::ConfigClass::getBytes(const char* space, const char* key, void* buffer, size_t len) {
+  Entry* entry = _load(space, key, Type::BYTES);
+  if (!entry->present || entry->type != Type::BYTES) {
+    return 0;
+  }
+  if (entry->cached) {
+    memcpy(buffer, entry->value.data(), std::min<size_t>(len, entry->size));
+  } else {
+    // a large blob, it's only in NVS
+    std::string value;
+    if (!_read(entry->space, entry->key, Type::BYTES, &value)) {
+      return 0;
+    }
+    memcpy(buffer, value.data(), std::min(len, value.size()));
+  }
+  return entry->size;
+}
+
+void Soylent::ConfigClass::putString(const char* space, const char* key, const std::string& value) {
+  _put(space, key, Type::STRING, value.data(), value.size());
+}
+
+void Soylent::ConfigClass::putULong(const char* space, const char* key, uint32_t value) {
+  _put(space, key, Type::ULONG, &value, sizeof(value));
+}
+
+void Soylent::ConfigClass::putBool(const char* space, const char* key, bool value) {
+  uint8_t byte = value ? 1 : 0;
+  _put(space, key, Type::BOOL, &byte, sizeof(byte));
+}
+
+void Soylent::ConfigClass::putBytes(const char* space, const char* key, const void* value, size_t len) {
+  _put(space, key, Type::BYTES, value, len);
+}
+
+bool Soylent::ConfigClass::flush(const char* space) {
+  if (_pending == 0) {
+    return false;
+  }
+  TRACE_SCOPE("config.flush");
+
+  uint16_t written = 0;
+  uint16_t failed = 0;
+  for (Entry& entry : _entries) {
+    if (!entry.dirty || (space != nullptr && entry.space != space)) {
+      continue;
+    }
+
+    if (!_write(entry.space, entry.key, entry.type, entry.value)) {
+      // (tried again with the next flush)
+      LOGW(TAG, "Can't write %s/%s to NVS!", entry.space.c_str(), entry.key.c_str());
+      _statistics.errors++;
+      failed++;
+      continue;
+    }
+    entry.dirty = false;
+    written++;
+    _statistics.writes++;
+    _statistics.entriesWritten += _entriesOf(entry.type, entry.size);
+    _statistics.bytesWritten += entry.size;
+
+    // it's in NVS now, the crc tells whether it's changed
+    if (entry.type == Type::BYTES && entry.size > CONFIG_THINGY_CONFIG_CACHE_SIZE) {
+      entry.value.clear();
+      entry.value.shrink_to_fit();
+      entry.cached = false;
+    }
+  }
+  if (written == 0 && failed == 0) {
+    return false;
+  }
+
+  LOGD(TAG, "%u setting(s) written to NVS", written);
+  _pending -= written;
+  _pendingSince = millis();
+  _statistics.flushes++;
+  return true;
+}
+
+uint16_t Soylent::ConfigClass::getPending() {
+  return _pending;
+}
+
+const Soylent::ConfigClass::Statistics& Soylent::ConfigClass::getStatistics() {
+  return _statistics;
+}
+
+float Soylent::ConfigClass::getEstimatedPageErases() {
+  return static_cast<float>(_statistics.entriesWritten) / NVS_PAGE_ENTRIES;
+}
+
+// Find a setting, read it from NVS on its first access
+Soylent::ConfigClass::Entry* Soylent::ConfigClass::_load(const char* space, const char* key, Type type) {
+  for (Entry& entry : _entries) {
+    if (entry.space == space && entry.key == key) {
+      return &entry;
+    }
+  }
+
+  Entry entry;
+  entry.space = space;
+  entry.key = key;
+  entry.type = type;
+  entry.dirty = false;
+  entry.present = _read(entry.space, entry.key, type, &entry.value);
+  entry.size = entry.value.size();
+  entry.crc = crcx::crc32(reinterpret_cast<const uint8_t*>(entry.value.data()), entry.value.size());
+  entry.cached = true;
+  if (type == Type::BYTES && entry.size > CONFIG_THINGY_CONFIG_CACHE_SIZE) {
+    entry.value.clear();
+    entry.value.shrink_to_fit();
+    entry.cached = false;
+  }
+  _entries.push_back(std::move(entry));
+  return &_entries.back();
+}
+
+void Soylent::ConfigClass::_put(const char* space, const char* key, Type type, const void* value, size_t len) {
+  Entry* entry = _load(space, key, type);
+  uint32_t crc = crcx::crc32(static_cast<const uint8_t*>(value), len);
+  if (entry->present && entry->type == type && entry->size == len && entry->crc == crc) {
+    _statistics.writesAvoided++;
+    return;
+  }
+
+  if (entry->dirty) {
+    _statistics.writesCoalesced++;
+  } else {
+    if (_pending == 0) {
+      _pendingSince = millis();
+    }
+    _pending++;
+  }
+  entry->type = type;
+  entry->value.assign(static_cast<const char*>(value), len);
+  entry->size = len;
+  entry->crc = crc;
+  entry->present = true;
+  entry->cached = true;
+  entry->dirty = true;
+
+  // wait for it to get quiet, but not forever
+  if (_flushTask != nullptr && millis() - _pendingSince < CONFIG_THINGY_CONFIG_FLUSH_MAX_DELAY) {
+    _flushTask->restartDelayed(CONFIG_THINGY_CONFIG_FLUSH_DELAY * TASK_MILLISECOND);
+  }
+}
+
+void Soylent::ConfigClass::_flushCallback() {
+  flush();
+}
+
+// NVS entries taken by a value: primitives take one, strings a header and their data (with the terminating 0),
+// blobs an index, a header for their data and the data itself
+uint32_t Soylent::ConfigClass::_entriesOf(Type type, size_t size) {
+  switch (type) {
+    case Type::STRING:
+      return 1 + (size + 1 + NVS_ENTRY_BYTES - 1) / NVS_ENTRY_BYTES;
+    case Type::BYTES:
+      return 2 + (size + NVS_ENTRY_BYTES - 1) / NVS_ENTRY_BYTES;
+    default:
+      return 1;
+  }
+}
+
+#ifdef ARDUINO
+bool Soylent::ConfigClass::_read(const std::string& space, const std::string& key, Type type, std::string* value) {
+  Preferences preferences;
+  // (there's nothing to read when the namespace doesn't exist yet)
+  if (!preferences.begin(space.c_str(), true)) {
+    return false;
+  }
+
+  bool found = preferences.isKey(key.c_str());
+  if (found) {
+    switch (type) {
+      case Type::STRING: {
+        String string = preferences.getString(key.c_str());
+        value->assign(string.c_str(), string.length());
+        break;
+      }
+      case Type::ULONG: {
+        uint32_t ulong = preferences.getULong(key.c_str());
+        value->assign(reinterpret_cast<const char*>(&ulong), sizeof(ulong));
+        break;
+      }
+      case Type::BOOL:
+        value->assign(1, preferences.getBool(key.c_str()) ? 1 : 0);
+        break;
+      case Type::BYTES:
+        value->resize(preferences.getBytesLength(key.c_str()));
+        if (!value->empty() && preferences.getBytes(key.c_str(), &(*value)[0], value->size()) != value->size()) {
+          value->clear();
+          found = false;
+        }
+        break;
+    }
+  }
+  preferences.end();
+  return found;
+}
+
+bool Soylent::ConfigClass::_write(const std::string& space, const std::string& key, Type type, const std::string& value) {
+  Preferences preferences;
+  if (!preferences.begin(space.c_str(), false)) {
+    return false;
+  }
+
+  size_t written = 0;
+  switch (type) {
+    case Type::STRING:
+      written = preferences.putString(key.c_str(), value.c_str());
+      break;
+    case Type::ULONG: {
+      uint32_t ulong;
+      memcpy(&ulong, value.data(), sizeof(ulong));
+      written = preferences.putULong(key.c_str(), ulong);
+      break;
+    }
+    case Type::BOOL:
+      written = preferences.putBool(key.c_str(), value[0] != 0);
+      break;
+    case Type::BYTES:
+      written = preferences.putBytes(key.c_str(), value.data(), value.size());
+      break;
+  }
+  preferences.end();
+  // (an empty string is written as 0 bytes)
+  return type == Type::STRING ? written == value.size() : written > 0;
+}
+#else
+// NVS simulated in RAM, for builds on the host
+static std::map<std::string, std::string>& simulatedNvs() {
+  static std::map<std::string, std::string> nvs;
+  return nvs;
+}
+
+bool Soylent::ConfigClass::_read(const std::string& space, const std::string& key, __unused Type type, std::string* value) {
+  auto found = simulatedNvs().find(space + "/" + key);
+  if (found == simulatedNvs().end()) {
+    return false;
+  }
+  *value = found->second;
+  return true;
+}
+
+bool Soylent::ConfigClass::_write(const std::string& space, const std::string& key, __unused Type type, const std::string& value) {
+  simulatedNvs()[space + "/" + key] = value;
+  return true;
+}
+#endif
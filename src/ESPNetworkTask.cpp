@@ -17,13 +17,8 @@ void Soylent::ESPNetworkClass::begin(Scheduler* scheduler) {
     _espConnect.end();
 
   // get some info from espconnect's preferences
-  Preferences preferences;
-  preferences.begin("espconnect", true);
-  std::string ssid;
-  if (preferences.isKey("ssid"))
-    ssid = preferences.getString("ssid").c_str();
-  bool ap = preferences.isKey("ap") ? preferences.getBool("ap", false) : false;
-  preferences.end();
+  std::string ssid = Config.getString("espconnect", "ssid");
+  bool ap = Config.getBool("espconnect", "ap", false);
 
   if (ssid.empty() || ap) {
     LOGI(TAG, "Trying to start captive portal in the background...");
@@ -40,7 +35,7 @@ void Soylent::ESPNetworkClass::begin(Scheduler* scheduler) {
 
   // Task handling
   _scheduler = scheduler;
-  _espConnectTask = new Task(TASK_IMMEDIATE, TASK_FOREVER, [&] { _espConnectCallback(); }, _scheduler, false, NULL, NULL, true);
+  _espConnectTask = new Task(CONFIG_THINGY_NETWORK_LOOP_INTERVAL, TASK_FOREVER, [&] { _espConnectCallback(); }, _scheduler, false, NULL, NULL, true);
   _espConnectTask->enable();
 
   LOGD(TAG, "ESPConnect is scheduled for start...");
@@ -28,10 +28,17 @@ void Soylent::ESPRestartClass::restartDelayed(uint32_t delayBeforeCleanup = 500,
 }
 
 void Soylent::ESPRestartClass::_cleanupCallback() {
+  TRACE_SCOPE("restart.cleanupCallback");
   // Do some cleanup...
+  LedStream.end();
+  TimeSync.end();
   WebSite.end();
   WebServer.end();
   ESPNetwork.end();
+  // the LED comes back up as it is (see LedResume.h)
+  Led.persist();
+  // settings not written yet
+  Config.flush();
 
   // ...and finally, the Restart-Task can be enabled subsequently
   _restartTask->enableDelayed(_delayBeforeRestart);
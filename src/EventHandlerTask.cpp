@@ -6,7 +6,7 @@
 #define TAG "EventHandler"
 
 Soylent::EventHandlerClass::EventHandlerClass(Soylent::ESPNetworkClass& espNetwork)
-    : _state(Soylent::ESPConnect::State::NETWORK_DISABLED), _scheduler(nullptr), _espNetwork(&espNetwork) {
+    : _state(Soylent::ESPConnect::State::NETWORK_DISABLED), _scheduler(nullptr), _espNetwork(&espNetwork), _connectedAt(0) {
 }
 
 void Soylent::EventHandlerClass::begin(Scheduler* scheduler) {
@@ -31,21 +31,34 @@ Soylent::ESPConnect::State Soylent::EventHandlerClass::getState() {
   return _state;
 }
 
+uint32_t Soylent::EventHandlerClass::getConnectedAt() {
+  return _connectedAt;
+}
+
 // Handle events from ESPConnect
 void Soylent::EventHandlerClass::_stateCallback(Soylent::ESPConnect::State state) {
+  TRACE_SCOPE("network.stateCallback");
   _state = state;
 
   switch (state) {
     case Soylent::ESPConnect::State::NETWORK_CONNECTED:
+      if (_connectedAt == 0) {
+        _connectedAt = micros();
+      }
       LOGI(TAG, "--> Connected to network...");
       yield();
       LOGI(TAG, "IPAddress: %s", _espNetwork->getESPConnect()->getIPAddress().toString().c_str());
       WebServer.begin(_scheduler);
       yield();
       WebSite.begin(_scheduler);
+      LedStream.begin(_scheduler);
+      TimeSync.begin(_scheduler);
       break;
 
     case Soylent::ESPConnect::State::AP_STARTED:
+      if (_connectedAt == 0) {
+        _connectedAt = micros();
+      }
       LOGI(TAG, "--> Created AP...");
       yield();
       LOGI(TAG, "SSID: %s", _espNetwork->getESPConnect()->getAccessPointSSID().c_str());
@@ -53,6 +66,8 @@ void Soylent::EventHandlerClass::_stateCallback(Soylent::ESPConnect::State state
       WebServer.begin(_scheduler);
       yield();
       WebSite.begin(_scheduler);
+      LedStream.begin(_scheduler);
+      TimeSync.begin(_scheduler);
       break;
 
     case Soylent::ESPConnect::State::PORTAL_STARTED:
@@ -65,8 +80,8 @@ void Soylent::EventHandlerClass::_stateCallback(Soylent::ESPConnect::State state
 
     case Soylent::ESPConnect::State::NETWORK_DISCONNECTED:
       LOGI(TAG, "--> Disconnected from network...");
-      WebSite.end();
-      WebServer.end();
+      // keep routes and handlers for the reconnect, just stop listening
+      WebServer.suspend();
       break;
 
     case Soylent::ESPConnect::State::PORTAL_COMPLETE: {
@@ -81,4 +96,7 @@ void Soylent::EventHandlerClass::_stateCallback(Soylent::ESPConnect::State state
     default:
       break;
   } /* switch (_state) */
+
+  // tasks might have been added to the scheduler
+  Power.wake();
 }
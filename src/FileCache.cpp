@@ -0,0 +1,151 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+/*
+ * Copyright (C) 2025 Robert Wendlandt
+ */
+#include <thingy.h>
+#include <algorithm>
+#include <cinttypes>
+#include <cstring>
+#define TAG "FileCache"
+
+Soylent::FileCache::FileCache(fs::FS& fs, size_t capacity, size_t maxFile)
+    : _fs(&fs), _capacity(capacity), _maxFile(std::min(maxFile, capacity)), _clock(0), _generation(0), _cachedGeneration(0), _statistics() {
+}
+
+void Soylent::FileCache::send(AsyncWebServerRequest* request, const std::string& path, const char* cacheControl) {
+  // the file system changed (or is about to)
+  uint32_t generation = _generation.load();
+  if (generation != _cachedGeneration) {
+    _entries.clear();
+    _statistics.bytes = 0;
+    _cachedGeneration = generation;
+  }
+
+  _clock++;
+  Entry* entry = _find(path);
+  if (entry != nullptr) {
+    _statistics.hits++;
+  } else {
+    entry = _load(path);
+    if (entry == nullptr) {
+      // too large, or not there at all (404)
+      request->send(*_fs, String(path.c_str()));
+      return;
+    }
+    _statistics.misses++;
+  }
+  entry->usedAt = _clock;
+
+  char etag[11];
+  snprintf(etag, sizeof(etag), "\"%08" PRIx32 "\"", entry->crc);
+  AsyncWebServerResponse* response;
+  const AsyncWebHeader* ifNoneMatch = request->getHeader("If-None-Match");
+  if (ifNoneMatch != nullptr && strstr(ifNoneMatch->value().c_str(), etag) != nullptr) {
+    _statistics.notModified++;
+    response = request->beginResponse(304);
+  } else {
+    // the response keeps the content alive, even if the entry is dropped meanwhile
+    std::shared_ptr<const std::vector<uint8_t>> content = entry->content;
+    response = request->beginResponse(entry->type, content->size(), [content](uint8_t* buffer, size_t maxLen, size_t index) -> size_t {
+      size_t len = std::min(maxLen, content->size() - index);
+      memcpy(buffer, content->data() + index, len);
+      return len;
+    });
+    if (entry->gzip) {
+      response->addHeader("Content-Encoding", "gzip");
+    }
+  }
+  response->addHeader("ETag", etag);
+  if (cacheControl != nullptr) {
+    response->addHeader("Cache-Control", cacheControl);
+  }
+  request->send(response);
+}
+
+void Soylent::FileCache::invalidate() {
+  _generation++;
+}
+
+const Soylent::FileCache::Statistics& Soylent::FileCache::getStatistics() {
+  _statistics.files = _entries.size();
+  _statistics.invalidations = _generation.load();
+  return _statistics;
+}
+
+Soylent::FileCache::Entry* Soylent::FileCache::_find(const std::string& path) {
+  for (Entry& entry : _entries) {
+    if (entry.path == path) {
+      return &entry;
+    }
+  }
+  return nullptr;
+}
+
+// read a file (or its gzipped version, like serveStatic does), nullptr if it's not to be kept
+Soylent::FileCache::Entry* Soylent::FileCache::_load(const std::string& path) {
+  bool gzip = false;
+  if (!_fs->exists(path.c_str())) {
+    if (!_fs->exists((path + ".gz").c_str())) {
+      return nullptr;
+    }
+    gzip = true;
+  }
+  File file = _fs->open(gzip ? (path + ".gz").c_str() : path.c_str(), "r");
+  if (!file || file.isDirectory()) {
+    return nullptr;
+  }
+  size_t size = file.size();
+  if (size > _maxFile) {
+    file.close();
+    _statistics.bypassed++;
+    return nullptr;
+  }
+
+  auto content = std::make_shared<std::vector<uint8_t>>(size);
+  size_t read = file.read(content->data(), size);
+  file.close();
+  if (read != size) {
+    LOGW(TAG, "Reading %s failed!", path.c_str());
+    return nullptr;
+  }
+
+  _evict(size);
+  _entries.push_back({path, content, _typeOf(path), gzip, crcx::crc32(content->data(), size), _clock});
+  _statistics.bytes += size;
+  LOGD(TAG, "Keeping %s (%u bytes, %u files, %" PRIu32 " bytes in total)", path.c_str(), static_cast<unsigned>(size), static_cast<unsigned>(_entries.size()), _statistics.bytes);
+  return &_entries.back();
+}
+
+// make room for another file, dropping the least recently used ones
+void Soylent::FileCache::_evict(size_t needed) {
+  while (!_entries.empty() && _statistics.bytes + needed > _capacity) {
+    auto leastRecentlyUsed = std::min_element(_entries.begin(), _entries.end(), [](const Entry& a, const Entry& b) {
+      return static_cast<int32_t>(a.usedAt - b.usedAt) < 0;
+    });
+    _statistics.bytes -= leastRecentlyUsed->content->size();
+    _statistics.evictions++;
+    _entries.erase(leastRecentlyUsed);
+  }
+}
+
+const char* Soylent::FileCache::_typeOf(const std::string& path) {
+  static constexpr struct {
+      const char* extension;
+      const char* type;
+  } TYPES[] = {
+    {".svg", "image/svg+xml"},
+    {".png", "image/png"},
+    {".jpg", "image/jpeg"},
+    {".gif", "image/gif"},
+    {".ico", "image/x-icon"},
+    {".json", "application/json"},
+    {".html", "text/html"},
+  };
+  for (const auto& type : TYPES) {
+    size_t length = strlen(type.extension);
+    if (path.size() >= length && path.compare(path.size() - length, length, type.extension) == 0) {
+      return type.type;
+    }
+  }
+  return "application/octet-stream";
+}
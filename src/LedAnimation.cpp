@@ -0,0 +1,163 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+/*
+ * Copyright (C) 2025 Robert Wendlandt
+ */
+#include <thingy.h>
+#include <LittleFS.h>
+#define TAG "LedAnimation"
+
+bool Soylent::LedAnimation::Player::open(const char* path) {
+  close();
+  _file = LittleFS.open(path, "r");
+  if (!_file || _file.isDirectory()) {
+    LOGE(TAG, "Can't open %s!", path);
+    return false;
+  }
+
+  if (_file.read(reinterpret_cast<uint8_t*>(&_header), sizeof(_header)) != sizeof(_header) ||
+      memcmp(_header.magic, LED_ANIMATION_MAGIC, sizeof(_header.magic)) != 0 || _header.version != LED_ANIMATION_VERSION ||
+      _header.frameRate == 0 || _header.pixelCount == 0 || _header.frameCount == 0) {
+    LOGE(TAG, "%s is not an animation!", path);
+    close();
+    return false;
+  }
+
+  if (_header.pixelCount != CONFIG_THINGY_LED_COUNT) {
+    LOGW(TAG, "%s has %d pixels, showing %d of them", path, _header.pixelCount, CONFIG_THINGY_LED_COUNT);
+  }
+  LOGI(TAG, "Playing %s (%" PRIu32 " frames at %d fps)", path, _header.frameCount, _header.frameRate);
+  return true;
+}
+
+void Soylent::LedAnimation::Player::close() {
+  if (_file) {
+    _file.close();
+  }
+  _frame = 0;
+  _length = 0;
+  _position = 0;
+}
+
+// Fill the read-ahead buffer
+bool Soylent::LedAnimation::Player::_refill() {
+  _length = _file.read(_buffer, sizeof(_buffer));
+  _position = 0;
+  _statistics->reads++;
+  return _length > 0;
+}
+
+// The next byte of the file, -1 at its end
+int Soylent::LedAnimation::Player::_read() {
+  if (_position == _length && !_refill()) {
+    return -1;
+  }
+  return _buffer[_position++];
+}
+
+// XOR the next count bytes of the file onto raw[offset...] (as far as it goes)
+bool Soylent::LedAnimation::Player::_xor(uint8_t* raw, uint32_t offset, uint16_t count) {
+  constexpr uint32_t size = sizeof(CRGB) * CONFIG_THINGY_LED_COUNT;
+  while (count > 0) {
+    if (_position == _length && !_refill()) {
+      return false;
+    }
+    // straight from the buffer, as much as there is
+    uint16_t chunk = std::min<uint16_t>(count, _length - _position);
+    for (uint16_t i = 0; i < chunk && offset + i < size; i++) {
+      raw[offset + i] ^= _buffer[_position + i];
+    }
+    _position += chunk;
+    offset += chunk;
+    count -= chunk;
+  }
+  return true;
+}
+
+bool Soylent::LedAnimation::Player::next(CRGB* pixels) {
+  uint32_t startedAt = micros();
+  // loop back to the first frame
+  if (_frame == _header.frameCount) {
+    _file.seek(sizeof(_header));
+    _frame = 0;
+    _length = 0;
+    _position = 0;
+  }
+
+  int type = _read();
+  int lengthLow = _read();
+  int lengthHigh = _read();
+  if (lengthHigh < 0 || (type != FrameType::KEYFRAME && (type != FrameType::DELTA || _frame == 0))) {
+    LOGE(TAG, "Frame %" PRIu32 " is broken!", _frame);
+    _statistics->errors++;
+    return false;
+  }
+
+  if (type == FrameType::KEYFRAME) {
+    fill_solid(pixels, CONFIG_THINGY_LED_COUNT, CRGB::Black);
+    _statistics->keyframes++;
+  }
+
+  uint8_t* raw = pixels[0].raw;
+  uint32_t offset = 0;
+  uint16_t length = lengthLow | (lengthHigh << 8);
+  uint16_t consumed = 0;
+  while (consumed < length) {
+    int op = _read();
+    if (op < 0) {
+      break;
+    }
+    consumed++;
+    if (op < 0x80) {
+      offset += op + 1;
+    } else {
+      uint16_t count = op - 0x7F;
+      if (consumed + count > length || !_xor(raw, offset, count)) {
+        break;
+      }
+      offset += count;
+      consumed += count;
+    }
+  }
+  if (consumed != length || offset > sizeof(CRGB) * _header.pixelCount) {
+    LOGE(TAG, "Frame %" PRIu32 " is broken!", _frame);
+    _statistics->errors++;
+    return false;
+  }
+  _frame++;
+
+  uint32_t decodeTime = micros() - startedAt;
+  _statistics->decodeTimeSum += decodeTime;
+  if (decodeTime > _statistics->decodeTimeMax) {
+    _statistics->decodeTimeMax = decodeTime;
+  }
+  _statistics->frames++;
+  return true;
+}
+
+size_t Soylent::LedAnimation::encode(const uint8_t* from, const uint8_t* to, uint32_t size, uint8_t* ops) {
+  size_t length = 0;
+  uint32_t i = 0;
+  while (i < size) {
+    uint32_t run = 1;
+    if (from[i] == to[i]) {
+      while (i + run < size && run < 0x80 && from[i + run] == to[i + run]) {
+        run++;
+      }
+      // skipping the rest of the frame is implicit
+      if (i + run < size) {
+        ops[length++] = run - 1;
+      }
+    } else {
+      // a single unchanged byte in between is cheaper to send than to skip
+      while (i + run < size && run < 0x80 && (from[i + run] != to[i + run] || (i + run + 1 < size && from[i + run + 1] != to[i + run + 1]))) {
+        run++;
+      }
+      ops[length++] = 0x7F + run;
+      for (uint32_t j = i; j < i + run; j++) {
+        ops[length++] = from[j] ^ to[j];
+      }
+    }
+    i += run;
+  }
+  return length;
+}
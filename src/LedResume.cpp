@@ -0,0 +1,47 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+/*
+ * Copyright (C) 2025 Robert Wendlandt
+ */
+#include <thingy.h>
+#include <esp_attr.h>
+#include <esp_system.h>
+#define TAG "LedResume"
+
+// left alone by the bootloader and the startup code, garbage after a power loss (see the crc)
+RTC_NOINIT_ATTR static Soylent::LedResume::Snapshot rtcSnapshot;
+
+Soylent::LedResume::Source Soylent::LedResume::Store::load(Snapshot* snapshot) {
+  if (esp_reset_reason() != ESP_RST_POWERON && _isValid(rtcSnapshot)) {
+    *snapshot = rtcSnapshot;
+    return Source::RTC;
+  }
+
+  if (Config.getBytes("led", "resume", snapshot, sizeof(*snapshot)) == sizeof(*snapshot) && _isValid(*snapshot)) {
+    return Source::NVS;
+  }
+  return Source::NONE;
+}
+
+void Soylent::LedResume::Store::save(const Snapshot& snapshot) {
+  Snapshot saved = snapshot;
+  saved.magic = LED_RESUME_MAGIC;
+  saved.version = LED_RESUME_VERSION;
+  saved.reserved = 0;
+  saved.crc = _crcOf(saved);
+  rtcSnapshot = saved;
+
+  // NVS only needs to know the state, the clock is only of use in RTC memory
+  // (there's no telling how long the power was gone)
+  saved.clockOffset = 0;
+  saved.crc = _crcOf(saved);
+  Config.putBytes("led", "resume", &saved, sizeof(saved));
+}
+
+uint32_t Soylent::LedResume::Store::_crcOf(const Snapshot& snapshot) {
+  return crcx::crc32(reinterpret_cast<const uint8_t*>(&snapshot), offsetof(Snapshot, crc));
+}
+
+bool Soylent::LedResume::Store::_isValid(const Snapshot& snapshot) {
+  return snapshot.magic == LED_RESUME_MAGIC && snapshot.version == LED_RESUME_VERSION && snapshot.crc == _crcOf(snapshot) &&
+         memchr(snapshot.animationPath, '\0', sizeof(snapshot.animationPath)) != nullptr;
+}
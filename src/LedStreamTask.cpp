@@ -0,0 +1,225 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+/*
+ * Copyright (C) 2025 Robert Wendlandt
+ */
+#include <thingy.h>
+#include <cstring>
+#define TAG "LedStream"
+
+// DDP (see http://www.3waylabs.com/ddp/)
+#define DDP_HEADER_LEN      10
+#define DDP_FLAGS_VER_MASK  0xC0
+#define DDP_FLAGS_VER1      0x40
+#define DDP_FLAGS_PUSH      0x01
+#define DDP_FLAGS_QUERY     0x02
+#define DDP_FLAGS_TIMECODE  0x10
+#define DDP_SEQUENCE_MASK   0x0F
+#define DDP_ID_DISPLAY      1
+
+// E1.31 (sACN), single universe with the DMP layer at fixed offsets
+#define E131_HEADER_LEN     126
+#define E131_OFS_SEQUENCE   111
+#define E131_OFS_OPTIONS    112
+#define E131_OFS_UNIVERSE   113
+#define E131_OFS_PROP_COUNT 123
+#define E131_OFS_START_CODE 125
+#define E131_OPT_PREVIEW    0x80
+#define E131_OPT_TERMINATED 0x40
+
+static const uint8_t E131_ACN_ID[] = {0x41, 0x53, 0x43, 0x2d, 0x45, 0x31, 0x2e, 0x31, 0x37, 0x00, 0x00, 0x00};
+
+Soylent::LedStreamClass::LedStreamClass()
+    : _watchdogTask(nullptr), _scheduler(nullptr), _protocol(Protocol::NONE), _lastPacketAt(0), _packetsReceived(0), _packetsDropped(0), _lastDdpSequence(0), _lastE131Sequence(0), _streaming(false), _previousLedState(LedClass::LedState::OFF) {
+}
+
+void Soylent::LedStreamClass::begin(Scheduler* scheduler) {
+  // keep listening when we were started before (e.g. WiFi reconnected)
+  if (_ddp.connected() || _e131.connected()) {
+    return;
+  }
+
+  LOGD(TAG, "Start listening for DDP (%d) and E1.31 (%d)...", DDP_PORT, E131_PORT);
+  if (_ddp.listen(DDP_PORT)) {
+    _ddp.onPacket([&](AsyncUDPPacket& packet) { _onDDPPacket(packet); });
+  } else {
+    LOGE(TAG, "Can't listen on port %d!", DDP_PORT);
+  }
+
+  if (_e131.listen(E131_PORT)) {
+    _e131.onPacket([&](AsyncUDPPacket& packet) { _onE131Packet(packet); });
+  } else {
+    LOGE(TAG, "Can't listen on port %d!", E131_PORT);
+  }
+
+  // Task handling
+  _scheduler = scheduler;
+  // (only enabled while there is a stream, see _packetReceived())
+  if (_watchdogTask == nullptr) {
+    _watchdogTask = new Task(100 * TASK_MILLISECOND, TASK_FOREVER, [&] { _watchdogCallback(); }, _scheduler, false, NULL, NULL, false);
+  }
+
+  LOGD(TAG, "...done!");
+}
+
+void Soylent::LedStreamClass::end() {
+  LOGD(TAG, "Stop listening for streams...");
+  _ddp.close();
+  _e131.close();
+  if (_watchdogTask != nullptr) {
+    _watchdogTask->disable();
+  }
+  _protocol = Protocol::NONE;
+  _streaming = false;
+  LOGD(TAG, "...done!");
+}
+
+bool Soylent::LedStreamClass::isStreaming() {
+  return _streaming;
+}
+
+Soylent::LedStreamClass::Protocol Soylent::LedStreamClass::getProtocol() {
+  return _protocol;
+}
+
+uint32_t Soylent::LedStreamClass::getPacketsReceived() {
+  return _packetsReceived;
+}
+
+uint32_t Soylent::LedStreamClass::getPacketsDropped() {
+  return _packetsDropped;
+}
+
+// Switch the LED into (and out of) streaming, from within the scheduler
+void Soylent::LedStreamClass::_watchdogCallback() {
+  if (_protocol == Protocol::NONE) {
+    return;
+  }
+
+  if (millis() - _lastPacketAt > CONFIG_THINGY_STREAM_TIMEOUT) {
+    LOGI(TAG, "Stream timed out, back to previous LED state");
+    _protocol = Protocol::NONE;
+    _streaming = false;
+    _lastDdpSequence = 0;
+    _lastE131Sequence = 0;
+    if (Led.getLedState() == LedClass::LedState::STREAM) {
+      Led.setLedState(_previousLedState);
+    }
+    // until the next stream
+    _watchdogTask->disable();
+    return;
+  }
+
+  if (!_streaming) {
+    LOGI(TAG, "Stream started (%s)", _protocol == Protocol::DDP ? "DDP" : "E1.31");
+    _streaming = true;
+    _previousLedState = Led.getLedState();
+    Led.setLedState(LedClass::LedState::STREAM);
+    // the packets received until now are in the frame buffer already, show them as soon as the LED is streaming
+    Led.showFrame();
+  }
+}
+
+// A valid packet of a stream was received, the watchdog starts with the first one
+// called in the async_udp task
+void Soylent::LedStreamClass::_packetReceived(Protocol protocol) {
+  _lastPacketAt = millis();
+  _protocol = protocol;
+  if (_watchdogTask != nullptr && !_watchdogTask->isEnabled()) {
+    _watchdogTask->enableIfNot();
+    Power.wake();
+  }
+}
+
+// Drop duplicated and out-of-order packets (by their sequence number, there's no time in them to tell a late one)
+// sequence numbers are running from 1 to range, 0 means: not used
+bool Soylent::LedStreamClass::_acceptSequence(uint16_t& lastSequence, uint16_t sequence, uint16_t range) {
+  if (sequence == 0) {
+    return true;
+  }
+
+  if (lastSequence != 0) {
+    uint16_t ahead = (sequence + range - lastSequence) % range;
+    if (ahead == 0 || ahead > range / 2) {
+      return false;
+    }
+  }
+
+  lastSequence = sequence;
+  return true;
+}
+
+// Copy received channels right into the frame buffer
+void Soylent::LedStreamClass::_writePixels(uint32_t offset, const uint8_t* data, size_t length) {
+  const size_t frameBufferLength = Led.getFrameBufferSize() * sizeof(CRGB);
+  if (offset >= frameBufferLength) {
+    return;
+  }
+
+  if (offset + length > frameBufferLength) {
+    length = frameBufferLength - offset;
+  }
+
+  // CRGB is laid out as plain r, g, b bytes
+  memcpy(reinterpret_cast<uint8_t*>(Led.getFrameBuffer()) + offset, data, length);
+  Led.frameChanged(offset / sizeof(CRGB), (offset % sizeof(CRGB) + length + sizeof(CRGB) - 1) / sizeof(CRGB));
+}
+
+void Soylent::LedStreamClass::_onDDPPacket(AsyncUDPPacket& packet) {
+  const uint8_t* data = packet.data();
+  size_t length = packet.length();
+  _packetsReceived++;
+
+  if (length < DDP_HEADER_LEN || (data[0] & DDP_FLAGS_VER_MASK) != DDP_FLAGS_VER1 || (data[0] & DDP_FLAGS_QUERY) || data[3] != DDP_ID_DISPLAY) {
+    _packetsDropped++;
+    return;
+  }
+
+  size_t headerLength = (data[0] & DDP_FLAGS_TIMECODE) ? DDP_HEADER_LEN + 4 : DDP_HEADER_LEN;
+  uint32_t offset = (data[4] << 24) | (data[5] << 16) | (data[6] << 8) | data[7];
+  size_t dataLength = (data[8] << 8) | data[9];
+  if (length < headerLength + dataLength || !_acceptSequence(_lastDdpSequence, data[1] & DDP_SEQUENCE_MASK, 15)) {
+    _packetsDropped++;
+    return;
+  }
+
+  _writePixels(offset, data + headerLength, dataLength);
+  _packetReceived(Protocol::DDP);
+
+  if (data[0] & DDP_FLAGS_PUSH) {
+    Led.showFrame();
+  }
+}
+
+void Soylent::LedStreamClass::_onE131Packet(AsyncUDPPacket& packet) {
+  const uint8_t* data = packet.data();
+  size_t length = packet.length();
+  _packetsReceived++;
+
+  if (length < E131_HEADER_LEN || memcmp(data + 4, E131_ACN_ID, sizeof(E131_ACN_ID)) != 0) {
+    _packetsDropped++;
+    return;
+  }
+
+  uint16_t universe = (data[E131_OFS_UNIVERSE] << 8) | data[E131_OFS_UNIVERSE + 1];
+  uint16_t propertyCount = (data[E131_OFS_PROP_COUNT] << 8) | data[E131_OFS_PROP_COUNT + 1];
+  if (universe != CONFIG_THINGY_STREAM_UNIVERSE
+      || data[E131_OFS_START_CODE] != 0
+      || (data[E131_OFS_OPTIONS] & (E131_OPT_PREVIEW | E131_OPT_TERMINATED))
+      || propertyCount < 1
+      || length < static_cast<size_t>(E131_OFS_START_CODE + propertyCount)) {
+    _packetsDropped++;
+    return;
+  }
+
+  // E1.31 is using 0...255 as sequence (without a reserved 0), shift it into our scheme
+  if (!_acceptSequence(_lastE131Sequence, data[E131_OFS_SEQUENCE] + 1, 256)) {
+    _packetsDropped++;
+    return;
+  }
+
+  _writePixels(0, data + E131_HEADER_LEN, propertyCount - 1);
+  _packetReceived(Protocol::E131);
+
+  // every packet is a complete universe
+  Led.showFrame();
+}
@@ -3,35 +3,63 @@
  * Copyright (C) 2024-2025 Robert Wendlandt
  */
 #include <thingy.h>
+#include <algorithm>
 #include <memory>
 #include <utility>
+#include <sys/time.h>
 #define TAG "LED"
 
-// default to LED_BUILTIN
+volatile bool Soylent::LedClass::_taskRunning = false;
+volatile bool Soylent::LedClass::_taskHeld = false;
+SemaphoreHandle_t Soylent::LedClass::_taskStopped = nullptr;
+
+// default to CONFIG_THINGY_LED_PIN (i.e. LED_BUILTIN)
 Soylent::LedClass::LedClass()
-    : _scheduler(nullptr), _ledState(Soylent::LedClass::LedState::NONE), _timeConstant(500), _async_task_handle(nullptr) {
+    : _resumedFrom(Soylent::LedResume::Source::NONE), _initializedAt(0), _scheduler(nullptr), _ledState(Soylent::LedClass::LedState::NONE), _ledPin(CONFIG_THINGY_LED_PIN), _timeConstant(500), _hue(0), _previousState(Soylent::LedClass::LedState::NONE), _previousTimeConstant(500), _previousHue(0), _async_task_handle(nullptr), _output_task_handle(nullptr), _outputStopping(false), _outputStopped(nullptr) {
   _srBusy.setWaiting();
   _srInitialized.setWaiting();
   _srAnimated.signalComplete();
-
-#ifdef LED_BUILTIN
-  _ledPin = LED_BUILTIN;
-  #ifdef RGB_BUILTIN
-  _rgbLed = true;
-  #else
-  _rgbLed = false;
-  #endif
-#else
-  _ledPin = -1;
-  _rgbLed = false;
-#endif
+  _resetFrameBuffer();
+  _resetLayers();
 }
 
-Soylent::LedClass::LedClass(uint8_t LED_Pin, bool is_RGB)
-    : _scheduler(nullptr), _ledState(Soylent::LedClass::LedState::NONE), _timeConstant(500), _async_task_handle(nullptr), _ledPin(LED_Pin), _rgbLed(is_RGB) {
+Soylent::LedClass::LedClass(uint8_t LED_Pin)
+    : _resumedFrom(Soylent::LedResume::Source::NONE), _initializedAt(0), _scheduler(nullptr), _ledState(Soylent::LedClass::LedState::NONE), _ledPin(LED_Pin), _timeConstant(500), _hue(0), _previousState(Soylent::LedClass::LedState::NONE), _previousTimeConstant(500), _previousHue(0), _async_task_handle(nullptr), _output_task_handle(nullptr), _outputStopping(false), _outputStopped(nullptr) {
   _srBusy.setWaiting();
   _srInitialized.setWaiting();
   _srAnimated.completed();
+  _resetFrameBuffer();
+  _resetLayers();
+}
+
+void Soylent::LedClass::_resetFrameBuffer() {
+  fill_solid(_frameBuffer.pixels, CONFIG_THINGY_LED_COUNT, CRGB::Black);
+  _frameBuffer.ready = nullptr;
+  _frameBuffer.pushedAt = 0;
+  _frameBuffer.shown = 0;
+  _frameBuffer.latencySum = 0;
+  _frameBuffer.latencyMax = 0;
+  _frameBuffer.changedFirst = 0;
+  _frameBuffer.changedEnd = CONFIG_THINGY_LED_COUNT;
+  _power.reset();
+  _dither.reset();
+  _pipeline.reset();
+  _animation.frames = 0;
+  _animation.keyframes = 0;
+  _animation.reads = 0;
+  _animation.errors = 0;
+  _animation.decodeTimeSum = 0;
+  _animation.decodeTimeMax = 0;
+  _animationPath[0] = '\0';
+}
+
+void Soylent::LedClass::_resetLayers() {
+  for (auto& layer : _layerStack.layers) {
+    layer.ledState = static_cast<int8_t>(LedState::NONE);
+  }
+  _layerStack.frames = 0;
+  _layerStack.frameTimeSum = 0;
+  _layerStack.frameTimeMax = 0;
 }
 
 void Soylent::LedClass::begin(Scheduler* scheduler) {
@@ -41,6 +69,19 @@ void Soylent::LedClass::begin(Scheduler* scheduler) {
   _scheduler = scheduler;
   _ledState = Soylent::LedClass::LedState::NONE;
   _timeConstant = 500;
+  _previousState = Soylent::LedClass::LedState::NONE;
+  _resetLayers();
+
+  // the semaphore lives as long as we do, it's shared with the streaming sources
+  if (_frameBuffer.ready == nullptr) {
+    _frameBuffer.ready = xSemaphoreCreateBinary();
+  }
+  if (_outputStopped == nullptr) {
+    _outputStopped = xSemaphoreCreateBinary();
+  }
+  if (_taskStopped == nullptr) {
+    _taskStopped = xSemaphoreCreateBinary();
+  }
 
   // create and run a task for initializing the LED
   Task* initializeLedTask = new Task(TASK_IMMEDIATE, TASK_ONCE, [&] { _initializeLedCallback(); }, _scheduler, false, NULL, NULL, true);
@@ -51,14 +92,21 @@ void Soylent::LedClass::begin(Scheduler* scheduler) {
 
 void Soylent::LedClass::end() {
   LOGD(TAG, "Shutting down LED...");
-  if (_async_task_handle != nullptr) {
-    vTaskDelete(_async_task_handle);
-    _async_task_handle = nullptr;
+  _stopTask();
+  if (_output_task_handle != nullptr) {
+    // let the output task finish the frame it might be showing, it deletes itself afterwards
+    _pipeline.setConsumer(nullptr);
+    _outputStopping = true;
+    xTaskNotifyGive(_output_task_handle);
+    // (showing a frame takes a few ms at most)
+    if (xSemaphoreTake(_outputStopped, pdMS_TO_TICKS(100)) != pdTRUE) {
+      LOGW(TAG, "LED output didn't stop in time!");
+    }
+    _output_task_handle = nullptr;
   }
 
-  if (digitalRead(_ledPin) && _ledPin != -1) {
-    digitalWrite(_ledPin, LOW);
-  }
+  Output::fill(_ledPin, CRGB::Black);
+  _power.fill(CRGB::Black);
 
   _srBusy.setWaiting();
   _srInitialized.setWaiting();
@@ -87,19 +135,129 @@ static bool customTaskCreateUniversal(
 
 // Initialize the LED
 void Soylent::LedClass::_initializeLedCallback() {
+  TRACE_SCOPE("led.initializeLedCallback");
   LOGD(TAG, "Initialize LED...");
 
-  // set LED-pin to out?
-  _ledState = Soylent::LedClass::LedState::OFF;
+  Output::begin(_ledPin);
+  _initializedAt = micros();
+  _resumeState();
+
+  // frames rendered are shipped to the output by a task of its own (see LedPipeline.h)
+  if constexpr (pipelined) {
+    if (_output_task_handle == nullptr) {
+      _outputStopping = false;
+      customTaskCreateUniversal(_outputTask,
+                                "ledOutputTask",
+                                CONFIG_THINGY_TASKS_STACK_SIZE,
+                                static_cast<void*>(this),
+                                CONFIG_THINGY_LED_OUTPUT_PRIORITY,
+                                &_output_task_handle,
+                                CONFIG_THINGY_LED_OUTPUT_CORE);
+      _pipeline.setConsumer(_output_task_handle);
+    }
+  }
 
   _srInitialized.signalComplete();
   LOGD(TAG, "...done!");
 
   // create and run a task for creating and running an async task for setting the LED...
-  LOGD(TAG, "setting LED to off...");
+  LOGD(TAG, "setting LED to %d...", static_cast<int>(_ledState));
   _setLedCallback();
 }
 
+// time of day in us, it keeps on counting across restarts (but not across a power loss)
+static int64_t timeOfDay() {
+  struct timeval now;
+  gettimeofday(&now, nullptr);
+  return static_cast<int64_t>(now.tv_sec) * 1000000 + now.tv_usec;
+}
+
+// Pick up the LED state from before the restart, or start with the LED off
+void Soylent::LedClass::_resumeState() {
+  _ledState = Soylent::LedClass::LedState::OFF;
+  _resumedFrom = Soylent::LedResume::Source::NONE;
+  if constexpr (!CONFIG_THINGY_LED_RESUME) {
+    return;
+  }
+
+  Soylent::LedResume::Snapshot snapshot;
+  Soylent::LedResume::Source source = _resume.load(&snapshot);
+  if (source == Soylent::LedResume::Source::NONE) {
+    return;
+  }
+
+  LedState ledState = static_cast<LedState>(snapshot.ledState);
+  switch (ledState) {
+    case LedState::OFF:
+    case LedState::ON:
+    case LedState::BLINK:
+    case LedState::RAINBOW:
+      break;
+    case LedState::PLAYBACK:
+      if (snapshot.animationPath[0] != '\0') {
+        break;
+      }
+      [[fallthrough]];
+    default:
+      LOGW(TAG, "Can't resume LED state %d", snapshot.ledState);
+      return;
+  }
+
+  _ledState = ledState;
+  _timeConstant = snapshot.timeConstant;
+  _hue = snapshot.hue;
+  taskENTER_CRITICAL(&cs_spinlock);
+  strlcpy(_animationPath, snapshot.animationPath, sizeof(_animationPath));
+  taskEXIT_CRITICAL(&cs_spinlock);
+  // blinking and rainbow go on where they were (until synced to a leader)
+  if (snapshot.clockOffset != 0) {
+    TimeSync.setMicros(timeOfDay() + snapshot.clockOffset);
+  }
+  _resumedFrom = source;
+  LOGI(TAG, "Resuming LED state %d from %s", snapshot.ledState, source == Soylent::LedResume::Source::RTC ? "RTC memory" : "NVS");
+}
+
+// Keep the LED state for after a restart, only called from the loop task
+// (streams come back on their own and layers are just passing by)
+void Soylent::LedClass::_saveState() {
+  if constexpr (!CONFIG_THINGY_LED_RESUME) {
+    return;
+  }
+  if (_ledState == LedState::NONE || _ledState == LedState::STREAM) {
+    return;
+  }
+
+  Soylent::LedResume::Snapshot snapshot = {};
+  snapshot.ledState = static_cast<int8_t>(_ledState);
+  snapshot.hue = _hue;
+  snapshot.timeConstant = _timeConstant;
+  snapshot.clockOffset = TimeSync.getMicros() - timeOfDay();
+  taskENTER_CRITICAL(&cs_spinlock);
+  strlcpy(snapshot.animationPath, _animationPath, sizeof(snapshot.animationPath));
+  taskEXIT_CRITICAL(&cs_spinlock);
+  _resume.save(snapshot);
+}
+
+void Soylent::LedClass::persist() {
+  if constexpr (!CONFIG_THINGY_LED_RESUME) {
+    return;
+  }
+  // (the clock has moved on since)
+  _saveState();
+}
+
+Soylent::LedResume::Source Soylent::LedClass::getResumedFrom() {
+  return _resumedFrom;
+}
+
+uint32_t Soylent::LedClass::getInitializedAt() {
+  return _initializedAt;
+}
+
+uint32_t Soylent::LedClass::getFirstShownAt() {
+  return _pipeline.getFirstShownAt();
+}
+
 bool Soylent::LedClass::isInitialized() {
   return _srInitialized.completed();
 }
@@ -109,13 +267,485 @@ bool Soylent::LedClass::isBusy() {
 }
 
 bool Soylent::LedClass::isAnimated() {
-  return _srAnimated.pending();
+  // (dithering a steady color takes a single pixel per frame, and doesn't change what's seen)
+  return _srAnimated.pending() && !_dither.isSteady();
+}
+
+bool Soylent::LedClass::isStatic() {
+  // a dimmable LED is only lit as long as its PWM is clocked
+  return _srInitialized.completed() && !_srBusy.pending() && !isAnimated() && (!Output::dimmable || _ledState == LedState::OFF);
+}
+
+int32_t Soylent::LedClass::getTaskStackHighWater() {
+  // an animated task is still around (a one time setting is gone right after), it's held while its stack is walked
+  // (outside the lock)
+  TaskHandle_t task = nullptr;
+  taskENTER_CRITICAL(&cs_spinlock);
+  if (_srAnimated.pending() && _taskRunning) {
+    task = _async_task_handle;
+    _taskHeld = true;
+  }
+  taskEXIT_CRITICAL(&cs_spinlock);
+  if (task == nullptr) {
+    return -1;
+  }
+  int32_t highWater = uxTaskGetStackHighWaterMark(task);
+  _taskHeld = false;
+  return highWater;
+}
+
+int32_t Soylent::LedClass::getOutputTaskStackHighWater() {
+  return _output_task_handle != nullptr ? uxTaskGetStackHighWaterMark(_output_task_handle) : -1;
+}
+
+CRGB* Soylent::LedClass::getFrameBuffer() {
+  return _frameBuffer.pixels;
+}
+
+uint16_t Soylent::LedClass::getFrameBufferSize() {
+  return CONFIG_THINGY_LED_COUNT;
+}
+
+// Show the content of the frame buffer (only while in STREAM state)
+// safe to be called from other tasks
+void Soylent::LedClass::showFrame() {
+  if (_ledState != LedState::STREAM || _frameBuffer.ready == nullptr) {
+    return;
+  }
+
+  _frameBuffer.pushedAt = micros();
+  xSemaphoreGive(_frameBuffer.ready);
 }
 
+// Pixels [first, first + count) of the frame buffer were changed
+// safe to be called from other tasks
+void Soylent::LedClass::frameChanged(uint16_t first, uint16_t count) {
+  uint16_t end = std::min<uint32_t>(first + count, CONFIG_THINGY_LED_COUNT);
+  taskENTER_CRITICAL(&cs_spinlock);
+  if (first < _frameBuffer.changedFirst) {
+    _frameBuffer.changedFirst = first;
+  }
+  if (end > _frameBuffer.changedEnd) {
+    _frameBuffer.changedEnd = end;
+  }
+  taskEXIT_CRITICAL(&cs_spinlock);
+}
+
+const Soylent::LedPower::Budget& Soylent::LedClass::getPowerBudget() {
+  return _power;
+}
+
+const Soylent::LedDither::Dither& Soylent::LedClass::getDither() {
+  return _dither;
+}
+
+Soylent::LedPipeline::Pipeline& Soylent::LedClass::getPipeline() {
+  return _pipeline;
+}
+
+uint32_t Soylent::LedClass::getFramesShown() {
+  return _frameBuffer.shown;
+}
+
+uint32_t Soylent::LedClass::getFrameLatencyAvg() {
+  uint32_t shown = _frameBuffer.shown;
+  return shown ? _frameBuffer.latencySum / shown : 0;
+}
+
+uint32_t Soylent::LedClass::getFrameLatencyMax() {
+  return _frameBuffer.latencyMax;
+}
+
+// Play an animation file from LittleFS (see LedAnimation.h), over and over again
+void Soylent::LedClass::playAnimation(const char* path, uint32_t commandAt) {
+  taskENTER_CRITICAL(&cs_spinlock);
+  strlcpy(_animationPath, path, sizeof(_animationPath));
+  taskEXIT_CRITICAL(&cs_spinlock);
+
+  if (_ledState == LedState::PLAYBACK) {
+    // start over with the new file
+    if (commandAt != 0) {
+      _pipeline.command(commandAt);
+    }
+    _restartLed();
+  } else {
+    setLedState(LedState::PLAYBACK, commandAt);
+  }
+}
+
+const char* Soylent::LedClass::getAnimation() {
+  return _ledState == LedState::PLAYBACK ? _animationPath : nullptr;
+}
+
+const Soylent::LedAnimation::Statistics& Soylent::LedClass::getAnimationStatistics() {
+  return _animation;
+}
+
+// Put a LED state on top of the current one (NONE removes the layer again)
+// the layer is removed after duration ms, if not 0
+void Soylent::LedClass::setLayer(uint8_t layer, LedState ledState, uint8_t opacity, Soylent::LedCompositor::BlendMode blendMode, uint32_t duration) {
+  if (layer >= CONFIG_THINGY_LED_LAYERS) {
+    LOGW(TAG, "layer %d out of bounds!", layer);
+    return;
+  }
+
+  uint8_t hue = random(0, 255);
+  uint32_t until = duration ? std::max<uint32_t>(millis() + duration, 1) : 0;
+  taskENTER_CRITICAL(&cs_spinlock);
+  Soylent::LedCompositor::Layer& entry = _layerStack.layers[layer];
+  entry.ledState = static_cast<int8_t>(ledState);
+  entry.hue = hue;
+  entry.opacity = opacity;
+  entry.blendMode = blendMode;
+  entry.timeConstant = _timeConstantOf(ledState);
+  entry.until = until;
+  taskEXIT_CRITICAL(&cs_spinlock);
+
+  // the running task only knows about layers when it's started
+  _restartLed();
+}
+
+void Soylent::LedClass::clearLayer(uint8_t layer) {
+  setLayer(layer, LedState::NONE, 0, Soylent::LedCompositor::BlendMode::ALPHA);
+}
+
+bool Soylent::LedClass::getLayer(uint8_t layer, Soylent::LedCompositor::Layer* copy) {
+  if (layer >= CONFIG_THINGY_LED_LAYERS) {
+    return false;
+  }
+
+  taskENTER_CRITICAL(&cs_spinlock);
+  *copy = _layerStack.layers[layer];
+  taskEXIT_CRITICAL(&cs_spinlock);
+  return copy->ledState != static_cast<int8_t>(LedState::NONE);
+}
+
+uint32_t Soylent::LedClass::getLayerFrames() {
+  return _layerStack.frames;
+}
+
+uint32_t Soylent::LedClass::getLayerFrameTimeAvg() {
+  uint32_t frames = _layerStack.frames;
+  return frames ? _layerStack.frameTimeSum / frames : 0;
+}
+
+uint32_t Soylent::LedClass::getLayerFrameTimeMax() {
+  return _layerStack.frameTimeMax;
+}
+
+// Time constant (in ms) of the animated LED states
+uint32_t Soylent::LedClass::_timeConstantOf(LedState ledState) {
+  return ledState == LedState::RAINBOW ? 19 : 500;
+}
+
+// (the single color of a uniform frame, there's nothing to pack, whole frames go through Kernels)
 void Soylent::LedClass::_adjustLed(CRGB* led, const CRGB& adjustment) {
-  led->red = scale8(led->red, adjustment.red);
-  led->green = scale8(led->green, adjustment.green);
-  led->blue = scale8(led->blue, adjustment.blue);
+  Soylent::PixelKernels::Portable::scale(led, 1, adjustment);
+}
+
+// Ticks to wait until the next period (of timeConstant ms) starts
+TickType_t Soylent::LedClass::_ticksUntilNextPeriod(uint32_t now, uint32_t timeConstant) {
+  TickType_t ticks = pdMS_TO_TICKS(timeConstant - now % timeConstant);
+  return ticks > 0 ? ticks : 1;
+}
+
+// Fade a dimmable LED along the gamma curve, split into a few hardware fades
+// so we are woken up once per segment only instead of once per step
+// returns true, if we were asked to terminate in between
+bool Soylent::LedClass::_fadeLed(uint8_t pin, uint8_t to, uint32_t duration) {
+  uint8_t from = Output::level();
+  uint32_t elapsed = 0;
+  for (uint8_t i = 1; i <= LED_FADE_SEGMENTS; i++) {
+    LedGamma::Segment segment = LedGamma::segment(from, to, duration, i);
+    uint32_t segmentDuration = segment.end - elapsed;
+    elapsed = segment.end;
+    Output::fade(pin, segment.level, segmentDuration);
+    if (ulTaskNotifyTake(true, std::max<TickType_t>(pdMS_TO_TICKS(segmentDuration), 1)) == TERMINATE_YOURSELF) {
+      return true;
+    }
+  }
+  return false;
+}
+
+// Render a frame of a LED state at the (network) time now
+// the phase is derived from the network time, so all thingys are in the same color
+// returns true, if all pixels are showing the same color
+// the color adjustment is left to the output (see _show() and _fill())
+bool Soylent::LedClass::_renderFrame(LedState ledState, uint32_t timeConstant, uint8_t hue, uint32_t now, const FrameBuffer* frameBuffer, CRGB* pixels) {
+  CRGB led_color(CRGB::Black);
+  switch (ledState) {
+    case LedState::ON:
+      led_color = CHSV(hue, 240, 255);
+      break;
+    case LedState::BLINK: {
+      uint32_t period = now / timeConstant;
+      if (period & 1) {
+        // pick a "random" color from the rainbow, yet the same on all thingys
+        led_color = CHSV(((period >> 1) * 2654435761u) >> 24, 240, 255);
+      }
+      break;
+    }
+    case LedState::RAINBOW:
+      // loop through the the rainbow
+      led_color = CHSV(now / timeConstant, 240, 255);
+      break;
+    case LedState::STREAM:
+      memcpy(pixels, frameBuffer->pixels, sizeof(CRGB) * CONFIG_THINGY_LED_COUNT);
+      return false;
+    default:
+      break;
+  }
+
+  if constexpr (!Output::rgb) {
+    if (led_color) {
+      led_color = CRGB::White;
+    }
+  }
+  fill_solid(pixels, CONFIG_THINGY_LED_COUNT, led_color);
+  return true;
+}
+
+// Show a frame within the power budget, only the pixels [first, first + count) changed since the last one
+// the colors are adjusted per channel on the way out
+void Soylent::LedClass::_show(const LEDTaskParams& task_params, const CRGB* pixels, const CRGB& adjustment, uint16_t first, uint16_t count) {
+  task_params.power->update(pixels, first, count);
+  if constexpr (Output::dither) {
+    task_params.dither->setTarget(pixels, adjustment, task_params.power->getBrightness());
+    _showDithered(task_params);
+  } else {
+    Soylent::LedPipeline::Frame* frame = task_params.pipeline->back();
+    memcpy(frame->pixels, pixels, sizeof(frame->pixels));
+    if (adjustment != CRGB(CRGB::White)) {
+      Kernels::scale(frame->pixels, CONFIG_THINGY_LED_COUNT, adjustment);
+    }
+    frame->brightness = task_params.power->getBrightness();
+    frame->uniform = false;
+    _submit(task_params);
+  }
+}
+
+// Show a single color on all pixels within the power budget
+void Soylent::LedClass::_fill(const LEDTaskParams& task_params, const CRGB& color, const CRGB& adjustment) {
+  task_params.power->fill(color);
+  if constexpr (Output::dither) {
+    task_params.dither->setTarget(color, adjustment, task_params.power->getBrightness());
+    _showDithered(task_params);
+  } else {
+    Soylent::LedPipeline::Frame* frame = task_params.pipeline->back();
+    frame->pixels[0] = color;
+    _adjustLed(&frame->pixels[0], adjustment);
+    frame->brightness = task_params.power->getBrightness();
+    frame->uniform = true;
+    _submit(task_params);
+  }
+}
+
+// Show the next dithered frame (brightness and adjustment are already part of it)
+void Soylent::LedClass::_showDithered(const LEDTaskParams& task_params) {
+  uint32_t startedAt = micros();
+  Soylent::LedPipeline::Frame* frame = task_params.pipeline->back();
+  task_params.dither->next(frame->pixels);
+  frame->brightness = 255;
+  frame->uniform = task_params.dither->isUniform();
+  _submit(task_params);
+  task_params.dither->account(micros() - startedAt);
+}
+
+// Hand the frame rendered over to the output task, or show it right away without a pipeline
+void Soylent::LedClass::_submit(const LEDTaskParams& task_params) {
+  // the first frame after a command tells how long it took to answer it
+  task_params.pipeline->back()->commandAt = task_params.pipeline->stamp();
+  if constexpr (pipelined) {
+    task_params.pipeline->publish();
+  } else {
+    _output(task_params.ledPin, task_params.pipeline->back());
+    task_params.pipeline->shown(task_params.pipeline->back(), micros());
+  }
+}
+
+// Ship a frame to the LEDs
+void Soylent::LedClass::_output(uint8_t pin, const Soylent::LedPipeline::Frame* frame) {
+  if (frame->uniform) {
+    Output::fill(pin, frame->pixels[0], frame->brightness);
+  } else {
+    Output::show(pin, frame->pixels, CONFIG_THINGY_LED_COUNT, frame->brightness);
+  }
+}
+
+// The output stage of the pipeline, showing the latest frame whenever one is published
+void Soylent::LedClass::_outputTask(void* pvParameters) {
+  auto led = static_cast<Soylent::LedClass*>(pvParameters);
+  for (;;) {
+    ulTaskNotifyTake(true, portMAX_DELAY);
+    if (led->_outputStopping) {
+      xSemaphoreGive(led->_outputStopped);
+      vTaskDelete(NULL);
+    }
+    const Soylent::LedPipeline::Frame* frame = led->_pipeline.acquire();
+    if (frame != nullptr) {
+      _output(led->_ledPin, frame);
+      led->_pipeline.shown(frame, micros());
+    }
+  }
+}
+
+// Wait for the next step of an effect
+// meanwhile keep on dithering at CONFIG_THINGY_LED_DITHER_RATE, as long as there is anything to dither
+// returns true, if we were asked to terminate in between
+bool Soylent::LedClass::_wait(const LEDTaskParams& task_params, TickType_t ticks) {
+  if constexpr (Output::dither) {
+    const TickType_t ditherTicks = std::max<TickType_t>(pdMS_TO_TICKS(1000 / CONFIG_THINGY_LED_DITHER_RATE), 1);
+    const TickType_t start = xTaskGetTickCount();
+    TickType_t elapsed = 0;
+    while (task_params.dither->isFractional() && (ticks == portMAX_DELAY || elapsed + ditherTicks < ticks)) {
+      task_params.pipeline->expect(micros() + ditherTicks * portTICK_PERIOD_MS * 1000);
+      if (ulTaskNotifyTake(true, ditherTicks) == TERMINATE_YOURSELF) {
+        return true;
+      }
+      _showDithered(task_params);
+      elapsed = xTaskGetTickCount() - start;
+    }
+    if (ticks != portMAX_DELAY) {
+      ticks = elapsed < ticks ? ticks - elapsed : 0;
+    }
+  }
+
+  // the frame following the wait is due when it's over
+  if (ticks != portMAX_DELAY) {
+    task_params.pipeline->expect(micros() + ticks * portTICK_PERIOD_MS * 1000);
+  }
+  return ulTaskNotifyTake(true, ticks) == TERMINATE_YOURSELF;
+}
+
+// Crossfade from the previous to the current LED state at a constant frame rate
+// returns true, if we were asked to terminate in between
+bool Soylent::LedClass::_crossfade(const LEDTaskParams& task_params, const CRGB& adjustment) {
+  CRGB from[CONFIG_THINGY_LED_COUNT];
+  CRGB to[CONFIG_THINGY_LED_COUNT];
+  LedCrossfade::Timeline timeline(xTaskGetTickCount(), pdMS_TO_TICKS(CONFIG_THINGY_LED_TRANSITION_TIME), pdMS_TO_TICKS(1000 / CONFIG_THINGY_LED_FRAME_RATE));
+
+  for (TickType_t now = xTaskGetTickCount(); timeline.isRunning(now); now = xTaskGetTickCount()) {
+    // both states keep on running while being blended
+    uint32_t networkNow = TimeSync.getMillis();
+    bool uniform = _renderFrame(task_params.previousState, task_params.previousTimeConstant, task_params.previousHue, networkNow, task_params.frameBuffer, from);
+    uniform &= _renderFrame(task_params.ledState, task_params.timeConstant, task_params.hue, networkNow, task_params.frameBuffer, to);
+    Kernels::blend(from, to, CONFIG_THINGY_LED_COUNT, timeline.amountAt(now));
+    if (uniform) {
+      _fill(task_params, from[0], adjustment);
+    } else {
+      _show(task_params, from, adjustment);
+    }
+
+    if (_wait(task_params, timeline.next(xTaskGetTickCount()))) {
+      return true;
+    }
+  }
+
+  LOGD(TAG, "crossfade: %" PRIu32 " frames, %" PRIu32 " late", timeline.getFrames(), timeline.getLate());
+  return false;
+}
+
+// Remove expired layers
+// returns true, if there are any layers left
+bool Soylent::LedClass::_hasLayers(Soylent::LedCompositor::LayerStack* layerStack) {
+  bool hasLayers = false;
+  uint32_t now = millis();
+  taskENTER_CRITICAL(&cs_spinlock);
+  for (auto& layer : layerStack->layers) {
+    if (layer.until != 0 && static_cast<int32_t>(now - layer.until) >= 0) {
+      layer.ledState = static_cast<int8_t>(LedState::NONE);
+    }
+    hasLayers |= layer.ledState != static_cast<int8_t>(LedState::NONE);
+  }
+  taskEXIT_CRITICAL(&cs_spinlock);
+  return hasLayers;
+}
+
+// Composite the layers on top of the LED state at a constant frame rate, as long as there are any
+// returns true, if we were asked to terminate in between
+bool Soylent::LedClass::_composite(const LEDTaskParams& task_params, const CRGB& adjustment) {
+  CRGB pixels[CONFIG_THINGY_LED_COUNT];
+  CRGB layerPixels[CONFIG_THINGY_LED_COUNT];
+  Soylent::LedCompositor::Layer layers[CONFIG_THINGY_LED_LAYERS];
+  Soylent::LedCompositor::LayerStack* layerStack = task_params.layerStack;
+  const TickType_t frameTicks = std::max<TickType_t>(pdMS_TO_TICKS(1000 / CONFIG_THINGY_LED_FRAME_RATE), 1);
+  const TickType_t start = xTaskGetTickCount();
+  uint32_t frames = 0;
+
+  while (_hasLayers(layerStack)) {
+    uint32_t startedAt = micros();
+    // work on a snapshot, the layers might be changed meanwhile
+    taskENTER_CRITICAL(&cs_spinlock);
+    memcpy(layers, layerStack->layers, sizeof(layers));
+    taskEXIT_CRITICAL(&cs_spinlock);
+
+    // bottom up, starting with the LED state itself
+    uint32_t now = TimeSync.getMillis();
+    bool uniform = _renderFrame(task_params.ledState, task_params.timeConstant, task_params.hue, now, task_params.frameBuffer, pixels);
+    for (const auto& layer : layers) {
+      if (layer.ledState != static_cast<int8_t>(LedState::NONE)) {
+        uniform &= _renderFrame(static_cast<LedState>(layer.ledState), layer.timeConstant, layer.hue, now, task_params.frameBuffer, layerPixels);
+        Soylent::LedCompositor::blend(pixels, layerPixels, CONFIG_THINGY_LED_COUNT, layer.opacity, layer.blendMode);
+      }
+    }
+    if (uniform) {
+      _fill(task_params, pixels[0], adjustment);
+    } else {
+      _show(task_params, pixels, adjustment);
+    }
+
+    uint32_t frameTime = micros() - startedAt;
+    layerStack->frameTimeSum += frameTime;
+    if (frameTime > layerStack->frameTimeMax) {
+      layerStack->frameTimeMax = frameTime;
+    }
+    layerStack->frames++;
+
+    // wait for the next frame (counted from the start, so rendering time doesn't add up)
+    frames++;
+    int32_t wait = static_cast<int32_t>(start + frames * frameTicks - xTaskGetTickCount());
+    if (_wait(task_params, std::max<int32_t>(wait, 0))) {
+      return true;
+    }
+  }
+
+  return false;
+}
+
+// Play the animation frame by frame at its own frame rate
+// returns true, if we were asked to terminate in between
+bool Soylent::LedClass::_play(const LEDTaskParams& task_params, CRGB* pixels) {
+  char path[CONFIG_THINGY_LED_ANIMATION_PATH];
+  taskENTER_CRITICAL(&cs_spinlock);
+  strlcpy(path, task_params.animationPath, sizeof(path));
+  taskEXIT_CRITICAL(&cs_spinlock);
+
+  // frames are decoded on top of each other, starting black
+  fill_solid(pixels, CONFIG_THINGY_LED_COUNT, CRGB::Black);
+  Soylent::LedAnimation::Player player(task_params.animation);
+  if (!player.open(path)) {
+    _fill(task_params, CRGB::Black, CRGB::White);
+    return false;
+  }
+
+  const uint32_t period = player.getFramePeriod();
+  const uint32_t start = micros();
+  uint32_t frames = 0;
+  for (;;) {
+    if (!player.next(pixels)) {
+      _fill(task_params, CRGB::Black, CRGB::White);
+      return false;
+    }
+    // the animation comes with its own color correction (as streams do)
+    _show(task_params, pixels, CRGB::White);
+
+    // wait for the next frame (counted from the start, so decoding time doesn't add up)
+    frames++;
+    int32_t wait = static_cast<int32_t>(start + frames * period - micros());
+    if (_wait(task_params, wait > 0 ? pdMS_TO_TICKS(wait / 1000) : 0)) {
+      return true;
+    }
+  }
 }
 
 // set the LED state in a FreeRTOS-Task
@@ -124,148 +754,281 @@ void Soylent::LedClass::_async_setLedTask(void* pvParameters) {
   // the LEDTaskParams are free'd after signalling _srBusy as complete
   // copy params (as they will be gone otherwise during blinking)
   Soylent::LedClass::LEDTaskParams task_params(*params);
-  // adjust timeConstant to ticks
-  task_params.timeConstant /= portTICK_PERIOD_MS;
 
   // No LED present
-  if (task_params.ledPin == -1) {
+  if constexpr (!Output::present) {
     taskENTER_CRITICAL(&cs_spinlock);
     task_params.srAnimated->signalComplete();
     task_params.srBusy->signalComplete();
     taskEXIT_CRITICAL(&cs_spinlock);
 
-    vTaskDelete(NULL);
+    _exitTask();
   }
 
   // Calculate color adjustment
-  CRGB led_colorAdjustment = CRGB::computeAdjustment(128, CRGB(255, 85, 210), CRGB(UncorrectedTemperature));
+  // (at half brightness, plain LEDs are just white)
+  CRGB led_colorAdjustment = Output::rgb ? CRGB::computeAdjustment(128, CRGB(255, 85, 210), CRGB(UncorrectedTemperature)) : CRGB(CRGB::White);
+  CRGB pixels[CONFIG_THINGY_LED_COUNT];
 
-  // run a blinking task?
-  if (task_params.ledState == Soylent::LedClass::LedState::BLINK) {
-    taskENTER_CRITICAL(&cs_spinlock);
+  // crossfade from the previous state (dimmable LEDs are fading on their own, animations come with their own transitions)
+  bool crossfade = !Output::dimmable && CONFIG_THINGY_LED_TRANSITION_TIME > 0 && task_params.previousState != LedState::NONE &&
+                   task_params.previousState != task_params.ledState && task_params.previousState != LedState::PLAYBACK &&
+                   task_params.ledState != LedState::PLAYBACK;
+  // (a color in between two 8-bit values keeps on being dithered, a steady one doesn't make the LED animated though,
+  // a dimmable LED is fading into any state)
+  bool animated = task_params.ledState == LedState::BLINK || task_params.ledState == LedState::RAINBOW || task_params.ledState == LedState::STREAM ||
+                  task_params.ledState == LedState::PLAYBACK || (Output::dither && task_params.ledState == LedState::ON) || Output::dimmable ||
+                  _hasLayers(task_params.layerStack);
+
+  // the new state is taking over right now, so we are not busy anymore (but still might be terminated)
+  taskENTER_CRITICAL(&cs_spinlock);
+  if (crossfade || animated) {
     task_params.srAnimated->setWaiting();
-    task_params.srBusy->signalComplete();
+  }
+  task_params.srBusy->signalComplete();
+  taskEXIT_CRITICAL(&cs_spinlock);
+  TRACE_INSTANT("led.taskTookOver");
+  task_params.pipeline->takeOver();
+  if constexpr (Output::dimmable) {
+    // a dimmable LED starts fading right away
+    task_params.pipeline->shownDirectly(micros());
+  }
+  Power.wake();
+
+  if (crossfade && _crossfade(task_params, led_colorAdjustment)) {
+    taskENTER_CRITICAL(&cs_spinlock);
+    task_params.srAnimated->signalComplete();
     taskEXIT_CRITICAL(&cs_spinlock);
 
+    _exitTask();
+  }
+
+  // layers on top are composited frame by frame, until they are gone (not on top of animations, though)
+  if (task_params.ledState != LedState::PLAYBACK && _composite(task_params, led_colorAdjustment)) {
+    taskENTER_CRITICAL(&cs_spinlock);
+    task_params.srAnimated->signalComplete();
+    taskEXIT_CRITICAL(&cs_spinlock);
+
+    _exitTask();
+  }
+
+  // run a blinking task?
+  if (task_params.ledState == Soylent::LedClass::LedState::BLINK) {
     for (;;) {
-      if (task_params.rgbLed) {
-        rgbLedWrite(task_params.ledPin, 0, 0, 0);
+      uint32_t now = TimeSync.getMillis();
+      if constexpr (Output::dimmable) {
+        // fade softly on and off at the start of each period
+        uint8_t level = ((now / task_params.timeConstant) & 1) ? 255 : 0;
+        if (level != Output::level()) {
+          if (_fadeLed(task_params.ledPin, level, std::min<uint32_t>(CONFIG_THINGY_LED_FADE_TIME, task_params.timeConstant / 2))) {
+            taskENTER_CRITICAL(&cs_spinlock);
+            task_params.srAnimated->signalComplete();
+            taskEXIT_CRITICAL(&cs_spinlock);
+
+            _exitTask();
+          }
+          now = TimeSync.getMillis();
+        }
       } else {
-        digitalWrite(task_params.ledPin, LOW);
+        _renderFrame(task_params.ledState, task_params.timeConstant, task_params.hue, now, task_params.frameBuffer, pixels);
+        _fill(task_params, pixels[0], led_colorAdjustment);
       }
 
-      // either just wait for time constant or terminate ourselves
-      if (ulTaskNotifyTake(true, task_params.timeConstant) == TERMINATE_YOURSELF) {
+      // either just wait for the next period or terminate ourselves
+      if (_wait(task_params, _ticksUntilNextPeriod(now, task_params.timeConstant))) {
         taskENTER_CRITICAL(&cs_spinlock);
         task_params.srAnimated->signalComplete();
         taskEXIT_CRITICAL(&cs_spinlock);
-        digitalWrite(task_params.ledPin, LOW);
 
-        vTaskDelete(NULL);
+        _exitTask();
       }
-
-      if (task_params.rgbLed) {
-        // create a random color from the rainbow (at half brightness)
-        task_params.hue = random(0, 255);
-        CRGB led_color(CHSV(task_params.hue, 240, 255));
-        _adjustLed(&led_color, led_colorAdjustment);
-        rgbLedWrite(task_params.ledPin, led_color.red, led_color.green, led_color.blue);
-        LOGD(TAG, "hue: %d (%d, %d, %d)", task_params.hue, led_color.red, led_color.green, led_color.blue);
-      } else {
-        digitalWrite(task_params.ledPin, HIGH);
-      }
-
-      // either just wait for time constant or terminate ourselves
-      if (ulTaskNotifyTake(true, task_params.timeConstant) == TERMINATE_YOURSELF) {
+    }
+  } else if (task_params.ledState == Soylent::LedClass::LedState::STREAM) {
+    // show frames whenever they are pushed into the frame buffer
+    FrameBuffer* frameBuffer = task_params.frameBuffer;
+    // the frame buffer holds pixels the last state didn't show (e.g. from an earlier stream)
+    task_params.power->invalidate();
+    for (;;) {
+      // the semaphore is also given after we were asked to terminate
+      xSemaphoreTake(frameBuffer->ready, portMAX_DELAY);
+      if (ulTaskNotifyTake(true, 0) == TERMINATE_YOURSELF) {
         taskENTER_CRITICAL(&cs_spinlock);
         task_params.srAnimated->signalComplete();
         taskEXIT_CRITICAL(&cs_spinlock);
-        digitalWrite(task_params.ledPin, LOW);
 
-        vTaskDelete(NULL);
+        _exitTask();
+      }
+
+      // the stream comes with its own color correction, just account for what it has changed
+      taskENTER_CRITICAL(&cs_spinlock);
+      uint16_t changedFirst = frameBuffer->changedFirst;
+      uint16_t changedEnd = frameBuffer->changedEnd;
+      frameBuffer->changedFirst = CONFIG_THINGY_LED_COUNT;
+      frameBuffer->changedEnd = 0;
+      taskEXIT_CRITICAL(&cs_spinlock);
+      _show(task_params, frameBuffer->pixels, CRGB::White, changedFirst, changedEnd > changedFirst ? changedEnd - changedFirst : 0);
+
+      // a frame might already be in there when streaming has (re)started
+      if (frameBuffer->pushedAt != 0) {
+        uint32_t latency = micros() - frameBuffer->pushedAt;
+        frameBuffer->pushedAt = 0;
+        frameBuffer->latencySum += latency;
+        if (latency > frameBuffer->latencyMax) {
+          frameBuffer->latencyMax = latency;
+        }
+        frameBuffer->shown++;
       }
     }
+  } else if (task_params.ledState == Soylent::LedClass::LedState::PLAYBACK) {
+    // play an animation until being terminated
+    if (_play(task_params, pixels)) {
+      taskENTER_CRITICAL(&cs_spinlock);
+      task_params.srAnimated->signalComplete();
+      taskEXIT_CRITICAL(&cs_spinlock);
+
+      _exitTask();
+    }
+
+    // there is nothing left to show but black (and maybe dither it)
+    task_params.dither->setSteady(true);
+    _wait(task_params, portMAX_DELAY);
   } else if (task_params.ledState == Soylent::LedClass::LedState::RAINBOW) {
     // run a rainbow task?
-    taskENTER_CRITICAL(&cs_spinlock);
-    task_params.srAnimated->setWaiting();
-    task_params.srBusy->signalComplete();
-    taskEXIT_CRITICAL(&cs_spinlock);
-
     for (;;) {
-      if (task_params.rgbLed) {
-        // loop through the the rainbow (at half brightness)
-        CRGB led_color(CHSV(task_params.hue, 240, 255));
-        _adjustLed(&led_color, led_colorAdjustment);
-        task_params.hue++;
-        rgbLedWrite(task_params.ledPin, led_color.red, led_color.green, led_color.blue);
+      uint32_t now = TimeSync.getMillis();
+      if constexpr (Output::dimmable) {
+        // breathe in and out once per cycle through the rainbow, fading up in even and down in odd half cycles
+        uint32_t halfCycle = 128 * task_params.timeConstant;
+        uint8_t level = ((now / halfCycle) & 1) ? 0 : 255;
+        if (_fadeLed(task_params.ledPin, level, halfCycle - now % halfCycle)) {
+          taskENTER_CRITICAL(&cs_spinlock);
+          task_params.srAnimated->signalComplete();
+          taskEXIT_CRITICAL(&cs_spinlock);
+
+          _exitTask();
+        }
+        continue;
       } else {
-        digitalWrite(task_params.ledPin, HIGH);
+        _renderFrame(task_params.ledState, task_params.timeConstant, task_params.hue, now, task_params.frameBuffer, pixels);
+        _fill(task_params, pixels[0], led_colorAdjustment);
       }
 
-      // either just wait for time constant or terminate ourselves
-      if (ulTaskNotifyTake(true, task_params.timeConstant) == TERMINATE_YOURSELF) {
+      // either just wait for the next step or terminate ourselves
+      if (_wait(task_params, _ticksUntilNextPeriod(now, task_params.timeConstant))) {
         taskENTER_CRITICAL(&cs_spinlock);
         task_params.srAnimated->signalComplete();
         taskEXIT_CRITICAL(&cs_spinlock);
-        digitalWrite(task_params.ledPin, LOW);
 
-        vTaskDelete(NULL);
+        _exitTask();
       }
     }
   } else {
     // Just a one time setting here
-    if (task_params.rgbLed) {
-      if (task_params.ledState == Soylent::LedClass::LedState::OFF) {
-        rgbLedWrite(task_params.ledPin, 0, 0, 0);
-      } else {
-        // create a random color from the rainbow (at half brightness)
-        task_params.hue = random(0, 255);
-        CRGB led_color(CHSV(task_params.hue, 240, 255));
-        _adjustLed(&led_color, led_colorAdjustment);
-        rgbLedWrite(task_params.ledPin, led_color.red, led_color.green, led_color.blue);
-        LOGD(TAG, "hue: %d (%d, %d, %d)", task_params.hue, led_color.red, led_color.green, led_color.blue);
-      }
+    if constexpr (Output::dimmable) {
+      // a soft transition, left to the hardware
+      Output::fade(task_params.ledPin, (task_params.ledState == Soylent::LedClass::LedState::ON) ? 255 : 0, CONFIG_THINGY_LED_FADE_TIME);
     } else {
-      digitalWrite(task_params.ledPin, (task_params.ledState == Soylent::LedClass::LedState::ON) ? HIGH : LOW);
-      LOGD(TAG, "LED %s!", (task_params.ledState == Soylent::LedClass::LedState::ON) ? "on" : "off");
+      _renderFrame(task_params.ledState, task_params.timeConstant, task_params.hue, 0, task_params.frameBuffer, pixels);
+      _fill(task_params, pixels[0], led_colorAdjustment);
+    }
+    LOGD(TAG, "LED %s (hue: %d)!", (task_params.ledState == Soylent::LedClass::LedState::ON) ? "on" : "off", task_params.hue);
+
+    // dither until being terminated
+    if constexpr (Output::dither) {
+      if (task_params.dither->isFractional()) {
+        task_params.dither->setSteady(true);
+        _wait(task_params, portMAX_DELAY);
+      }
+    }
+
+    // the fade is only over once the hardware is done with it
+    if constexpr (Output::dimmable) {
+      _wait(task_params, pdMS_TO_TICKS(CONFIG_THINGY_LED_FADE_TIME));
     }
   }
 
   taskENTER_CRITICAL(&cs_spinlock);
   task_params.srAnimated->signalComplete();
-  task_params.srBusy->signalComplete();
   taskEXIT_CRITICAL(&cs_spinlock);
+  // the LED might be static now
+  Power.wake();
 
+  _exitTask();
+}
+
+// End the LED task running this, once nobody is holding on to it anymore
+// (_stopTask() waits for it, the next task must not run before it's gone: they'd share frames, dither and power budget)
+void Soylent::LedClass::_exitTask() {
+  taskENTER_CRITICAL(&cs_spinlock);
+  _taskRunning = false;
+  taskEXIT_CRITICAL(&cs_spinlock);
+  while (_taskHeld) {
+    vTaskDelay(1);
+  }
+  xSemaphoreGive(_taskStopped);
   vTaskDelete(NULL);
 }
 
-void Soylent::LedClass::_setLedCallback() {
-  _srBusy.setWaiting();
+// Ask the LED task to terminate (if it's still running) and wait until it's gone, only from the loop task
+void Soylent::LedClass::_stopTask() {
+  if (_async_task_handle == nullptr) {
+    return;
+  }
 
-  // possibly stop the blinking or rainbow task first
-  if (_srAnimated.pending()) {
-    if (_async_task_handle != nullptr) {
-      xTaskNotify(_async_task_handle, TERMINATE_YOURSELF, eSetValueWithOverwrite);
-      yield();
-    }
+  // the task can't go away while it's held
+  taskENTER_CRITICAL(&cs_spinlock);
+  bool running = _taskRunning;
+  _taskHeld = running;
+  taskEXIT_CRITICAL(&cs_spinlock);
+  if (running) {
+    xTaskNotify(_async_task_handle, TERMINATE_YOURSELF, eSetValueWithOverwrite);
+    // wake a streaming task waiting for its next frame
+    xSemaphoreGive(_frameBuffer.ready);
+    _taskHeld = false;
   }
 
+  // (every task tells once it's gone, even one that has ended on its own before)
+  if (xSemaphoreTake(_taskStopped, pdMS_TO_TICKS(1000)) != pdTRUE) {
+    LOGE(TAG, "LED task didn't stop in time!");
+  }
+  _async_task_handle = nullptr;
+}
+
+void Soylent::LedClass::_setLedCallback(uint16_t traceId) {
+  TRACE_SCOPE("led.setLedCallback");
+  _srBusy.setWaiting();
+  _saveState();
+
+  // stop the task before (e.g. blinking or rainbow) first, it might run on another core than we do
+  _stopTask();
+  // whatever the new task shows isn't steady (yet)
+  _dither.setSteady(false);
+
   // allocate and assemble the async parameters in a shared_ptr
-  auto p = std::make_shared<LEDTaskParams>(&_srBusy, &_srAnimated, _ledState, _ledPin, _rgbLed, _timeConstant, 0);
+  auto p = std::make_shared<LEDTaskParams>(&_srBusy, &_srAnimated, &_frameBuffer, &_layerStack, &_power, &_dither, &_pipeline, &_animation, _animationPath, _ledState, _ledPin, _timeConstant, _hue, _previousState, _previousTimeConstant, _previousHue);
   if (p) {
     // create the FreeRTOS-Task
-    customTaskCreateUniversal(_async_setLedTask, "setLedTask", CONFIG_THINGY_TASKS_STACK_SIZE,
-                              // pass the underlying pointer to LEDTaskParams from within shared_ptr to the FreeRTOS-task
-                              static_cast<void*>(p.get()),
-                              tskIDLE_PRIORITY + 1,
-                              &_async_task_handle,
-                              CONFIG_THINGY_TASKS_RUNNING_CORE);
+    {
+      TRACE_SCOPE("led.createTask");
+      _taskRunning = true;
+      customTaskCreateUniversal(_async_setLedTask,
+                                "setLedTask",
+                                taskStackSize,
+                                // pass the underlying pointer to LEDTaskParams from within shared_ptr to the FreeRTOS-task
+                                static_cast<void*>(p.get()),
+                                tskIDLE_PRIORITY + 1,
+                                &_async_task_handle,
+                                CONFIG_THINGY_LED_RENDER_CORE);
+    }
 
     // not just for debugging...
     Task* report_async_setLedTask = new Task(TASK_IMMEDIATE, TASK_ONCE,
                                              // pass ownership of shared_ptr to LEDTaskParams to the new cooperative task
-                                             [moved_LEDTaskParams = move(p)] {
+                                             [moved_LEDTaskParams = move(p), traceId] {
+                                               // (the very first state, set by the initialization, wasn't traced)
+                                               if (traceId != 0) {
+                                                 TRACE_ASYNC_END("led.stateChange", traceId);
+                                               }
                                                LOGD(TAG, "...async Led setting done!");
                                                // the LEDTaskParams will be deallocated after this task deletes itself
                                                // take care in _async_setLedTask to use the passed pointer to LEDTaskParams only as long _srBusy is pending
@@ -286,26 +1049,61 @@ Soylent::LedClass::LedState Soylent::LedClass::getLedState() {
   return _ledState;
 }
 
-void Soylent::LedClass::setLedState(LedState ledState) {
+void Soylent::LedClass::setLedState(LedState ledState, uint32_t commandAt) {
+  TRACE_SCOPE("led.setLedState");
   if (_srInitialized.pending()) {
     LOGW(TAG, "uninitialized, can't do it!");
     return;
   }
 
   if (_ledState != ledState) {
+    // remember what is shown right now to crossfade from
+    _previousState = _ledState;
+    _previousTimeConstant = _timeConstant;
+    _previousHue = _hue;
     _ledState = ledState;
+    // the LED task taking over answers this command
+    if (commandAt != 0) {
+      _pipeline.command(commandAt);
+    }
 
-    if (_ledState == LedState::BLINK) {
-      _timeConstant = 500;
-    } else if (_ledState == LedState::RAINBOW) {
-      _timeConstant = 19;
+    if (_ledState == LedState::BLINK || _ledState == LedState::RAINBOW) {
+      _timeConstant = _timeConstantOf(_ledState);
+    } else if (_ledState == LedState::ON) {
+      // a random color from the rainbow
+      _hue = random(0, 255);
     }
 
     // create and run a task for creating and running an async task for setting the LED...
     // task is pending until the LED is not busy
     LOGD(TAG, "Start setting LED...");
-    Task* setLedTask = new Task(TASK_IMMEDIATE, TASK_ONCE, [&] { _setLedCallback(); }, _scheduler, false, NULL, NULL, true);
+    // traced until the new LED task has taken over (see _setLedCallback)
+    uint16_t traceId = TRACE_NEXT_ID();
+    TRACE_ASYNC_BEGIN("led.stateChange", traceId);
+    Task* setLedTask = new Task(TASK_IMMEDIATE, TASK_ONCE, [&, traceId] { _setLedCallback(traceId); }, _scheduler, false, NULL, NULL, true);
     setLedTask->enable();
     setLedTask->waitFor(&_srBusy);
+    Power.wake();
   }
 }
+
+// Restart the LED task for the same state (e.g. as the layers changed)
+void Soylent::LedClass::_restartLed() {
+  if (_srInitialized.pending()) {
+    return;
+  }
+
+  // nothing to crossfade from, unless a new state is still on its way
+  if (!_srBusy.pending()) {
+    _previousState = _ledState;
+    _previousTimeConstant = _timeConstant;
+    _previousHue = _hue;
+  }
+
+  uint16_t traceId = TRACE_NEXT_ID();
+  TRACE_ASYNC_BEGIN("led.stateChange", traceId);
+  Task* setLedTask = new Task(TASK_IMMEDIATE, TASK_ONCE, [&, traceId] { _setLedCallback(traceId); }, _scheduler, false, NULL, NULL, true);
+  setLedTask->enable();
+  setLedTask->waitFor(&_srBusy);
+  Power.wake();
+}
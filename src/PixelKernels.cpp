@@ -0,0 +1,63 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+/*
+ * Copyright (C) 2025 Robert Wendlandt
+ */
+#include <thingy.h>
+#define TAG "PixelKernels"
+
+#ifdef CONFIG_THINGY_PIXEL_KERNELS_CHECK
+  #define CHECK_PIXELS 256
+  #define CHECK_ROUNDS 64
+
+// Throughput of a kernel (in pixels/s)
+template <typename Kernel>
+static uint32_t pixelsPerSecond(CRGB* pixels, Kernel kernel) {
+  uint32_t start = micros();
+  for (uint16_t round = 0; round < CHECK_ROUNDS; round++) {
+    kernel(pixels, round);
+  }
+  uint32_t elapsed = std::max<uint32_t>(micros() - start, 1);
+  return static_cast<uint64_t>(CHECK_PIXELS) * CHECK_ROUNDS * 1000000 / elapsed;
+}
+
+bool Soylent::PixelKernels::check() {
+  static CRGB reference[CHECK_PIXELS];
+  static CRGB packed[CHECK_PIXELS];
+  static CRGB layer[CHECK_PIXELS];
+  for (uint16_t i = 0; i < CHECK_PIXELS; i++) {
+    layer[i] = CRGB(random(0, 256), random(0, 256), random(0, 256));
+  }
+  __unused CRGB adjustment = CRGB::computeAdjustment(128, CRGB(255, 85, 210), CRGB(UncorrectedTemperature));
+
+  // all factors on all kinds of pixels, odd counts included
+  bool exact = true;
+  for (uint16_t amount = 0; amount < 256 && exact; amount++) {
+    uint16_t count = CHECK_PIXELS - (amount & 1);
+    for (uint16_t i = 0; i < CHECK_PIXELS; i++) {
+      reference[i] = packed[i] = CRGB(random(0, 256), random(0, 256), random(0, 256));
+    }
+    Portable::scale(reference, count, static_cast<uint8_t>(amount));
+    Packed::scale(packed, count, static_cast<uint8_t>(amount));
+    Portable::scale(reference, count, CRGB(amount, 255 - amount, amount >> 1));
+    Packed::scale(packed, count, CRGB(amount, 255 - amount, amount >> 1));
+    Portable::blend(reference, layer, count, amount);
+    Packed::blend(packed, layer, count, amount);
+    exact = memcmp(reference, packed, sizeof(reference)) == 0;
+  }
+  if (!exact) {
+    LOGE(TAG, "Packed kernels differ from the portable ones!");
+    return false;
+  }
+
+  LOGI(TAG, "scale:  %" PRIu32 " / %" PRIu32 " pixels/s (portable / packed)",
+       pixelsPerSecond(reference, [](CRGB* pixels, uint8_t amount) { Portable::scale(pixels, CHECK_PIXELS, amount); }),
+       pixelsPerSecond(packed, [](CRGB* pixels, uint8_t amount) { Packed::scale(pixels, CHECK_PIXELS, amount); }));
+  LOGI(TAG, "adjust: %" PRIu32 " / %" PRIu32 " pixels/s (portable / packed)",
+       pixelsPerSecond(reference, [&](CRGB* pixels, __unused uint8_t amount) { Portable::scale(pixels, CHECK_PIXELS, adjustment); }),
+       pixelsPerSecond(packed, [&](CRGB* pixels, __unused uint8_t amount) { Packed::scale(pixels, CHECK_PIXELS, adjustment); }));
+  LOGI(TAG, "blend:  %" PRIu32 " / %" PRIu32 " pixels/s (portable / packed)",
+       pixelsPerSecond(reference, [](CRGB* pixels, uint8_t amount) { Portable::blend(pixels, layer, CHECK_PIXELS, amount); }),
+       pixelsPerSecond(packed, [](CRGB* pixels, uint8_t amount) { Packed::blend(pixels, layer, CHECK_PIXELS, amount); }));
+  return true;
+}
+#endif
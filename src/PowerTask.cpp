@@ -0,0 +1,316 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+/*
+ * Copyright (C) 2025 Robert Wendlandt
+ */
+#include <thingy.h>
+#include <esp_timer.h>
+#define TAG "Power"
+
+Soylent::PowerClass::PowerClass()
+    : _scheduler(nullptr), _loopTask(nullptr), _pmScaling(false), _minFrequency(0), _maxFrequency(0), _demands(), _ledDemand(false), _boosted(true),
+      _lastDemandAt(0), _frequencySince(0), _boostedTime(0), _unboostedTime(0), _boosts(0), _lightSleepSupported(false), _lightSleepAllowed(false),
+      _lightSleepSince(0), _lightSleepTime(0), _sleeps(0), _earlyWakeups(0), _sleepTime(0) {
+#if CONFIG_PM_ENABLE
+  _noLightSleep = nullptr;
+  _cpuFreqMax = nullptr;
+#endif
+}
+
+void Soylent::PowerClass::begin(Scheduler* scheduler) {
+  LOGD(TAG, "Starting Power...");
+  _scheduler = scheduler;
+  // begin() is called from setup(), which runs in the loop task
+  _loopTask = xTaskGetCurrentTaskHandle();
+
+  // the clock starts out raised (as it was set up)
+  _maxFrequency = CONFIG_THINGY_CPU_MAX_FREQ > 0 ? CONFIG_THINGY_CPU_MAX_FREQ : getCpuFrequencyMhz();
+  _minFrequency = CONFIG_THINGY_CPU_SCALING ? std::min<uint32_t>(CONFIG_THINGY_CPU_MIN_FREQ, _maxFrequency) : _maxFrequency;
+  _frequencySince = esp_timer_get_time();
+  _lastDemandAt = millis();
+
+#if CONFIG_PM_ENABLE
+  // light sleep is not allowed, unless the LED says otherwise
+  if (_noLightSleep == nullptr && esp_pm_lock_create(ESP_PM_NO_LIGHT_SLEEP, 0, "thingy", &_noLightSleep) == ESP_OK) {
+    esp_pm_lock_acquire(_noLightSleep);
+  }
+
+  #if CONFIG_THINGY_CPU_SCALING
+  // the clock is at its maximum while we are holding this one
+  if (_cpuFreqMax == nullptr && esp_pm_lock_create(ESP_PM_CPU_FREQ_MAX, 0, "thingy", &_cpuFreqMax) == ESP_OK) {
+    esp_pm_lock_acquire(_cpuFreqMax);
+  }
+  #endif
+
+  #if CONFIG_FREERTOS_USE_TICKLESS_IDLE && CONFIG_THINGY_LIGHT_SLEEP
+  // whenever all tasks are blocked, sleep lightly until the next one is due (Wi-Fi keeps connected in modem sleep)
+  constexpr bool lightSleep = true;
+  #else
+  constexpr bool lightSleep = false;
+  #endif
+  if (CONFIG_THINGY_CPU_SCALING || lightSleep) {
+    esp_pm_config_t pmConfig = {};
+    pmConfig.max_freq_mhz = _maxFrequency;
+    pmConfig.min_freq_mhz = _minFrequency;
+    pmConfig.light_sleep_enable = lightSleep;
+    if (esp_pm_configure(&pmConfig) == ESP_OK) {
+      _pmScaling = CONFIG_THINGY_CPU_SCALING && _cpuFreqMax != nullptr;
+      _lightSleepSupported = lightSleep && _noLightSleep != nullptr;
+      LOGI(TAG, "CPU clock between %" PRIu32 " and %" PRIu32 " MHz%s", _minFrequency, _maxFrequency, _lightSleepSupported ? ", light sleep while the LED is static" : "");
+    } else {
+      LOGW(TAG, "Can't configure power management!");
+    }
+  }
+#endif
+
+  LOGD(TAG, "...done!");
+}
+
+void Soylent::PowerClass::end() {
+  LOGD(TAG, "Stopping Power...");
+  _allowLightSleep(false);
+  if (!_boosted) {
+    _setFrequency(true);
+  }
+  _loopTask = nullptr;
+  LOGD(TAG, "...done!");
+}
+
+void Soylent::PowerClass::idle(bool idleRun) {
+  // light sleep follows the LED
+  _allowLightSleep(Led.isStatic());
+  uint32_t maxSleep = _govern();
+
+#if CONFIG_THINGY_IDLE_SLEEP
+  if (!idleRun || _loopTask == nullptr) {
+    return;
+  }
+
+  // block until the next task is due (nothing scheduled at all: as long as allowed)
+  unsigned long nextRun = _scheduler->getNextRun();
+  TickType_t ticks = pdMS_TO_TICKS(nextRun == 0 ? maxSleep : std::min<unsigned long>(nextRun, maxSleep));
+  if (ticks == 0) {
+    return;
+  }
+
+  int64_t start = esp_timer_get_time();
+  bool woken = ulTaskNotifyTake(pdTRUE, ticks) > 0;
+  int64_t slept = esp_timer_get_time() - start;
+  taskENTER_CRITICAL(&cs_spinlock);
+  _sleeps++;
+  _sleepTime += slept;
+  if (woken) {
+    _earlyWakeups++;
+  }
+  taskEXIT_CRITICAL(&cs_spinlock);
+#endif
+}
+
+void Soylent::PowerClass::wake() {
+#if CONFIG_THINGY_IDLE_SLEEP
+  TaskHandle_t loopTask = _loopTask;
+  // (the loop doesn't need to wake itself)
+  if (loopTask != nullptr && loopTask != xTaskGetCurrentTaskHandle()) {
+    xTaskNotifyGive(loopTask);
+  }
+#endif
+}
+
+void Soylent::PowerClass::boost(Demand demand) {
+  taskENTER_CRITICAL(&cs_spinlock);
+  _demands[demand]++;
+  _lastDemandAt = millis();
+  bool raise = !_boosted;
+  taskEXIT_CRITICAL(&cs_spinlock);
+  // the main loop raises the clock
+  if (raise) {
+    wake();
+  }
+}
+
+void Soylent::PowerClass::release(Demand demand) {
+  taskENTER_CRITICAL(&cs_spinlock);
+  if (_demands[demand] > 0) {
+    _demands[demand]--;
+  }
+  // the hold starts over now
+  _lastDemandAt = millis();
+  taskEXIT_CRITICAL(&cs_spinlock);
+}
+
+// Raise the clock on demand, drop it when there was none for a while, only called from the loop task
+// returns how long the loop may sleep before taking another look (in ms)
+uint32_t Soylent::PowerClass::_govern() {
+  if constexpr (!CONFIG_THINGY_CPU_SCALING) {
+    return CONFIG_THINGY_IDLE_MAX_SLEEP;
+  }
+
+  // animations on many LEDs (a dimmable LED is fading on its own)
+  bool ledDemand = CONFIG_THINGY_LED_COUNT >= CONFIG_THINGY_CPU_BOOST_PIXELS && !LedClass::Output::dimmable && Led.isAnimated();
+  if (ledDemand != _ledDemand) {
+    _ledDemand = ledDemand;
+    if (ledDemand) {
+      boost(DEMAND_LED);
+    } else {
+      release(DEMAND_LED);
+    }
+  }
+
+  uint32_t now = millis();
+  taskENTER_CRITICAL(&cs_spinlock);
+  bool demanded = false;
+  for (uint16_t demand : _demands) {
+    demanded |= demand > 0;
+  }
+  uint32_t held = now - _lastDemandAt;
+  taskEXIT_CRITICAL(&cs_spinlock);
+
+  // hysteresis: the clock stays up until there was no demand for a while
+  // (a demand might be over before the loop gets here, e.g. from a request, it still raises the clock)
+  bool boosted = demanded || held < CONFIG_THINGY_CPU_BOOST_HOLD;
+  if (boosted != _boosted) {
+    _setFrequency(boosted);
+  }
+  if (boosted && !demanded) {
+    return std::min<uint32_t>(CONFIG_THINGY_CPU_BOOST_HOLD - held, CONFIG_THINGY_IDLE_MAX_SLEEP);
+  }
+  return CONFIG_THINGY_IDLE_MAX_SLEEP;
+}
+
+// Only called from the loop task
+void Soylent::PowerClass::_setFrequency(bool boosted) {
+#if CONFIG_PM_ENABLE
+  if (_pmScaling) {
+    if (boosted) {
+      esp_pm_lock_acquire(_cpuFreqMax);
+    } else {
+      esp_pm_lock_release(_cpuFreqMax);
+    }
+  }
+#endif
+  if (!_pmScaling) {
+    setCpuFrequencyMhz(boosted ? _maxFrequency : _minFrequency);
+  }
+
+  int64_t now = esp_timer_get_time();
+  taskENTER_CRITICAL(&cs_spinlock);
+  if (_boosted) {
+    _boostedTime += now - _frequencySince;
+  } else {
+    _unboostedTime += now - _frequencySince;
+  }
+  _frequencySince = now;
+  _boosted = boosted;
+  if (boosted) {
+    _boosts++;
+  }
+  taskEXIT_CRITICAL(&cs_spinlock);
+  LOGD(TAG, "CPU clock %s to %" PRIu32 " MHz", boosted ? "raised" : "dropped", boosted ? _maxFrequency : _minFrequency);
+}
+
+// Only called from the loop task
+void Soylent::PowerClass::_allowLightSleep(bool allow) {
+  if (allow == _lightSleepAllowed) {
+    return;
+  }
+
+#if CONFIG_PM_ENABLE
+  if (_noLightSleep != nullptr) {
+    if (allow) {
+      esp_pm_lock_release(_noLightSleep);
+    } else {
+      esp_pm_lock_acquire(_noLightSleep);
+    }
+  }
+#endif
+
+  int64_t now = esp_timer_get_time();
+  taskENTER_CRITICAL(&cs_spinlock);
+  if (allow) {
+    _lightSleepSince = now;
+  } else {
+    _lightSleepTime += now - _lightSleepSince;
+  }
+  _lightSleepAllowed = allow;
+  taskEXIT_CRITICAL(&cs_spinlock);
+  LOGD(TAG, "Light sleep is %s", allow ? "allowed" : "not allowed");
+}
+
+bool Soylent::PowerClass::isLightSleepSupported() {
+  return _lightSleepSupported;
+}
+
+bool Soylent::PowerClass::isLightSleepAllowed() {
+  return _lightSleepAllowed;
+}
+
+uint32_t Soylent::PowerClass::getSleeps() {
+  return _sleeps;
+}
+
+uint32_t Soylent::PowerClass::getEarlyWakeups() {
+  return _earlyWakeups;
+}
+
+uint64_t Soylent::PowerClass::getSleepTime() {
+  taskENTER_CRITICAL(&cs_spinlock);
+  uint64_t sleepTime = _sleepTime;
+  taskEXIT_CRITICAL(&cs_spinlock);
+  return sleepTime;
+}
+
+uint64_t Soylent::PowerClass::getLightSleepTime() {
+  int64_t now = esp_timer_get_time();
+  taskENTER_CRITICAL(&cs_spinlock);
+  uint64_t lightSleepTime = _lightSleepTime + (_lightSleepAllowed ? now - _lightSleepSince : 0);
+  taskEXIT_CRITICAL(&cs_spinlock);
+  return lightSleepTime;
+}
+
+bool Soylent::PowerClass::isScaling() {
+  return _minFrequency < _maxFrequency;
+}
+
+bool Soylent::PowerClass::isBoosted() {
+  return _boosted;
+}
+
+uint32_t Soylent::PowerClass::getMinFrequency() {
+  return _minFrequency;
+}
+
+uint32_t Soylent::PowerClass::getMaxFrequency() {
+  return _maxFrequency;
+}
+
+uint32_t Soylent::PowerClass::getBoosts() {
+  return _boosts;
+}
+
+uint16_t Soylent::PowerClass::getDemand(Demand demand) {
+  return _demands[demand];
+}
+
+uint64_t Soylent::PowerClass::getBoostedTime() {
+  int64_t now = esp_timer_get_time();
+  taskENTER_CRITICAL(&cs_spinlock);
+  uint64_t boostedTime = _boostedTime + (_boosted ? now - _frequencySince : 0);
+  taskEXIT_CRITICAL(&cs_spinlock);
+  return boostedTime;
+}
+
+uint64_t Soylent::PowerClass::getUnboostedTime() {
+  int64_t now = esp_timer_get_time();
+  taskENTER_CRITICAL(&cs_spinlock);
+  uint64_t unboostedTime = _unboostedTime + (_boosted ? 0 : now - _frequencySince);
+  taskEXIT_CRITICAL(&cs_spinlock);
+  return unboostedTime;
+}
+
+int Soylent::PowerClass::getIdlePercent(uint8_t core) {
+#if configGENERATE_RUN_TIME_STATS
+  if (core < portNUM_PROCESSORS) {
+    return ulTaskGetIdleRunTimePercentForCore(core);
+  }
+#endif
+  return -1;
+}
@@ -0,0 +1,128 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+/*
+ * Copyright (C) 2025 Robert Wendlandt
+ */
+#include <thingy.h>
+#include <esp_app_desc.h>
+#include <esp_chip_info.h>
+#include <esp_ota_ops.h>
+#include <esp_partition.h>
+#include <cinttypes>
+#include <cstdarg>
+#include <cstdio>
+#define TAG "SystemInfo"
+
+// see tools/version.py
+extern const char* __COMPILED_APP_VERSION__;
+extern const char* __COMPILED_BUILD_HASH__;
+extern const char* __COMPILED_BUILD_BOARD__;
+extern const char* __COMPILED_BUILD_TIMESTAMP__;
+
+namespace {
+  struct ChipFeature {
+      uint32_t flag;
+      const char* name;
+  };
+
+  constexpr ChipFeature CHIP_FEATURES[] = {
+    {CHIP_FEATURE_EMB_FLASH, "embedded_flash"},
+    {CHIP_FEATURE_WIFI_BGN, "wifi"},
+    {CHIP_FEATURE_BLE, "ble"},
+    {CHIP_FEATURE_BT, "bt"},
+    {CHIP_FEATURE_IEEE802154, "ieee802154"},
+    {CHIP_FEATURE_EMB_PSRAM, "embedded_psram"},
+  };
+
+  // Append to a buffer like snprintf, keeps on counting once it's full
+  class Writer {
+    public:
+      Writer(char* buffer, size_t size) : _buffer(buffer), _size(size), _length(0) {}
+
+      __attribute__((format(printf, 2, 3))) void print(const char* format, ...) {
+        va_list args;
+        va_start(args, format);
+        int written = vsnprintf(_length < _size ? _buffer + _length : nullptr, _length < _size ? _size - _length : 0, format, args);
+        va_end(args);
+        if (written > 0) {
+          _length += written;
+        }
+      }
+
+      size_t length() {
+        return _length;
+      }
+
+    private:
+      char* _buffer;
+      size_t _size;
+      size_t _length;
+  };
+} // namespace
+
+const Soylent::SystemInfo::ResetReason& Soylent::SystemInfo::getResetReason() {
+  return resetReasonOf(esp_reset_reason());
+}
+
+const char* Soylent::SystemInfo::getJson(size_t* length) {
+  static char json[CONFIG_THINGY_SYSINFO_SIZE];
+  static size_t rendered = 0;
+  if (rendered == 0) {
+    rendered = write(json, sizeof(json));
+    if (rendered >= sizeof(json)) {
+      LOGE(TAG, "CONFIG_THINGY_SYSINFO_SIZE is too small (%u bytes needed)!", rendered + 1);
+      rendered = snprintf(json, sizeof(json), "{\"error\":\"CONFIG_THINGY_SYSINFO_SIZE is too small\"}");
+    }
+  }
+  *length = rendered;
+  return json;
+}
+
+size_t Soylent::SystemInfo::write(char* buffer, size_t size) {
+  Writer out(buffer, size);
+
+  const ResetReason& resetReason = getResetReason();
+  out.print("{\"reset_reason\":{\"code\":%d,\"name\":\"%s\",\"description\":\"%s\"}", static_cast<int>(resetReason.reason), resetReason.name, resetReason.description);
+
+  esp_chip_info_t chip;
+  esp_chip_info(&chip);
+  uint64_t mac = ESP.getEfuseMac();
+  out.print(",\"chip\":{\"model\":\"%s\",\"revision\":%u,\"cores\":%u,\"efuse_mac\":\"%012" PRIx64 "\",\"features\":[", ESP.getChipModel(), chip.revision, chip.cores, mac);
+  const char* separator = "";
+  for (const ChipFeature& feature : CHIP_FEATURES) {
+    if (chip.features & feature.flag) {
+      out.print("%s\"%s\"", separator, feature.name);
+      separator = ",";
+    }
+  }
+  out.print("]},\"flash\":{\"size\":%" PRIu32 ",\"speed\":%" PRIu32 "},\"psram\":{\"size\":%" PRIu32 "}", ESP.getFlashChipSize(), ESP.getFlashChipSpeed(), ESP.getPsramSize());
+
+  // (the iterator is the only thing allocated, and just for a moment)
+  const esp_partition_t* running = esp_ota_get_running_partition();
+  out.print(",\"partitions\":[");
+  separator = "";
+  for (esp_partition_iterator_t it = esp_partition_find(ESP_PARTITION_TYPE_ANY, ESP_PARTITION_SUBTYPE_ANY, nullptr); it != nullptr; it = esp_partition_next(it)) {
+    const esp_partition_t* partition = esp_partition_get(it);
+    out.print("%s{\"label\":\"%s\",\"type\":%d,\"subtype\":%d,\"address\":%" PRIu32 ",\"size\":%" PRIu32 ",\"running\":%s}",
+              separator,
+              partition->label,
+              static_cast<int>(partition->type),
+              static_cast<int>(partition->subtype),
+              partition->address,
+              partition->size,
+              partition == running ? "true" : "false");
+    separator = ",";
+  }
+
+  const esp_app_desc_t* app = esp_app_get_description();
+  char elfSha256[17];
+  esp_app_get_elf_sha256(elfSha256, sizeof(elfSha256));
+  out.print("],\"build\":{\"project\":\"%s\",\"version\":\"%s\",\"hash\":\"%s\",\"board\":\"%s\",\"timestamp\":\"%s\",\"idf\":\"%s\",\"elf_sha256\":\"%s\"}}",
+            app->project_name,
+            __COMPILED_APP_VERSION__,
+            __COMPILED_BUILD_HASH__,
+            __COMPILED_BUILD_BOARD__,
+            __COMPILED_BUILD_TIMESTAMP__,
+            app->idf_ver,
+            elfSha256);
+  return out.length();
+}
@@ -0,0 +1,114 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+/*
+ * Copyright (C) 2025 Robert Wendlandt
+ */
+#include <thingy.h>
+#include <esp_heap_caps.h>
+#define TAG "Telemetry"
+
+Soylent::TelemetryClass::TelemetryClass()
+    : _sampleTask(nullptr), _scheduler(nullptr), _samples(), _next(0), _count(0) {
+  for (auto& minFree : _stackMinFree) {
+    minFree = -1;
+  }
+}
+
+void Soylent::TelemetryClass::begin(Scheduler* scheduler) {
+  LOGD(TAG, "Start sampling stacks and heap...");
+  _scheduler = scheduler;
+  if (_sampleTask == nullptr) {
+    _sampleTask = new Task(CONFIG_THINGY_TELEMETRY_INTERVAL * TASK_MILLISECOND, TASK_FOREVER, [&] { _sampleCallback(); }, _scheduler, false, NULL, NULL, false);
+  }
+  _sampleTask->enable();
+  LOGD(TAG, "...done!");
+}
+
+void Soylent::TelemetryClass::end() {
+  LOGD(TAG, "Stop sampling...");
+  if (_sampleTask != nullptr) {
+    _sampleTask->disable();
+  }
+  LOGD(TAG, "...done!");
+}
+
+const char* Soylent::TelemetryClass::getStackName(Stack stack) {
+  switch (stack) {
+    case STACK_LOOP:
+      return "loop";
+    case STACK_LED:
+      return "led";
+    case STACK_LED_OUTPUT:
+      return "led_output";
+    case STACK_ASYNC_TCP:
+      return "async_tcp";
+    default:
+      return "unknown";
+  }
+}
+
+uint32_t Soylent::TelemetryClass::getStackSize(Stack stack) {
+  switch (stack) {
+    case STACK_LOOP:
+      return getArduinoLoopTaskStackSize();
+    case STACK_LED:
+      return LedClass::Output::present ? LedClass::taskStackSize : 0;
+    case STACK_LED_OUTPUT:
+      return LedClass::pipelined ? CONFIG_THINGY_TASKS_STACK_SIZE : 0;
+    case STACK_ASYNC_TCP:
+      return CONFIG_ASYNC_TCP_STACK_SIZE;
+    default:
+      return 0;
+  }
+}
+
+int32_t Soylent::TelemetryClass::getStackMinFree(Stack stack) {
+  return _stackMinFree[stack];
+}
+
+uint16_t Soylent::TelemetryClass::getSampleCount() {
+  return _count;
+}
+
+bool Soylent::TelemetryClass::getSample(uint16_t index, Sample* copy) {
+  taskENTER_CRITICAL(&cs_spinlock);
+  bool valid = index < _count;
+  if (valid) {
+    *copy = _samples[(_next + CONFIG_THINGY_TELEMETRY_SAMPLES - _count + index) % CONFIG_THINGY_TELEMETRY_SAMPLES];
+  }
+  taskEXIT_CRITICAL(&cs_spinlock);
+  return valid;
+}
+
+// Take a sample, in the loop task
+void Soylent::TelemetryClass::_sampleCallback() {
+  TRACE_SCOPE("telemetry.sampleCallback");
+  Sample sample;
+  sample.at = millis();
+  sample.heapFree = heap_caps_get_free_size(MALLOC_CAP_8BIT);
+  sample.heapMinFree = heap_caps_get_minimum_free_size(MALLOC_CAP_8BIT);
+  sample.heapLargestBlock = heap_caps_get_largest_free_block(MALLOC_CAP_8BIT);
+
+  // (on ESP-IDF, stacks are counted in bytes)
+  sample.stackFree[STACK_LOOP] = uxTaskGetStackHighWaterMark(NULL);
+  sample.stackFree[STACK_LED] = Led.getTaskStackHighWater();
+  sample.stackFree[STACK_LED_OUTPUT] = Led.getOutputTaskStackHighWater();
+  // AsyncTCP's task is never deleted once it's there
+  TaskHandle_t asyncTcpTask = xTaskGetHandle("async_tcp");
+  sample.stackFree[STACK_ASYNC_TCP] = asyncTcpTask != nullptr ? uxTaskGetStackHighWaterMark(asyncTcpTask) : -1;
+
+  taskENTER_CRITICAL(&cs_spinlock);
+  _samples[_next] = sample;
+  _next = (_next + 1) % CONFIG_THINGY_TELEMETRY_SAMPLES;
+  if (_count < CONFIG_THINGY_TELEMETRY_SAMPLES) {
+    _count++;
+  }
+  for (uint8_t stack = 0; stack < STACK_COUNT; stack++) {
+    if (sample.stackFree[stack] >= 0 && (_stackMinFree[stack] < 0 || sample.stackFree[stack] < _stackMinFree[stack])) {
+      _stackMinFree[stack] = sample.stackFree[stack];
+    }
+  }
+  taskEXIT_CRITICAL(&cs_spinlock);
+
+  LOGD(TAG, "Heap %" PRIu32 " free (%" PRIu32 " at least, largest block %" PRIu32 "), stacks free: loop %" PRId32 ", led %" PRId32 ", async_tcp %" PRId32,
+       sample.heapFree, sample.heapMinFree, sample.heapLargestBlock, sample.stackFree[STACK_LOOP], sample.stackFree[STACK_LED], sample.stackFree[STACK_ASYNC_TCP]);
+}
@@ -0,0 +1,204 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+/*
+ * Copyright (C) 2025 Robert Wendlandt
+ */
+#include <thingy.h>
+#include <esp_timer.h>
+#include <cstring>
+#define TAG "TimeSync"
+
+#define SYNC_MAGIC   "LTSY"
+#define SYNC_VERSION 1
+
+static const IPAddress SYNC_GROUP(239, 255, 76, 84);
+
+Soylent::TimeSyncClass::TimeSyncClass()
+    : _syncTask(nullptr), _scheduler(nullptr) {
+}
+
+void Soylent::TimeSyncClass::begin(Scheduler* scheduler) {
+  // keep on syncing when we were started before (e.g. WiFi reconnected)
+  if (_udp.connected()) {
+    return;
+  }
+
+  // derive the node id from the (unique) part of the MAC
+  uint32_t nodeId = static_cast<uint32_t>(ESP.getEfuseMac() >> 16);
+  taskENTER_CRITICAL(&cs_spinlock);
+  _node.begin(nodeId);
+  taskEXIT_CRITICAL(&cs_spinlock);
+
+  LOGD(TAG, "Start syncing (node %08x)...", nodeId);
+  if (_udp.listenMulticast(SYNC_GROUP, CONFIG_THINGY_SYNC_PORT)) {
+    _udp.onPacket([&](AsyncUDPPacket& packet) { _onPacket(packet); });
+  } else {
+    LOGE(TAG, "Can't join sync group!");
+    return;
+  }
+
+  // Task handling
+  _scheduler = scheduler;
+  if (_syncTask == nullptr) {
+    _syncTask = new Task(CONFIG_THINGY_SYNC_INTERVAL * TASK_MILLISECOND, TASK_FOREVER, [&] { _syncCallback(); }, _scheduler, false, NULL, NULL, false);
+  }
+  _syncTask->enable();
+
+  LOGD(TAG, "...done!");
+}
+
+void Soylent::TimeSyncClass::end() {
+  LOGD(TAG, "Stop syncing...");
+  if (_syncTask != nullptr) {
+    _syncTask->disable();
+  }
+  _udp.close();
+  taskENTER_CRITICAL(&cs_spinlock);
+  _node.end();
+  taskEXIT_CRITICAL(&cs_spinlock);
+  LOGD(TAG, "...done!");
+}
+
+int64_t Soylent::TimeSyncClass::getMicros() {
+  int64_t localTime = esp_timer_get_time();
+  taskENTER_CRITICAL(&cs_spinlock);
+  int64_t offset = _node.getOffsetAt(localTime);
+  taskEXIT_CRITICAL(&cs_spinlock);
+  return localTime + offset;
+}
+
+uint32_t Soylent::TimeSyncClass::getMillis() {
+  return static_cast<uint32_t>(getMicros() / 1000);
+}
+
+void Soylent::TimeSyncClass::setMicros(int64_t networkTime) {
+  int64_t localTime = esp_timer_get_time();
+  taskENTER_CRITICAL(&cs_spinlock);
+  _node.setOffset(networkTime - localTime, localTime);
+  taskEXIT_CRITICAL(&cs_spinlock);
+}
+
+bool Soylent::TimeSyncClass::isLeader() {
+  return _node.isLeader();
+}
+
+bool Soylent::TimeSyncClass::isSynced() {
+  return _node.isSynced();
+}
+
+uint32_t Soylent::TimeSyncClass::getNodeId() {
+  return _node.getNodeId();
+}
+
+uint32_t Soylent::TimeSyncClass::getLeaderId() {
+  return _node.getLeaderId();
+}
+
+int64_t Soylent::TimeSyncClass::getOffset() {
+  return _node.getOffset();
+}
+
+int32_t Soylent::TimeSyncClass::getDelay() {
+  return static_cast<int32_t>(_node.getDelay());
+}
+
+// drift in ppm
+float Soylent::TimeSyncClass::getDrift() {
+  return _node.getDrift() * 1e6f;
+}
+
+// Announce ourselves and ask the leader for its time
+void Soylent::TimeSyncClass::_syncCallback() {
+  TRACE_SCOPE("timesync.syncCallback");
+  // (the leader is changed by packets in the async_udp task as well)
+  uint32_t now = millis();
+  taskENTER_CRITICAL(&cs_spinlock);
+  uint32_t goneLeaderId = _node.checkLeader(now, 3 * CONFIG_THINGY_SYNC_INTERVAL);
+  bool leader = _node.isLeader();
+  IPAddress leaderAddress = _leaderAddress;
+  taskEXIT_CRITICAL(&cs_spinlock);
+  if (goneLeaderId != 0) {
+    LOGI(TAG, "Leader %08x is gone, taking the lead", goneLeaderId);
+  }
+
+  // every node is sending beacons, so a node leading on its own can find a leader with a lower id
+  _send(PacketType::BEACON, getMicros(), 0, SYNC_GROUP, CONFIG_THINGY_SYNC_PORT);
+
+  if (!leader) {
+    _send(PacketType::REQUEST, esp_timer_get_time(), 0, leaderAddress, CONFIG_THINGY_SYNC_PORT);
+  }
+}
+
+void Soylent::TimeSyncClass::_send(PacketType type, int64_t t1, int64_t t2, const IPAddress& address, uint16_t port) {
+  SyncPacket packet;
+  memcpy(packet.magic, SYNC_MAGIC, sizeof(packet.magic));
+  packet.version = SYNC_VERSION;
+  packet.type = static_cast<uint8_t>(type);
+  packet.reserved = 0;
+  taskENTER_CRITICAL(&cs_spinlock);
+  packet.nodeId = _node.getNodeId();
+  packet.leaderId = _node.getLeaderId();
+  taskEXIT_CRITICAL(&cs_spinlock);
+  packet.t1 = t1;
+  packet.t2 = t2;
+  // as late as possible
+  packet.t3 = (type == PacketType::RESPONSE) ? getMicros() : 0;
+  _udp.writeTo(reinterpret_cast<const uint8_t*>(&packet), sizeof(packet), address, port);
+}
+
+void Soylent::TimeSyncClass::_onPacket(AsyncUDPPacket& packet) {
+  // time of arrival, in both local and network time
+  int64_t localTime = esp_timer_get_time();
+  int64_t networkTime = getMicros();
+
+  if (packet.length() != sizeof(SyncPacket)) {
+    return;
+  }
+
+  SyncPacket syncPacket;
+  memcpy(&syncPacket, packet.data(), sizeof(syncPacket));
+  if (memcmp(syncPacket.magic, SYNC_MAGIC, sizeof(syncPacket.magic)) != 0 || syncPacket.version != SYNC_VERSION || syncPacket.nodeId == _node.getNodeId()) {
+    return;
+  }
+
+  switch (static_cast<PacketType>(syncPacket.type)) {
+    case PacketType::BEACON: {
+      // (the sync task reads what's changed here)
+      uint32_t followed = 0;
+      taskENTER_CRITICAL(&cs_spinlock);
+      SyncNode::Beacon beacon = _node.onBeacon(syncPacket.nodeId, syncPacket.leaderId, millis());
+      if (beacon == SyncNode::Beacon::LEADER_SEEN || beacon == SyncNode::Beacon::FOLLOWING) {
+        _leaderAddress = packet.remoteIP();
+      }
+      if (beacon == SyncNode::Beacon::FOLLOWING) {
+        followed = syncPacket.nodeId;
+      }
+      taskEXIT_CRITICAL(&cs_spinlock);
+      if (followed != 0) {
+        LOGI(TAG, "Following %08x now", followed);
+      }
+      break;
+    }
+
+    case PacketType::REQUEST:
+      if (isLeader()) {
+        _send(PacketType::RESPONSE, syncPacket.t1, networkTime, packet.remoteIP(), packet.remotePort());
+      }
+      break;
+
+    case PacketType::RESPONSE: {
+      taskENTER_CRITICAL(&cs_spinlock);
+      bool applied = _node.onResponse(syncPacket.nodeId, syncPacket.t1, syncPacket.t2, syncPacket.t3, localTime);
+      int64_t offset = _node.getOffset();
+      int64_t delay = _node.getDelay();
+      float drift = _node.getDrift();
+      taskEXIT_CRITICAL(&cs_spinlock);
+      if (applied) {
+        LOGD(TAG, "offset: %lld us, delay: %lld us, drift: %.2f ppm", offset, delay, drift * 1e6f);
+      }
+      break;
+    }
+
+    default:
+      break;
+  }
+}
@@ -0,0 +1,148 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+/*
+ * Copyright (C) 2025 Robert Wendlandt
+ */
+#include <Trace.h>
+#include <cinttypes>
+#include <cstdio>
+#ifdef ARDUINO
+  #include <Arduino.h>
+  #include <esp_timer.h>
+  #define TRACE_CORES portNUM_PROCESSORS
+#else
+  #include <chrono>
+  #include <functional>
+  #include <thread>
+  #define TRACE_CORES 1
+#endif
+
+#if CONFIG_THINGY_TRACE
+namespace {
+  struct Ring {
+      Soylent::Trace::Event events[CONFIG_THINGY_TRACE_EVENTS];
+      // total events recorded, the next one goes to head % CONFIG_THINGY_TRACE_EVENTS
+      std::atomic<uint32_t> head{0};
+  };
+
+  Ring rings[TRACE_CORES];
+  std::atomic<uint32_t> ids{0};
+
+  uint8_t currentCore() {
+#ifdef ARDUINO
+    return xPortGetCoreID();
+#else
+    return 0;
+#endif
+  }
+
+  uint32_t currentTask() {
+#ifdef ARDUINO
+    return static_cast<uint32_t>(reinterpret_cast<uintptr_t>(xTaskGetCurrentTaskHandle()));
+#else
+    return static_cast<uint32_t>(std::hash<std::thread::id>{}(std::this_thread::get_id()));
+#endif
+  }
+} // namespace
+
+uint32_t Soylent::Trace::now() {
+#ifdef ARDUINO
+  return static_cast<uint32_t>(esp_timer_get_time());
+#else
+  return static_cast<uint32_t>(std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now().time_since_epoch()).count());
+#endif
+}
+
+void Soylent::Trace::record(Phase phase, const char* name, uint16_t id, uint32_t start, uint32_t duration) {
+  uint8_t core = currentCore();
+  Ring& ring = rings[core];
+  // claim a slot (a task preempting us on this core, or running on the other one, gets the next one)
+  Event& event = ring.events[ring.head.fetch_add(1, std::memory_order_relaxed) % CONFIG_THINGY_TRACE_EVENTS];
+  event.name = name;
+  event.start = start;
+  event.duration = duration;
+  event.task = currentTask();
+  event.id = id;
+  event.core = core;
+  event.phase = phase;
+}
+
+uint16_t Soylent::Trace::nextId() {
+  uint16_t id;
+  do {
+    id = static_cast<uint16_t>(ids.fetch_add(1, std::memory_order_relaxed) + 1);
+  } while (id == 0);
+  return id;
+}
+
+uint32_t Soylent::Trace::getRecorded() {
+  uint32_t recorded = 0;
+  for (auto& ring : rings) {
+    recorded += ring.head.load(std::memory_order_relaxed);
+  }
+  return recorded;
+}
+
+void Soylent::Trace::clear() {
+  for (auto& ring : rings) {
+    ring.head.store(0, std::memory_order_relaxed);
+  }
+}
+
+// Events are read while they might be recorded, an event overwritten meanwhile is just shown as it is
+void Soylent::Trace::write(void (*out)(const char* chunk, void* context), void* context) {
+  // timestamps count from the oldest event kept
+  uint32_t exportedAt = now();
+  uint32_t oldest = 0;
+  for (auto& ring : rings) {
+    uint32_t head = ring.head.load(std::memory_order_acquire);
+    for (uint32_t i = head > CONFIG_THINGY_TRACE_EVENTS ? head - CONFIG_THINGY_TRACE_EVENTS : 0; i < head; i++) {
+      uint32_t age = exportedAt - ring.events[i % CONFIG_THINGY_TRACE_EVENTS].start;
+      if (age > oldest) {
+        oldest = age;
+      }
+    }
+  }
+
+  char chunk[192];
+  bool first = true;
+  out("{\"traceEvents\":[", context);
+  for (auto& ring : rings) {
+    uint32_t head = ring.head.load(std::memory_order_acquire);
+    for (uint32_t i = head > CONFIG_THINGY_TRACE_EVENTS ? head - CONFIG_THINGY_TRACE_EVENTS : 0; i < head; i++) {
+      const Event event = ring.events[i % CONFIG_THINGY_TRACE_EVENTS];
+      if (event.name == nullptr) {
+        continue;
+      }
+      uint32_t ts = oldest - (exportedAt - event.start);
+      int length = snprintf(chunk, sizeof(chunk), "%s{\"name\":\"%s\",\"cat\":\"thingy\",\"ph\":\"%c\",\"ts\":%" PRIu32 ",\"pid\":1,\"tid\":%" PRIu32 ",\"args\":{\"core\":%u}",
+                            first ? "" : ",", event.name, event.phase, ts, event.task, event.core);
+      if (event.phase == COMPLETE) {
+        snprintf(chunk + length, sizeof(chunk) - length, ",\"dur\":%" PRIu32 "}", event.duration);
+      } else if (event.phase == INSTANT) {
+        snprintf(chunk + length, sizeof(chunk) - length, ",\"s\":\"t\"}");
+      } else {
+        snprintf(chunk + length, sizeof(chunk) - length, ",\"id\":%u}", event.id);
+      }
+      out(chunk, context);
+      first = false;
+    }
+  }
+
+#ifdef ARDUINO
+  // name the tasks still around (LED tasks of states gone by stay nameless)
+  static const char* const tasks[] = {"loopTask", "async_tcp", "async_udp", "setLedTask", "ledOutputTask"};
+  for (const char* name : tasks) {
+    TaskHandle_t handle = xTaskGetHandle(name);
+    if (handle != nullptr) {
+      snprintf(chunk, sizeof(chunk), "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%" PRIu32 ",\"args\":{\"name\":\"%s\"}}", first ? "" : ",",
+               static_cast<uint32_t>(reinterpret_cast<uintptr_t>(handle)), name);
+      out(chunk, context);
+      first = false;
+    }
+  }
+#endif
+
+  snprintf(chunk, sizeof(chunk), "],\"displayTimeUnit\":\"ms\",\"otherData\":{\"recorded\":%" PRIu32 "}}", getRecorded());
+  out(chunk, context);
+}
+#endif
@@ -4,26 +4,53 @@
  */
 #include <esp_ota_ops.h>
 #include <esp_partition.h>
+#include <esp_timer.h>
 #include <thingy.h>
+#include <algorithm>
+#include <cstring>
 
 #define TAG "WebServer"
 
-// gzipped assets
-extern const uint8_t logo_start[] asm("_binary__pio_assets_logo_captive_svg_gz_start");
-extern const uint8_t logo_end[] asm("_binary__pio_assets_logo_captive_svg_gz_end");
+// request attribute holding the micros() a request arrived at
+#define ARRIVED_AT "arrivedAt"
+
+namespace {
+  // First of all handlers, stamps each request as soon as its headers are in, yet never handles one
+  // (the handler of a request is looked up right after its headers, before the body and the middleware,
+  // and a small request comes in a single segment anyway)
+  class ArrivalStamp : public AsyncWebHandler {
+    public:
+      bool canHandle(AsyncWebServerRequest* request) const override {
+        request->setAttribute(ARRIVED_AT, static_cast<long>(micros()));
+        return false;
+      }
+  };
+} // namespace
 
 Soylent::WebServerClass::WebServerClass(AsyncWebServer& webServer)
-    : _scheduler(nullptr), _webServer(&webServer) {
+    : _scheduler(nullptr), _webServer(&webServer), _routesRegistered(false), _notFoundRegistered(false), _suspended(false), _resumeRequestedAt(0), _suspendedHeap(0), _admissionRegistered(false), _activeRequests(0), _rejectedRateLimit(0), _rejectedBusy(0) {
   _sr.setWaiting();
+  memset(_buckets, 0, sizeof(_buckets));
 }
 
 void Soylent::WebServerClass::begin(Scheduler* scheduler) {
-  // Just to be sure that the static webserver is not running anymore before being started (again)
-  _webServer->end();
-
   // Task handling
   _sr.setWaiting();
   _scheduler = scheduler;
+
+  // Routes are still registered from a previous start (e.g. before a WiFi reconnect)
+  // so there is no need to tear them down and build them again, just listen again
+  if (_routesRegistered) {
+    _resumeRequestedAt = millis();
+    Task* resumeTask = new Task(TASK_IMMEDIATE, TASK_ONCE, [&] { _resumeCallback(); }, _scheduler, false, NULL, NULL, true);
+    resumeTask->enable();
+    LOGD(TAG, "WebServer is scheduled for resume...");
+    return;
+  }
+
+  // Just to be sure that the static webserver is not running anymore before being started (again)
+  _webServer->end();
+
   // create and run a task for setting up the (static) webserver
   Task* webServerTask = new Task(TASK_IMMEDIATE, TASK_ONCE, [&] { _webServerCallback(); }, _scheduler, false, NULL, NULL, true);
   webServerTask->enable();
@@ -35,20 +62,328 @@ void Soylent::WebServerClass::end() {
   LOGD(TAG, "Disabling WebServer-Task...");
   _sr.setWaiting();
   _webServer->end();
+  // drop all routes and handlers, they will be registered anew with the next begin
+  _webServer->reset();
+  _routesRegistered = false;
+  _notFoundRegistered = false;
+  _suspended = false;
+  LOGD(TAG, "...done!");
+}
+
+// Stop listening, yet keep the routes, handlers (and whatever they hold) for a quick resume
+void Soylent::WebServerClass::suspend() {
+  if (!_routesRegistered || _suspended) {
+    return;
+  }
+
+  LOGD(TAG, "Suspending WebServer...");
+  _sr.setWaiting();
+  _webServer->end();
+  _suspended = true;
+  _suspendedHeap = ESP.getFreeHeap();
   LOGD(TAG, "...done!");
 }
 
+bool Soylent::WebServerClass::isSuspended() {
+  return _suspended;
+}
+
+// Start listening again with the routes from before
+void Soylent::WebServerClass::_resumeCallback() {
+  LOGD(TAG, "Resuming WebServer...");
+
+  // The 404-handler might have been skipped when we were started for the captive portal
+  if (!_notFoundRegistered && EventHandler.getState() != Soylent::ESPConnect::State::PORTAL_STARTED) {
+    _registerNotFoundHandler();
+  }
+
+  _webServer->begin();
+  _suspended = false;
+
+  LOGI(TAG, "...serving again after %u ms (heap delta since suspend: %d bytes)",
+       millis() - _resumeRequestedAt,
+       static_cast<int32_t>(ESP.getFreeHeap()) - static_cast<int32_t>(_suspendedHeap));
+  _sr.signalComplete();
+}
+
+void Soylent::WebServerClass::_registerNotFoundHandler() {
+  LOGD(TAG, "Register 404 handler in WebServer");
+  _webServer->onNotFound([](AsyncWebServerRequest* request) {
+    LOGW(TAG, "Send 404 on request for %s", request->url().c_str());
+    request->send(404);
+  });
+  _notFoundRegistered = true;
+}
+
+// Find (or recycle the least recently seen) token bucket of a client
+Soylent::WebServerClass::ClientBucket* Soylent::WebServerClass::_getBucket(uint32_t address, uint32_t now) {
+  ClientBucket* oldest = &_buckets[0];
+  for (auto& bucket : _buckets) {
+    if (bucket.address == address) {
+      return &bucket;
+    }
+    if (now - bucket.lastSeen > now - oldest->lastSeen) {
+      oldest = &bucket;
+    }
+  }
+
+  oldest->address = address;
+  oldest->tokens = CONFIG_THINGY_HTTP_BURST * 1000;
+  oldest->lastSeen = now;
+  return oldest;
+}
+
+// Take a token from the bucket of a client, returns false if there is none left
+bool Soylent::WebServerClass::_takeToken(uint32_t address) {
+  uint32_t now = millis();
+  ClientBucket* bucket = _getBucket(address, now);
+  bucket->tokens = std::min<uint64_t>(bucket->tokens + static_cast<uint64_t>(now - bucket->lastSeen) * CONFIG_THINGY_HTTP_RATE, CONFIG_THINGY_HTTP_BURST * 1000);
+  bucket->lastSeen = now;
+  if (bucket->tokens < 1000) {
+    _rejectedRateLimit++;
+    return false;
+  }
+  bucket->tokens -= 1000;
+  return true;
+}
+
+// called in the async_tcp task, like the admission of requests (so the buckets aren't shared across tasks)
+bool Soylent::WebServerClass::admitMessage(AsyncWebSocketClient* client) {
+  return _takeToken(static_cast<uint32_t>(client->remoteIP()));
+}
+
+// Admission control, runs in the async_tcp task before any handler
+// requests setting the LED (PUT) are not rate limited and may use the reserved connections
+// (a rejection is a status-only response, which is still allocated like any other)
+bool Soylent::WebServerClass::_admitRequest(AsyncWebServerRequest* request) {
+  // the connection of a WebSocket is taken over by its handler and the request is dropped without a disconnect,
+  // so it would never give back its slot (the sockets limit their clients on their own)
+  const AsyncWebHeader* upgrade = request->getHeader("Upgrade");
+  if (upgrade != nullptr && strcasecmp(upgrade->value().c_str(), "websocket") == 0) {
+    return true;
+  }
+
+  bool control = request->method() == HTTP_PUT;
+  uint16_t maxRequests = CONFIG_THINGY_HTTP_MAX_CONNECTIONS + (control ? CONFIG_THINGY_HTTP_RESERVED_CONNECTIONS : 0);
+  if (_activeRequests >= maxRequests) {
+    _rejectedBusy++;
+    request->send(503);
+    return false;
+  }
+
+  if (!control && !_takeToken(static_cast<uint32_t>(request->client()->remoteIP()))) {
+    request->send(429);
+    return false;
+  }
+
+  _activeRequests++;
+  // a burst of requests raises the CPU clock, every request of it renews the demand right away
+  // and the hold of PowerTask keeps the clock up until the burst is over (see PowerTask.h),
+  // so there is nothing left to release, whichever way the request ends
+  if (_activeRequests >= CONFIG_THINGY_CPU_BOOST_REQUESTS) {
+    Power.boost(Soylent::PowerClass::DEMAND_HTTP);
+    Power.release(Soylent::PowerClass::DEMAND_HTTP);
+  }
+  // (a plain request always ends with its connection being closed)
+  request->onDisconnect([&]() {
+    _activeRequests--;
+  });
+  return true;
+}
+
 // Start the webserver
 void Soylent::WebServerClass::_webServerCallback() {
+  TRACE_SCOPE("webserver.webServerCallback");
   LOGD(TAG, "Starting WebServer...");
 
+  // limit concurrent requests and rate of requests per client
+  if (!_admissionRegistered) {
+    _webServer->addMiddleware([&](AsyncWebServerRequest* request, ArMiddlewareNext next) {
+      // admission, parsing the body (if any) and the handler
+      TRACE_SCOPE("http.request");
+      if (_admitRequest(request)) {
+        next();
+        // handlers might have scheduled tasks (e.g. LED states or restarts)
+        Power.wake();
+      }
+    });
+    _admissionRegistered = true;
+  }
+
+  // stamp requests when they arrive, ahead of any other handler (a reset drops it along with the routes)
+  _webServer->addHandler(new ArrivalStamp());
+
+  // serve some numbers on what's going on
+  _webServer->on("/metrics", HTTP_GET, [&](AsyncWebServerRequest* request) {
+    auto* response = request->beginResponseStream("application/json");
+    JsonDocument doc;
+    JsonObject root = doc.to<JsonObject>();
+
+    JsonObject http = root["http"].to<JsonObject>();
+    http["active"] = _activeRequests;
+    http["rejected_rate_limit"] = _rejectedRateLimit;
+    http["rejected_busy"] = _rejectedBusy;
+
+    // how much the main loop (and the CPU) got to sleep, see PowerTask.h
+    JsonObject power = root["power"].to<JsonObject>();
+    uint64_t uptime = esp_timer_get_time();
+    uint64_t sleepTime = Power.getSleepTime();
+    uint64_t lightSleepTime = Power.getLightSleepTime();
+    power["idle_sleep"] = CONFIG_THINGY_IDLE_SLEEP != 0;
+    power["sleeps"] = Power.getSleeps();
+    power["early_wakeups"] = Power.getEarlyWakeups();
+    power["slept_ms"] = sleepTime / 1000;
+    power["slept_share"] = uptime > 0 ? static_cast<float>(sleepTime) / uptime : 0;
+    JsonObject lightSleep = power["light_sleep"].to<JsonObject>();
+    lightSleep["supported"] = Power.isLightSleepSupported();
+    lightSleep["allowed"] = Power.isLightSleepAllowed();
+    lightSleep["allowed_ms"] = lightSleepTime / 1000;
+    lightSleep["allowed_share"] = uptime > 0 ? static_cast<float>(lightSleepTime) / uptime : 0;
+    // time spent per CPU clock
+    JsonObject cpu = power["cpu"].to<JsonObject>();
+    cpu["scaling"] = Power.isScaling();
+    cpu["mhz"] = getCpuFrequencyMhz();
+    cpu["boosted"] = Power.isBoosted();
+    cpu["boosts"] = Power.getBoosts();
+    JsonObject demands = cpu["demands"].to<JsonObject>();
+    demands["led"] = Power.getDemand(Soylent::PowerClass::DEMAND_LED);
+    demands["http"] = Power.getDemand(Soylent::PowerClass::DEMAND_HTTP);
+    JsonArray timePerFrequency = cpu["time"].to<JsonArray>();
+    if (Power.isScaling()) {
+      JsonObject unboosted = timePerFrequency.add<JsonObject>();
+      unboosted["mhz"] = Power.getMinFrequency();
+      unboosted["ms"] = Power.getUnboostedTime() / 1000;
+    }
+    JsonObject boosted = timePerFrequency.add<JsonObject>();
+    boosted["mhz"] = Power.getMaxFrequency();
+    boosted["ms"] = Power.getBoostedTime() / 1000;
+    // only with run time stats in the sdkconfig
+    if (Power.getIdlePercent(0) >= 0) {
+      JsonArray cpuIdle = power["cpu_idle_percent"].to<JsonArray>();
+      for (uint8_t core = 0; core < portNUM_PROCESSORS; core++) {
+        cpuIdle.add(Power.getIdlePercent(core));
+      }
+    }
+
+    // how much settings wear the flash, see ConfigTask.h
+    JsonObject config = root["config"].to<JsonObject>();
+    const Soylent::ConfigClass::Statistics& configStatistics = Config.getStatistics();
+    config["pending"] = Config.getPending();
+    config["writes"] = configStatistics.writes;
+    config["writes_avoided"] = configStatistics.writesAvoided;
+    config["writes_coalesced"] = configStatistics.writesCoalesced;
+    config["flushes"] = configStatistics.flushes;
+    config["errors"] = configStatistics.errors;
+    config["nvs_entries_written"] = configStatistics.entriesWritten;
+    config["nvs_bytes_written"] = configStatistics.bytesWritten;
+    config["nvs_page_erases_est"] = Config.getEstimatedPageErases();
+
+#if defined(RGB_BUILTIN) && CONFIG_THINGY_FILE_CACHE_SIZE
+    // images from LittleFS kept in RAM, see FileCache.h
+    JsonObject imageCache = root["image_cache"].to<JsonObject>();
+    const Soylent::FileCache::Statistics& imageCacheStatistics = WebSite.getImageCache().getStatistics();
+    imageCache["hits"] = imageCacheStatistics.hits;
+    imageCache["misses"] = imageCacheStatistics.misses;
+    imageCache["bypassed"] = imageCacheStatistics.bypassed;
+    imageCache["not_modified"] = imageCacheStatistics.notModified;
+    imageCache["evictions"] = imageCacheStatistics.evictions;
+    imageCache["invalidations"] = imageCacheStatistics.invalidations;
+    imageCache["files"] = imageCacheStatistics.files;
+    imageCache["bytes"] = imageCacheStatistics.bytes;
+    imageCache["capacity"] = CONFIG_THINGY_FILE_CACHE_SIZE;
+#endif
+    serializeJson(root, *response);
+    request->send(response);
+  });
+
+  // serve what the thingy is running on, rendered just once without any allocation (see SystemInfo.h)
+  _webServer->on("/sysinfo", HTTP_GET, [&](AsyncWebServerRequest* request) {
+    size_t length;
+    const char* json = Soylent::SystemInfo::getJson(&length);
+    // (sent right from the buffer, it never changes)
+    request->send(200, "application/json", reinterpret_cast<const uint8_t*>(json), length);
+  });
+
+  // serve how the thingy came up: how fast the LED was showing something again, compared to the network
+  _webServer->on("/boot", HTTP_GET, [&](AsyncWebServerRequest* request) {
+    auto* response = request->beginResponseStream("application/json");
+    JsonDocument doc;
+    JsonObject root = doc.to<JsonObject>();
+
+    root["reset_reason"] = Soylent::SystemInfo::getResetReason().name;
+    switch (Led.getResumedFrom()) {
+      case Soylent::LedResume::Source::RTC:
+        root["led_resumed_from"] = "rtc";
+        break;
+      case Soylent::LedResume::Source::NVS:
+        root["led_resumed_from"] = "nvs";
+        break;
+      default:
+        root["led_resumed_from"] = "none";
+    }
+    root["led_state"] = static_cast<int>(Led.getLedState());
+    // micros() since start-up (0 if not yet)
+    root["led_initialized_us"] = Led.getInitializedAt();
+    root["led_first_frame_us"] = Led.getFirstShownAt();
+    root["network_up_us"] = EventHandler.getConnectedAt();
+    serializeJson(root, *response);
+    request->send(response);
+  });
+
+  // serve what the stacks and the heap looked like lately, oldest sample first (see TelemetryTask.h)
+  _webServer->on("/telemetry", HTTP_GET, [&](AsyncWebServerRequest* request) {
+    auto* response = request->beginResponseStream("application/json");
+    JsonDocument doc;
+    JsonObject root = doc.to<JsonObject>();
+    root["interval_ms"] = CONFIG_THINGY_TELEMETRY_INTERVAL;
+
+    JsonArray stacks = root["stacks"].to<JsonArray>();
+    for (uint8_t stack = 0; stack < Soylent::TelemetryClass::STACK_COUNT; stack++) {
+      JsonObject entry = stacks.add<JsonObject>();
+      entry["task"] = Soylent::TelemetryClass::getStackName(static_cast<Soylent::TelemetryClass::Stack>(stack));
+      entry["size"] = Soylent::TelemetryClass::getStackSize(static_cast<Soylent::TelemetryClass::Stack>(stack));
+      entry["min_free"] = Telemetry.getStackMinFree(static_cast<Soylent::TelemetryClass::Stack>(stack));
+    }
+
+    JsonArray samples = root["samples"].to<JsonArray>();
+    Soylent::TelemetryClass::Sample sample;
+    for (uint16_t i = 0; Telemetry.getSample(i, &sample); i++) {
+      JsonObject entry = samples.add<JsonObject>();
+      entry["at"] = sample.at;
+      entry["heap_free"] = sample.heapFree;
+      entry["heap_min_free"] = sample.heapMinFree;
+      entry["heap_largest_block"] = sample.heapLargestBlock;
+      JsonArray stackFree = entry["stack_free"].to<JsonArray>();
+      for (int32_t free : sample.stackFree) {
+        stackFree.add(free);
+      }
+    }
+    serializeJson(root, *response);
+    request->send(response);
+  });
+
+#if CONFIG_THINGY_TRACE
+  // serve the trace points recorded lately, in Chrome's trace event format (see Trace.h)
+  _webServer->on("/trace", HTTP_GET, [&](AsyncWebServerRequest* request) {
+    auto* response = request->beginResponseStream("application/json");
+    response->addHeader("Content-Disposition", "attachment; filename=\"thingy.trace.json\"");
+    Soylent::Trace::write(*response);
+    request->send(response);
+  });
+
+  // start over, e.g. right before what's to be traced
+  _webServer->on("/trace", HTTP_DELETE, [&](AsyncWebServerRequest* request) {
+    Soylent::Trace::clear();
+    request->send(200, "text/plain", "OK");
+  });
+#endif
+
   // serve the logo (for captive portal)
   _webServer->on("/logo", HTTP_GET, [&](AsyncWebServerRequest* request) {
               LOGD(TAG, "Serve captive logo...");
-              auto* response = request->beginResponse(200, "image/svg+xml", logo_start, logo_end - logo_start);
-              response->addHeader("Content-Encoding", "gzip");
-              response->addHeader("Cache-Control", "public, max-age=900");
-              request->send(response);
+              if (!Soylent::AssetBundle::send(request, "/logo", "public, max-age=900")) {
+                request->send(404);
+              }
             })
     .setFilter([&](__unused AsyncWebServerRequest* request) {
       return EventHandler.getState() == Soylent::ESPConnect::State::PORTAL_STARTED;
@@ -93,16 +428,14 @@ void Soylent::WebServerClass::_webServerCallback() {
 
   // Set 404-handler only when the captive portal is not shown
   if (EventHandler.getState() != Soylent::ESPConnect::State::PORTAL_STARTED) {
-    LOGD(TAG, "Register 404 handler in WebServer");
-    _webServer->onNotFound([](AsyncWebServerRequest* request) {
-      LOGW(TAG, "Send 404 on request for %s", request->url().c_str());
-      request->send(404);
-    });
+    _registerNotFoundHandler();
   } else {
     LOGD(TAG, "Skip registering 404 handler in WebServer");
   }
 
   _webServer->begin();
+  _routesRegistered = true;
+  _suspended = false;
 
   LOGD(TAG, "...done!");
   _sr.signalComplete();
@@ -111,3 +444,7 @@ void Soylent::WebServerClass::_webServerCallback() {
 StatusRequest* Soylent::WebServerClass::getStatusRequest() {
   return &_sr;
 }
+
+uint32_t Soylent::WebServerClass::getArrivedAt(AsyncWebServerRequest* request) {
+  return static_cast<uint32_t>(request->getAttribute(ARRIVED_AT, static_cast<long>(micros())));
+}
@@ -7,39 +7,45 @@
 #include <string>
 #define TAG "WebSite"
 
-// gzipped assets
-extern const uint8_t logo_thingy_start[] asm("_binary__pio_assets_logo_thingy_svg_gz_start");
-extern const uint8_t logo_thingy_end[] asm("_binary__pio_assets_logo_thingy_svg_gz_end");
-extern const uint8_t touchicon_start[] asm("_binary__pio_assets_apple_touch_icon_png_gz_start");
-extern const uint8_t touchicon_end[] asm("_binary__pio_assets_apple_touch_icon_png_gz_end");
-extern const uint8_t favicon_svg_start[] asm("_binary__pio_assets_favicon_svg_gz_start");
-extern const uint8_t favicon_svg_end[] asm("_binary__pio_assets_favicon_svg_gz_end");
-extern const uint8_t favicon_96_png_start[] asm("_binary__pio_assets_favicon_96x96_png_gz_start");
-extern const uint8_t favicon_96_png_end[] asm("_binary__pio_assets_favicon_96x96_png_gz_end");
-extern const uint8_t favicon_ico_start[] asm("_binary__pio_assets_favicon_ico_gz_start");
-extern const uint8_t favicon_ico_end[] asm("_binary__pio_assets_favicon_ico_gz_end");
-extern const uint8_t thingy_html_start[] asm("_binary__pio_assets_thingy_html_gz_start");
-extern const uint8_t thingy_html_end[] asm("_binary__pio_assets_thingy_html_gz_end");
-
 // constants from build process
 extern const char* __COMPILED_BUILD_BOARD__;
-extern char* __COMPILED_BUILD_TIMESTAMP__;
+extern const char* __COMPILED_BUILD_TIMESTAMP__;
+
+// served at / without an asset bundle (the home page is in there), kept in flash
+static const char NO_ASSETS_PAGE[] =
+  "<!DOCTYPE html><html><head><meta name=\"viewport\" content=\"width=device-width\"><title>" APP_NAME "</title></head><body><h1>" APP_NAME "</h1>"
+  "<p>The web assets are missing, upload <code>assets.bin</code> in <a href=\"/safeboot\">SafeBoot</a> (filesystem mode).</p></body></html>";
+// (an update over the air can't change the partition table)
+static const char NO_ASSETS_PARTITION_PAGE[] =
+  "<!DOCTYPE html><html><head><meta name=\"viewport\" content=\"width=device-width\"><title>" APP_NAME "</title></head><body><h1>" APP_NAME "</h1>"
+  "<p>There is no partition for the web assets, the partition table is still the one of an older version. Flash the <code>factory.bin</code> via USB once.</p></body></html>";
 
 Soylent::WebSiteClass::WebSiteClass(AsyncWebServer& webServer)
-    : _ledStateIdx(0), _setLEDHandler(nullptr), _scheduler(nullptr), _ledStateCount(LED_STATES_PLAIN)
+    : _setLEDHandler(nullptr), _setLayerHandler(nullptr), _ledSocket(nullptr), _previewSocket(nullptr), _previewTask(nullptr), _previewFrames(0), _previewBytes(0), _previewSkipped(0), _previewTimeSum(0), _scheduler(nullptr), _webServer(&webServer), _ledStateCount(LED_STATES_PLAIN)
 #ifdef RGB_BUILTIN
       ,
       _fsMounted(false), _ledStatesJson(nullptr)
+  #if CONFIG_THINGY_FILE_CACHE_SIZE
+      ,
+      _imageCache(LittleFS)
+  #endif
 #endif
       ,
-      _webServer(&webServer) {
+      _ledStateIdx(0), _routesRegistered(false) {
 }
 
 void Soylent::WebSiteClass::begin(Scheduler* scheduler) {
-  LOGD(TAG, "Enabling WebSite-Task...");
-
   // Task handling
   _scheduler = scheduler;
+
+  // Everything is still in place from before (e.g. WiFi reconnected)
+  // the WebServer will resume serving our routes
+  if (_routesRegistered) {
+    LOGD(TAG, "WebSite is still registered, nothing to do...");
+    return;
+  }
+
+  LOGD(TAG, "Enabling WebSite-Task...");
   // create and run a task for setting up the website
   Task* webSiteTask = new Task(TASK_IMMEDIATE, TASK_ONCE, [&] { _webSiteCallback(); }, _scheduler, false, NULL, NULL, true);
   webSiteTask->enable();
@@ -47,12 +53,43 @@ void Soylent::WebSiteClass::begin(Scheduler* scheduler) {
 }
 
 void Soylent::WebSiteClass::end() {
+  // the webserver owns the handlers, removing will also free them
   if (_setLEDHandler != nullptr) {
-    delete _setLEDHandler;
+    _webServer->removeHandler(_setLEDHandler);
     _setLEDHandler = nullptr;
   }
 
+  if (_setLayerHandler != nullptr) {
+    _webServer->removeHandler(_setLayerHandler);
+    _setLayerHandler = nullptr;
+  }
+
+  if (_ledSocket != nullptr) {
+    _ledSocket->closeAll();
+    _webServer->removeHandler(_ledSocket);
+    _ledSocket = nullptr;
+  }
+
+  if (_previewSocket != nullptr) {
+    _previewSocket->closeAll();
+    _webServer->removeHandler(_previewSocket);
+    _previewSocket = nullptr;
+  }
+  if (_previewTask != nullptr) {
+    _previewTask->disable();
+    delete _previewTask;
+    _previewTask = nullptr;
+  }
+  Led.getPipeline().setPreview(false);
+  for (auto& previewClient : _previewClients) {
+    previewClient.id = 0;
+  }
+  _routesRegistered = false;
+
 #ifdef RGB_BUILTIN
+  #if CONFIG_THINGY_FILE_CACHE_SIZE
+  _imageCache.invalidate();
+  #endif
   LittleFS.end();
   if (_ledStatesJson != nullptr) {
     delete _ledStatesJson;
@@ -61,6 +98,278 @@ void Soylent::WebSiteClass::end() {
 #endif
 }
 
+// Set the LED state by its index (0...3 are hardcoded, more might come from led_states.json)
+Soylent::LedCommand::Status Soylent::WebSiteClass::_setLedStateIdx(int32_t led_state_idx, uint32_t commandAt) {
+#ifndef LED_BUILTIN
+  LOGW(TAG, "LED not available");
+  return Soylent::LedCommand::Status::UNAVAILABLE;
+#else
+  if (led_state_idx < 0 || led_state_idx > _ledStateCount - 1) {
+    LOGW(TAG, "state_idx out of bounds");
+    return Soylent::LedCommand::Status::OUT_OF_BOUNDS;
+  }
+
+  switch (led_state_idx) {
+    case 0:
+      // 0 is hardcoded to off
+      LOGI(TAG, "Switch LED to off!");
+      Led.setLedState(Soylent::LedClass::LedState::OFF, commandAt);
+      _ledStateIdx = led_state_idx;
+      break;
+    case 1:
+      // 1 is hardcoded to on
+      LOGI(TAG, "Switch LED to on!");
+      Led.setLedState(Soylent::LedClass::LedState::ON, commandAt);
+      _ledStateIdx = led_state_idx;
+      break;
+    case 2:
+      // 2 is hardcoded to Blinking
+      LOGI(TAG, "Switch LED to on and off and on and ...!");
+      Led.setLedState(Soylent::LedClass::LedState::BLINK, commandAt);
+      _ledStateIdx = led_state_idx;
+      break;
+    case 3:
+  // 3 is hardcoded to Rainbow
+  #ifdef RGB_BUILTIN
+      LOGI(TAG, "Show a beautiful rainbow...!");
+  #else
+      LOGI(TAG, "Show a boring rainbow...!");
+  #endif
+      Led.setLedState(Soylent::LedClass::LedState::RAINBOW, commandAt);
+      _ledStateIdx = led_state_idx;
+      break;
+    default: {
+      // show an something else?
+      LOGI(TAG, "I want to show something!");
+      // auto img_name = _imagesJson->as<JsonObject>()["images"].as<JsonArray>()[img_idx-1].as<JsonObject>()["src"];
+      // Display.showImage(img_name);
+  #ifdef RGB_BUILTIN
+      // play an animation from LittleFS, e.g. {"name": "Fire!", "src": "/images/fire.svg", "animation": "/fire.leda"}
+      JsonVariant animation = _ledStatesJson->as<JsonObject>()["led_states"][led_state_idx - LED_STATES_PLAIN]["animation"];
+      if (animation.is<const char*>()) {
+        Led.playAnimation(animation.as<const char*>(), commandAt);
+      }
+  #endif
+      _ledStateIdx = led_state_idx;
+    }
+  }
+
+  return Soylent::LedCommand::Status::OK;
+#endif
+}
+
+// The index of what the LED is showing (the current index, when it's not one of them)
+int32_t Soylent::WebSiteClass::_ledStateIdxOf(Soylent::LedClass::LedState ledState) {
+  switch (ledState) {
+    case Soylent::LedClass::LedState::OFF:
+    case Soylent::LedClass::LedState::ON:
+    case Soylent::LedClass::LedState::BLINK:
+    case Soylent::LedClass::LedState::RAINBOW:
+      return static_cast<int32_t>(ledState);
+#ifdef RGB_BUILTIN
+    case Soylent::LedClass::LedState::PLAYBACK: {
+      const char* animation = Led.getAnimation();
+      if (_fsMounted && animation != nullptr) {
+        JsonArray ledStates = _ledStatesJson->as<JsonObject>()["led_states"].as<JsonArray>();
+        for (int32_t idx = LED_STATES_PLAIN + 1; idx < _ledStateCount; idx++) {
+          const char* path = ledStates[idx - LED_STATES_PLAIN]["animation"];
+          if (path != nullptr && strcmp(path, animation) == 0) {
+            return idx;
+          }
+        }
+      }
+      return _ledStateIdx;
+    }
+#endif
+    default:
+      return _ledStateIdx;
+  }
+}
+
+// Decode and run a binary command, without any allocation
+// the same status, whichever API it's answered on
+int Soylent::WebSiteClass::_httpCodeOf(Soylent::LedCommand::Status status) {
+  switch (status) {
+    case Soylent::LedCommand::Status::OK:
+      return 200;
+    case Soylent::LedCommand::Status::OUT_OF_BOUNDS:
+      return 418;
+    case Soylent::LedCommand::Status::UNAVAILABLE:
+      return 503;
+    case Soylent::LedCommand::Status::RATE_LIMITED:
+      return 429;
+    default:
+      return 400;
+  }
+}
+
+Soylent::LedCommand Soylent::WebSiteClass::_dispatchLedCommand(const uint8_t* data, size_t len, uint32_t commandAt) {
+  uint32_t start = micros();
+  auto* command = Soylent::LedCommand::decode(data, len);
+  Soylent::LedCommand::Status status = Soylent::LedCommand::Status::BAD_REQUEST;
+  if (command != nullptr) {
+    switch (command->code) {
+      case Soylent::LedCommand::Opcode::GET_STATE:
+        status = Soylent::LedCommand::Status::OK;
+        break;
+      case Soylent::LedCommand::Opcode::SET_STATE:
+        status = _setLedStateIdx(command->stateIdx, commandAt);
+        break;
+      default:
+        break;
+    }
+  }
+
+  LOGD(TAG, "Binary command dispatched in %u us (%u bytes)", micros() - start, len);
+  return Soylent::LedCommand(status, _ledStateIdx);
+}
+
+// Find the slot of the command of a request, or take a free one (or the least recently received) for it
+// called in the async_tcp task
+Soylent::WebSiteClass::CommandSlot* Soylent::WebSiteClass::_getCommandSlot(const AsyncWebServerRequest* request, bool take) {
+  uint32_t now = millis();
+  CommandSlot* oldest = &_commandSlots[0];
+  for (auto& slot : _commandSlots) {
+    if (slot.request == request) {
+      return &slot;
+    }
+    if (oldest->request != nullptr && (slot.request == nullptr || now - slot.receivedAt > now - oldest->receivedAt)) {
+      oldest = &slot;
+    }
+  }
+  if (!take) {
+    return nullptr;
+  }
+
+  oldest->request = request;
+  oldest->receivedAt = now;
+  oldest->complete = false;
+  return oldest;
+}
+
+// Subscribers come and go, and ask for the rate they like (a single byte of frames per second)
+// called in the async_tcp task
+void Soylent::WebSiteClass::_previewEvent(AsyncWebSocketClient* client, AwsEventType type, void* arg, uint8_t* data, size_t len) {
+  switch (type) {
+    case WS_EVT_CONNECT: {
+      bool subscribed = false;
+      taskENTER_CRITICAL(&cs_spinlock);
+      for (auto& previewClient : _previewClients) {
+        if (previewClient.id == 0) {
+          previewClient.id = client->id();
+          previewClient.rate = CONFIG_THINGY_LED_PREVIEW_RATE;
+          previewClient.dueAt = millis();
+          previewClient.sequence = 0;
+          previewClient.keyframe = true;
+          subscribed = true;
+          break;
+        }
+      }
+      taskEXIT_CRITICAL(&cs_spinlock);
+
+      if (!subscribed) {
+        LOGW(TAG, "Too many preview subscribers!");
+        client->close();
+        return;
+      }
+      // the LED starts keeping its frames for us
+      Led.getPipeline().setPreview(true);
+      _previewTask->enableIfNot();
+      Power.wake();
+      break;
+    }
+    case WS_EVT_DISCONNECT:
+      taskENTER_CRITICAL(&cs_spinlock);
+      for (auto& previewClient : _previewClients) {
+        if (previewClient.id == client->id()) {
+          previewClient.id = 0;
+        }
+      }
+      taskEXIT_CRITICAL(&cs_spinlock);
+      break;
+    case WS_EVT_DATA: {
+      auto* info = static_cast<AwsFrameInfo*>(arg);
+      if (info->final && info->index == 0 && info->len == 1 && len == 1 && info->opcode == WS_BINARY) {
+        taskENTER_CRITICAL(&cs_spinlock);
+        for (auto& previewClient : _previewClients) {
+          if (previewClient.id == client->id()) {
+            previewClient.rate = std::min<uint8_t>(data[0], CONFIG_THINGY_LED_PREVIEW_MAX_RATE);
+          }
+        }
+        taskEXIT_CRITICAL(&cs_spinlock);
+      }
+      break;
+    }
+    default:
+      break;
+  }
+}
+
+// Send the frame shown to the subscribers that are due, as difference to what they have seen before
+// message: 'P', flags (1: keyframe), uint16_t number of pixels, ops (see LedAnimation::encode())
+void Soylent::WebSiteClass::_sendPreview() {
+  if (_previewSocket->count() == 0) {
+    // nobody is watching anymore, so it's not costing anything
+    Led.getPipeline().setPreview(false);
+    _previewTask->disable();
+    return;
+  }
+
+  Soylent::LedPipeline::Frame& frame = _previewFrame;
+  uint32_t sequence = Led.getPipeline().getPreview(&frame);
+  // as the LED is showing it
+  if (frame.uniform) {
+    fill_solid(frame.pixels, CONFIG_THINGY_LED_COUNT, frame.pixels[0]);
+  }
+  Soylent::PixelKernels::Selected::scale(frame.pixels, CONFIG_THINGY_LED_COUNT, frame.brightness);
+
+  static const CRGB black[CONFIG_THINGY_LED_COUNT] = {};
+  uint8_t* message = _previewMessage;
+  uint32_t now = millis();
+  for (auto& previewClient : _previewClients) {
+    taskENTER_CRITICAL(&cs_spinlock);
+    uint32_t id = previewClient.id;
+    uint8_t rate = previewClient.rate;
+    taskEXIT_CRITICAL(&cs_spinlock);
+    // nothing new or not due yet
+    if (id == 0 || rate == 0 || (sequence == previewClient.sequence && !previewClient.keyframe) || static_cast<int32_t>(now - previewClient.dueAt) < 0) {
+      continue;
+    }
+
+    AsyncWebSocketClient* client = _previewSocket->client(id);
+    if (client == nullptr) {
+      continue;
+    }
+    // don't pile up frames for slow subscribers, they'll get the difference to the next one
+    if (!client->canSend()) {
+      _previewSkipped++;
+      continue;
+    }
+
+    uint32_t startedAt = micros();
+    const CRGB* from = previewClient.keyframe ? black : previewClient.pixels;
+    size_t length = Soylent::LedAnimation::encode(from[0].raw, frame.pixels[0].raw, sizeof(frame.pixels), &message[4]);
+    message[0] = 'P';
+    message[1] = previewClient.keyframe ? 1 : 0;
+    message[2] = CONFIG_THINGY_LED_COUNT & 0xFF;
+    message[3] = CONFIG_THINGY_LED_COUNT >> 8;
+    client->binary(message, 4 + length);
+    memcpy(previewClient.pixels, frame.pixels, sizeof(frame.pixels));
+    previewClient.keyframe = false;
+    previewClient.sequence = sequence;
+    // the frames are due one after another, whenever this task gets to run in between
+    // (without catching up on the ones missed, e.g. while nothing changed or the client was busy)
+    previewClient.dueAt += 1000u / rate;
+    if (static_cast<int32_t>(now - previewClient.dueAt) >= 0) {
+      previewClient.dueAt = now + 1000u / rate;
+    }
+
+    _previewTimeSum += micros() - startedAt;
+    _previewBytes += 4 + length;
+    _previewFrames++;
+  }
+}
+
 // Add Handlers to the webserver
 void Soylent::WebSiteClass::_webSiteCallback() {
   LOGD(TAG, "Starting WebSite...");
@@ -94,9 +403,21 @@ void Soylent::WebSiteClass::_webSiteCallback() {
   _ledStateCount = LED_STATES_PLAIN;
 #endif
 
+  // the LED might have resumed its state from before a restart
+  _ledStateIdx = _ledStateIdxOf(Led.getLedState());
+
 #ifdef RGB_BUILTIN
+  // (the images belong to the File System, so an update of it shows up right away)
+  #if CONFIG_THINGY_FILE_CACHE_SIZE
+  // serve from File System, small images from RAM after the first request
+  _webServer->on("/images/*", HTTP_GET, [&](AsyncWebServerRequest* request) {
+              _imageCache.send(request, std::string(request->url().c_str()).substr(strlen("/images")), "public, max-age=900");
+            })
+    .setFilter([&](__unused AsyncWebServerRequest* request) { return _fsMounted; });
+  #else
   // serve from File System
   _webServer->serveStatic("/images/", LittleFS, "/").setFilter([&](__unused AsyncWebServerRequest* request) { return _fsMounted; });
+  #endif
 
   // serve from File System
   _webServer->serveStatic("/led_states.json", LittleFS, "/led_states.json", "no-store").setFilter([&](__unused AsyncWebServerRequest* request) { return _fsMounted; });
@@ -115,58 +436,22 @@ void Soylent::WebSiteClass::_webSiteCallback() {
   });
 #endif
   _setLEDHandler->onRequest([&](AsyncWebServerRequest* request, JsonVariant& json) {
+    // (the body came in before http.request, the handler deserialized it within http.request right before calling us)
+    TRACE_SCOPE("http.putLedState");
     LOGD(TAG, "Serve (put) /led/state");
     auto led_state_idx = json.as<JsonObject>()["state_idx"].as<int32_t>();
     LOGD(TAG, "Got state_idx: %d", led_state_idx);
-#ifndef LED_BUILTIN
-    LOGW(TAG, "LED not available");
-    request->send(503, "text/plain", "LED not available");
-#else
-    if (led_state_idx < 0 || led_state_idx > _ledStateCount - 1) {
-      LOGW(TAG, "state_idx out of bounds");
-      request->send(418, "text/plain", "state_idx out of bounds");
-    } else {
-      switch (led_state_idx) {
-        case 0:
-          // 0 is hardcoded to off
-          LOGI(TAG, "Switch LED to off!");
-          Led.setLedState(Soylent::LedClass::LedState::OFF);
-          _ledStateIdx = led_state_idx;
-          break;
-        case 1:
-          // 1 is hardcoded to on
-          LOGI(TAG, "Switch LED to on!");
-          Led.setLedState(Soylent::LedClass::LedState::ON);
-          _ledStateIdx = led_state_idx;
-          break;
-        case 2:
-          // 2 is hardcoded to Blinking
-          LOGI(TAG, "Switch LED to on and off and on and ...!");
-          Led.setLedState(Soylent::LedClass::LedState::BLINK);
-          _ledStateIdx = led_state_idx;
-          break;
-        case 3:
-  // 3 is hardcoded to Rainbow
-  #ifdef RGB_BUILTIN
-          LOGI(TAG, "Show a beautiful rainbow...!");
-  #else
-          LOGI(TAG, "Show a boring rainbow...!");
-  #endif
-          Led.setLedState(Soylent::LedClass::LedState::RAINBOW);
-          _ledStateIdx = led_state_idx;
-          break;
-        default: {
-          // show an something else?
-          LOGI(TAG, "I want to show something!");
-          // auto img_name = _imagesJson->as<JsonObject>()["images"].as<JsonArray>()[img_idx-1].as<JsonObject>()["src"];
-          // Display.showImage(img_name);
-          _ledStateIdx = led_state_idx;
-        }
-      }
-
-      request->send(200, "text/plain", "OK");
+    Soylent::LedCommand::Status status = _setLedStateIdx(led_state_idx, Soylent::WebServerClass::getArrivedAt(request));
+    switch (status) {
+      case Soylent::LedCommand::Status::UNAVAILABLE:
+        request->send(_httpCodeOf(status), "text/plain", "LED not available");
+        break;
+      case Soylent::LedCommand::Status::OUT_OF_BOUNDS:
+        request->send(_httpCodeOf(status), "text/plain", "state_idx out of bounds");
+        break;
+      default:
+        request->send(_httpCodeOf(status), "text/plain", "OK");
     }
-#endif
   });
 
   // Register handler for setting led state
@@ -188,16 +473,316 @@ void Soylent::WebSiteClass::_webSiteCallback() {
       return EventHandler.getState() != Soylent::ESPConnect::State::PORTAL_STARTED;
     });
 
+  // compact binary alternative to the JSON-API (see LedCommand.h)
+  _webServer->on(
+               "/led/command",
+               HTTP_PUT,
+               [&](AsyncWebServerRequest* request) {
+                 // admitted, the command is carried out only now
+                 TRACE_SCOPE("http.ledCommand");
+                 Soylent::LedCommand reply(Soylent::LedCommand::Status::BAD_REQUEST, _ledStateIdx);
+                 CommandSlot* slot = _getCommandSlot(request, false);
+                 if (slot != nullptr) {
+                   if (slot->complete && request->contentLength() == sizeof(Soylent::LedCommand)) {
+                     reply = _dispatchLedCommand(slot->command, sizeof(Soylent::LedCommand), Soylent::WebServerClass::getArrivedAt(request));
+                   }
+                   slot->request = nullptr;
+                 }
+                 request->send(_httpCodeOf(static_cast<Soylent::LedCommand::Status>(reply.code)),
+                               "application/octet-stream",
+                               reinterpret_cast<const uint8_t*>(&reply),
+                               sizeof(reply));
+               },
+               nullptr,
+               [&](AsyncWebServerRequest* request, uint8_t* data, size_t len, size_t index, size_t total) {
+                 // the body arrives before the request passes admission, it's only kept until then
+                 // (a command is a few bytes, it comes in at once)
+                 if (index == 0) {
+                   CommandSlot* slot = _getCommandSlot(request, true);
+                   slot->complete = len == total && total == sizeof(Soylent::LedCommand);
+                   if (slot->complete) {
+                     memcpy(slot->command, data, len);
+                   }
+                 }
+               })
+    .setFilter([&](__unused AsyncWebServerRequest* request) {
+      return EventHandler.getState() != Soylent::ESPConnect::State::PORTAL_STARTED;
+    });
+
+  _ledSocket = new AsyncWebSocket("/led/ws");
+  _ledSocket->onEvent([&](__unused AsyncWebSocket* server, AsyncWebSocketClient* client, AwsEventType type, void* arg, uint8_t* data, size_t len) {
+    if (type != WS_EVT_DATA) {
+      return;
+    }
+
+    // only single-frame binary messages are commands
+    auto* info = static_cast<AwsFrameInfo*>(arg);
+    Soylent::LedCommand reply(Soylent::LedCommand::Status::BAD_REQUEST, _ledStateIdx);
+    if (!WebServer.admitMessage(client)) {
+      reply.code = Soylent::LedCommand::Status::RATE_LIMITED;
+    } else if (info->final && info->index == 0 && info->len == len && info->opcode == WS_BINARY) {
+      // (a command is a single frame of a few bytes, it's handed over as soon as it's in)
+      reply = _dispatchLedCommand(data, len, micros());
+    }
+    client->binary(reinterpret_cast<const uint8_t*>(&reply), sizeof(reply));
+  });
+  _webServer->addHandler(_ledSocket);
+
+  // live preview of what the LED is showing, only while anybody is subscribed
+  _previewTask = new Task(1000 / CONFIG_THINGY_LED_PREVIEW_MAX_RATE, TASK_FOREVER, [&] { _sendPreview(); }, _scheduler, false);
+  _previewSocket = new AsyncWebSocket("/led/preview/ws");
+  _previewSocket->onEvent([&](__unused AsyncWebSocket* server, AsyncWebSocketClient* client, AwsEventType type, void* arg, uint8_t* data, size_t len) {
+    _previewEvent(client, type, arg, data, len);
+  });
+  _webServer->addHandler(_previewSocket);
+
+  // put one of the plain LED states on top of the current one (e.g. a notification)
+  // {"layer": 0, "state_idx": 2, "opacity": 255, "blend": "add", "duration": 3000}, state_idx -1 removes the layer
+  _setLayerHandler = new AsyncCallbackJsonWebHandler("/led/layer");
+  _setLayerHandler->setMethod(HTTP_PUT);
+  _setLayerHandler->setFilter([&](__unused AsyncWebServerRequest* request) {
+    return EventHandler.getState() != Soylent::ESPConnect::State::PORTAL_STARTED;
+  });
+  _setLayerHandler->onRequest([&](AsyncWebServerRequest* request, JsonVariant& json) {
+    JsonObject root = json.as<JsonObject>();
+    auto layer = root["layer"] | -1;
+    auto led_state_idx = root["state_idx"] | -1;
+    if (layer < 0 || layer >= CONFIG_THINGY_LED_LAYERS || led_state_idx < -1 || led_state_idx > static_cast<int>(Soylent::LedClass::LedState::RAINBOW)) {
+      request->send(418, "text/plain", "layer or state_idx out of bounds");
+      return;
+    }
+
+    Soylent::LedCompositor::BlendMode blendMode = Soylent::LedCompositor::BlendMode::ALPHA;
+    const char* blend = root["blend"] | "alpha";
+    if (strcmp(blend, "add") == 0) {
+      blendMode = Soylent::LedCompositor::BlendMode::ADD;
+    } else if (strcmp(blend, "multiply") == 0) {
+      blendMode = Soylent::LedCompositor::BlendMode::MULTIPLY;
+    } else if (strcmp(blend, "screen") == 0) {
+      blendMode = Soylent::LedCompositor::BlendMode::SCREEN;
+    }
+
+    LOGD(TAG, "Put state_idx %d on layer %d (%s)", led_state_idx, layer, blend);
+    Led.setLayer(layer, static_cast<Soylent::LedClass::LedState>(led_state_idx), root["opacity"] | 255, blendMode, root["duration"] | 0);
+    request->send(200, "text/plain", "OK");
+  });
+  _webServer->addHandler(_setLayerHandler);
+
+  // serve the layers and how long compositing them takes
+  _webServer->on("/led/layers", HTTP_GET, [&](AsyncWebServerRequest* request) {
+              auto* response = request->beginResponseStream("application/json");
+              JsonDocument doc;
+              JsonObject root = doc.to<JsonObject>();
+
+              JsonArray layers = root["layers"].to<JsonArray>();
+              for (uint8_t i = 0; i < CONFIG_THINGY_LED_LAYERS; i++) {
+                Soylent::LedCompositor::Layer layer;
+                JsonObject entry = layers.add<JsonObject>();
+                if (Led.getLayer(i, &layer)) {
+                  entry["state_idx"] = layer.ledState;
+                  entry["opacity"] = layer.opacity;
+                  entry["blend"] = static_cast<uint8_t>(layer.blendMode);
+                } else {
+                  entry["state_idx"] = -1;
+                }
+              }
+              root["pixels"] = Led.getFrameBufferSize();
+              root["frames"] = Led.getLayerFrames();
+              root["frame_time_avg_us"] = Led.getLayerFrameTimeAvg();
+              root["frame_time_max_us"] = Led.getLayerFrameTimeMax();
+              serializeJson(root, *response);
+              request->send(response);
+            })
+    .setFilter([&](__unused AsyncWebServerRequest* request) {
+      return EventHandler.getState() != Soylent::ESPConnect::State::PORTAL_STARTED;
+    });
+
+  // serve the estimated current of the LEDs and how much they are dimmed to stay within the budget
+  _webServer->on("/led/power", HTTP_GET, [&](AsyncWebServerRequest* request) {
+              auto* response = request->beginResponseStream("application/json");
+              JsonDocument doc;
+              JsonObject root = doc.to<JsonObject>();
+
+              const Soylent::LedPower::Budget& power = Led.getPowerBudget();
+              root["budget_ma"] = CONFIG_THINGY_LED_POWER_BUDGET;
+              root["estimated_ma"] = power.getMilliamps();
+              root["estimates"] = power.getEstimates();
+              root["limited"] = power.getLimited();
+              root["update_avg_us"] = power.getUpdateTimeAvg();
+              root["update_max_us"] = power.getUpdateTimeMax();
+              serializeJson(root, *response);
+              request->send(response);
+            })
+    .setFilter([&](__unused AsyncWebServerRequest* request) {
+      return EventHandler.getState() != Soylent::ESPConnect::State::PORTAL_STARTED;
+    });
+
+  // serve how much time temporal dithering takes
+  _webServer->on("/led/dither", HTTP_GET, [&](AsyncWebServerRequest* request) {
+              auto* response = request->beginResponseStream("application/json");
+              JsonDocument doc;
+              JsonObject root = doc.to<JsonObject>();
+
+              const Soylent::LedDither::Dither& dither = Led.getDither();
+              root["enabled"] = Soylent::LedClass::Output::dither;
+              root["rate"] = CONFIG_THINGY_LED_DITHER_RATE;
+              root["dithering"] = dither.isFractional();
+              root["frames"] = dither.getFrames();
+              root["frame_time_avg_us"] = dither.getFrameTimeAvg();
+              root["frame_time_max_us"] = dither.getFrameTimeMax();
+              serializeJson(root, *response);
+              request->send(response);
+            })
+    .setFilter([&](__unused AsyncWebServerRequest* request) {
+      return EventHandler.getState() != Soylent::ESPConnect::State::PORTAL_STARTED;
+    });
+
+  // serve what the live preview costs (in CPU time and bytes sent)
+  _webServer->on("/led/preview", HTTP_GET, [&](AsyncWebServerRequest* request) {
+              auto* response = request->beginResponseStream("application/json");
+              JsonDocument doc;
+              JsonObject root = doc.to<JsonObject>();
+
+              root["subscribers"] = _previewSocket->count();
+              root["max_rate"] = CONFIG_THINGY_LED_PREVIEW_MAX_RATE;
+              root["frames"] = _previewFrames;
+              root["bytes"] = _previewBytes;
+              root["skipped"] = _previewSkipped;
+              root["send_time_sum_us"] = _previewTimeSum;
+              root["send_time_avg_us"] = _previewFrames ? _previewTimeSum / _previewFrames : 0;
+              serializeJson(root, *response);
+              request->send(response);
+            })
+    .setFilter([&](__unused AsyncWebServerRequest* request) {
+      return EventHandler.getState() != Soylent::ESPConnect::State::PORTAL_STARTED;
+    });
+
+  // serve how long LED commands take until they are shown, reset on every read (e.g. by a scraper)
+  _webServer->on("/led/latency", HTTP_GET, [&](AsyncWebServerRequest* request) {
+              auto* response = request->beginResponseStream("application/json");
+              JsonDocument doc;
+              JsonObject root = doc.to<JsonObject>();
+
+              Soylent::LatencyHistogram::Summary latency = Led.getPipeline().getCommandLatency().summarize(true);
+              root["count"] = latency.count;
+              root["min_us"] = latency.min;
+              root["avg_us"] = latency.avg;
+              root["p50_us"] = latency.p50;
+              root["p90_us"] = latency.p90;
+              root["p99_us"] = latency.p99;
+              root["max_us"] = latency.max;
+              root["since_ms"] = millis() - latency.since;
+              serializeJson(root, *response);
+              request->send(response);
+            })
+    .setFilter([&](__unused AsyncWebServerRequest* request) {
+      return EventHandler.getState() != Soylent::ESPConnect::State::PORTAL_STARTED;
+    });
+
+  // serve how fast animations are decoded
+  _webServer->on("/led/animation", HTTP_GET, [&](AsyncWebServerRequest* request) {
+              auto* response = request->beginResponseStream("application/json");
+              JsonDocument doc;
+              JsonObject root = doc.to<JsonObject>();
+
+              const Soylent::LedAnimation::Statistics& animation = Led.getAnimationStatistics();
+              uint32_t frames = animation.frames;
+              uint32_t decodeTimeAvg = frames ? animation.decodeTimeSum / frames : 0;
+              root["playing"] = Led.getAnimation();
+              root["frames"] = frames;
+              root["keyframes"] = animation.keyframes;
+              root["reads"] = animation.reads;
+              root["errors"] = animation.errors;
+              root["decode_avg_us"] = decodeTimeAvg;
+              root["decode_max_us"] = animation.decodeTimeMax;
+              root["decode_fps"] = decodeTimeAvg ? 1000000 / decodeTimeAvg : 0;
+              serializeJson(root, *response);
+              request->send(response);
+            })
+    .setFilter([&](__unused AsyncWebServerRequest* request) {
+      return EventHandler.getState() != Soylent::ESPConnect::State::PORTAL_STARTED;
+    });
+
+  // serve how far the frames shown are off from their schedule
+  _webServer->on("/led/pipeline", HTTP_GET, [&](AsyncWebServerRequest* request) {
+              auto* response = request->beginResponseStream("application/json");
+              JsonDocument doc;
+              JsonObject root = doc.to<JsonObject>();
+
+              const Soylent::LedPipeline::Pipeline& pipeline = Led.getPipeline();
+              root["pipelined"] = Soylent::LedClass::pipelined;
+              root["render_core"] = CONFIG_THINGY_LED_RENDER_CORE;
+              root["output_core"] = CONFIG_THINGY_LED_OUTPUT_CORE;
+              root["frames"] = pipeline.getFrames();
+              root["dropped"] = pipeline.getDropped();
+              root["scheduled"] = pipeline.getScheduled();
+              root["jitter_sum_us"] = pipeline.getJitterSum();
+              root["jitter_avg_us"] = pipeline.getJitterAvg();
+              root["jitter_max_us"] = pipeline.getJitterMax();
+              serializeJson(root, *response);
+              request->send(response);
+            })
+    .setFilter([&](__unused AsyncWebServerRequest* request) {
+      return EventHandler.getState() != Soylent::ESPConnect::State::PORTAL_STARTED;
+    });
+
+  // serve statistics of pixel streaming (DDP / E1.31)
+  _webServer->on("/led/stream", HTTP_GET, [&](AsyncWebServerRequest* request) {
+              auto* response = request->beginResponseStream("application/json");
+              JsonDocument doc;
+              JsonObject root = doc.to<JsonObject>();
+
+              switch (LedStream.getProtocol()) {
+                case Soylent::LedStreamClass::Protocol::DDP:
+                  root["protocol"] = "ddp";
+                  break;
+                case Soylent::LedStreamClass::Protocol::E131:
+                  root["protocol"] = "e131";
+                  break;
+                default:
+                  root["protocol"] = "none";
+              }
+              root["streaming"] = LedStream.isStreaming();
+              root["received"] = LedStream.getPacketsReceived();
+              root["dropped"] = LedStream.getPacketsDropped();
+              root["frames"] = Led.getFramesShown();
+              root["latency_avg_us"] = Led.getFrameLatencyAvg();
+              root["latency_max_us"] = Led.getFrameLatencyMax();
+              serializeJson(root, *response);
+              request->send(response);
+            })
+    .setFilter([&](__unused AsyncWebServerRequest* request) {
+      return EventHandler.getState() != Soylent::ESPConnect::State::PORTAL_STARTED;
+    });
+
+  // serve state of the time sync between thingys
+  _webServer->on("/timesync", HTTP_GET, [&](AsyncWebServerRequest* request) {
+              auto* response = request->beginResponseStream("application/json");
+              JsonDocument doc;
+              JsonObject root = doc.to<JsonObject>();
+
+              char id[9];
+              snprintf(id, sizeof(id), "%08x", TimeSync.getNodeId());
+              root["node"] = id;
+              snprintf(id, sizeof(id), "%08x", TimeSync.getLeaderId());
+              root["leader"] = id;
+              root["synced"] = TimeSync.isSynced();
+              root["offset_ms"] = static_cast<int32_t>(TimeSync.getOffset() / 1000);
+              root["delay_us"] = TimeSync.getDelay();
+              root["drift_ppm"] = TimeSync.getDrift();
+              serializeJson(root, *response);
+              request->send(response);
+            })
+    .setFilter([&](__unused AsyncWebServerRequest* request) {
+      return EventHandler.getState() != Soylent::ESPConnect::State::PORTAL_STARTED;
+    });
+
   // serve the logo (for main page)
   _webServer->on("/thingy_logo", HTTP_GET, [](AsyncWebServerRequest* request) {
               LOGD(TAG, "Serve thingy logo...");
-              auto* response = request->beginResponse(200,
-                                                      "image/svg+xml",
-                                                      logo_thingy_start,
-                                                      logo_thingy_end - logo_thingy_start);
-              response->addHeader("Content-Encoding", "gzip");
-              response->addHeader("Cache-Control", "public, max-age=900");
-              request->send(response);
+              if (!Soylent::AssetBundle::send(request, "/thingy_logo", "public, max-age=900")) {
+                request->send(404);
+              }
             })
     .setFilter([&](__unused AsyncWebServerRequest* request) {
       return EventHandler.getState() != Soylent::ESPConnect::State::PORTAL_STARTED;
@@ -206,13 +791,9 @@ void Soylent::WebSiteClass::_webSiteCallback() {
   // serve the favicon.svg
   _webServer->on("/favicon.svg", HTTP_GET, [](AsyncWebServerRequest* request) {
               LOGD(TAG, "Serve favicon.svg...");
-              auto* response = request->beginResponse(200,
-                                                      "image/svg+xml",
-                                                      favicon_svg_start,
-                                                      favicon_svg_end - favicon_svg_start);
-              response->addHeader("Content-Encoding", "gzip");
-              response->addHeader("Cache-Control", "public, max-age=900");
-              request->send(response);
+              if (!Soylent::AssetBundle::send(request, "/favicon.svg", "public, max-age=900")) {
+                request->send(404);
+              }
             })
     .setFilter([&](__unused AsyncWebServerRequest* request) {
       return EventHandler.getState() != Soylent::ESPConnect::State::PORTAL_STARTED;
@@ -221,13 +802,9 @@ void Soylent::WebSiteClass::_webSiteCallback() {
   // serve the apple-touch-icon
   _webServer->on("/apple-touch-icon.png", HTTP_GET, [](AsyncWebServerRequest* request) {
               LOGD(TAG, "Serve apple-touch-icon.png...");
-              auto* response = request->beginResponse(200,
-                                                      "image/png",
-                                                      touchicon_start,
-                                                      touchicon_end - touchicon_start);
-              response->addHeader("Content-Encoding", "gzip");
-              response->addHeader("Cache-Control", "public, max-age=900");
-              request->send(response);
+              if (!Soylent::AssetBundle::send(request, "/apple-touch-icon.png", "public, max-age=900")) {
+                request->send(404);
+              }
             })
     .setFilter([&](__unused AsyncWebServerRequest* request) {
       return EventHandler.getState() != Soylent::ESPConnect::State::PORTAL_STARTED;
@@ -236,13 +813,9 @@ void Soylent::WebSiteClass::_webSiteCallback() {
   // serve the favicon.png
   _webServer->on("/favicon-96x96.png", HTTP_GET, [](AsyncWebServerRequest* request) {
               LOGD(TAG, "Serve favicon-96x96.png...");
-              auto* response = request->beginResponse(200,
-                                                      "image/png",
-                                                      favicon_96_png_start,
-                                                      favicon_96_png_end - favicon_96_png_start);
-              response->addHeader("Content-Encoding", "gzip");
-              response->addHeader("Cache-Control", "public, max-age=900");
-              request->send(response);
+              if (!Soylent::AssetBundle::send(request, "/favicon-96x96.png", "public, max-age=900")) {
+                request->send(404);
+              }
             })
     .setFilter([&](__unused AsyncWebServerRequest* request) {
       return EventHandler.getState() != Soylent::ESPConnect::State::PORTAL_STARTED;
@@ -251,13 +824,9 @@ void Soylent::WebSiteClass::_webSiteCallback() {
   // serve the favicon.png
   _webServer->on("/favicon.ico", HTTP_GET, [](AsyncWebServerRequest* request) {
               LOGD(TAG, "Serve favicon.ico...");
-              auto* response = request->beginResponse(200,
-                                                      "image/x-icon",
-                                                      favicon_ico_start,
-                                                      favicon_ico_end - favicon_ico_start);
-              response->addHeader("Content-Encoding", "gzip");
-              response->addHeader("Cache-Control", "public, max-age=900");
-              request->send(response);
+              if (!Soylent::AssetBundle::send(request, "/favicon.ico", "public, max-age=900")) {
+                request->send(404);
+              }
             })
     .setFilter([&](__unused AsyncWebServerRequest* request) {
       return EventHandler.getState() != Soylent::ESPConnect::State::PORTAL_STARTED;
@@ -286,16 +855,15 @@ void Soylent::WebSiteClass::_webSiteCallback() {
   // serve our home page here, yet only when the ESPConnect portal is not shown
   _webServer->on("/", HTTP_GET, [&](AsyncWebServerRequest* request) {
               LOGD(TAG, "Serve...");
-              auto* response = request->beginResponse(200,
-                                                      "text/html",
-                                                      thingy_html_start,
-                                                      thingy_html_end - thingy_html_start);
-              response->addHeader("Content-Encoding", "gzip");
-              request->send(response);
+              // (revalidated by its ETag, so an updated bundle shows up right away)
+              if (!Soylent::AssetBundle::send(request, "/", "no-cache")) {
+                request->send(503, "text/html", Soylent::AssetBundle::hasPartition() ? NO_ASSETS_PAGE : NO_ASSETS_PARTITION_PAGE);
+              }
             })
     .setFilter([&](__unused AsyncWebServerRequest* request) {
       return EventHandler.getState() != Soylent::ESPConnect::State::PORTAL_STARTED;
     });
 
+  _routesRegistered = true;
   LOGD(TAG, "...done!");
 }
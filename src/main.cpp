@@ -2,7 +2,6 @@
 /*
  * Copyright (C) 2025 Robert Wendlandt
  */
-#include <SystemInfo.h>
 #include <TaskScheduler.h>
 #include <thingy.h>
 
@@ -15,6 +14,11 @@ Soylent::EventHandlerClass EventHandler(ESPNetwork);
 Soylent::WebServerClass WebServer(webServer);
 Soylent::WebSiteClass WebSite(webServer);
 Soylent::LedClass Led;
+Soylent::LedStreamClass LedStream;
+Soylent::TimeSyncClass TimeSync;
+Soylent::PowerClass Power;
+Soylent::TelemetryClass Telemetry;
+Soylent::ConfigClass Config;
 
 // Spinlock for critical sections
 portMUX_TYPE cs_spinlock = portMUX_INITIALIZER_UNLOCKED;
@@ -34,48 +38,42 @@ void setup() {
 #endif
 
   // Get reason for restart
-  LOGI(APP_NAME, "Reset reason: %s", SystemInfo.getResetReasonString().c_str());
+  LOGI(APP_NAME, "Reset reason: %s", Soylent::SystemInfo::getResetReason().description);
 
-  // Open preferences and check/assign safeboot content
-  // Will be overwritten, whenever the __COMPILED_BUILD_TIMESTAMP__ changes
-  extern const char* __COMPILED_BUILD_BOARD__;
-  extern char* __COMPILED_BUILD_TIMESTAMP__;
-  extern const uint8_t logo_safeboot_start[] asm("_binary__pio_assets_logo_safeboot_svg_gz_start");
-  extern const uint8_t logo_safeboot_end[] asm("_binary__pio_assets_logo_safeboot_svg_gz_end");
-  Preferences preferences;
-  preferences.begin("safeboot", false);
-  // TODO(soylentOrange): optimize logic to not always rewrite...
-  if (preferences.getString("build") != static_cast<String>(__COMPILED_BUILD_TIMESTAMP__)) {
-    preferences.putString("build", __COMPILED_BUILD_TIMESTAMP__);
-  }
+  // Map the web assets (see AssetBundle.h)
+  Soylent::AssetBundle::begin();
 
-  if (preferences.getString("app_name") != static_cast<String>(APP_NAME)) {
-    preferences.putString("app_name", APP_NAME);
-  }
-
-  if (preferences.getString("ssid") != static_cast<String>(CAPTIVE_PORTAL_SSID)) {
-    preferences.putString("ssid", CAPTIVE_PORTAL_SSID);
-  }
-
-  if (preferences.getString("pass") != static_cast<String>(CAPTIVE_PORTAL_PASSWORD)) {
-    preferences.putString("pass", CAPTIVE_PORTAL_PASSWORD);
-  }
-
-  if (preferences.getString("board") != static_cast<String>(__COMPILED_BUILD_BOARD__)) {
-    preferences.putString("board", __COMPILED_BUILD_BOARD__);
-  }
-
-  if (preferences.getULong("logo_crc") != crcx::crc32(logo_safeboot_start, logo_safeboot_end - logo_safeboot_start)) {
-    preferences.putULong("logo_len", logo_safeboot_end - logo_safeboot_start);
-    preferences.putULong("logo_crc", crcx::crc32(logo_safeboot_start, logo_safeboot_end - logo_safeboot_start));
-    preferences.putBytes("logo", logo_safeboot_start, logo_safeboot_end - logo_safeboot_start);
+  // Check/assign safeboot content
+  // Will be overwritten, whenever the __COMPILED_BUILD_TIMESTAMP__ changes (only written when changed)
+  extern const char* __COMPILED_BUILD_BOARD__;
+  extern const char* __COMPILED_BUILD_TIMESTAMP__;
+  Config.putString("safeboot", "build", __COMPILED_BUILD_TIMESTAMP__);
+  Config.putString("safeboot", "app_name", APP_NAME);
+  Config.putString("safeboot", "ssid", CAPTIVE_PORTAL_SSID);
+  Config.putString("safeboot", "pass", CAPTIVE_PORTAL_PASSWORD);
+  Config.putString("safeboot", "board", __COMPILED_BUILD_BOARD__);
+
+  // (the bundle knows the crc of the logo already)
+  const Soylent::AssetBundle::Entry* logo = Soylent::AssetBundle::find("/safeboot_logo");
+  if (logo != nullptr && Config.getULong("safeboot", "logo_crc") != logo->crc) {
+    Config.putULong("safeboot", "logo_len", logo->length);
+    Config.putULong("safeboot", "logo_crc", logo->crc);
+    Config.putBytes("safeboot", "logo", Soylent::AssetBundle::getData(*logo), logo->length);
   }
-
-  preferences.end();
+  // (right away, SafeBoot might be started any time, e.g. by a reset within the flush delay)
+  Config.flush("safeboot");
 
   // Initialize the Scheduler
   scheduler.init();
 
+  // Write settings to NVS once it got quiet
+  Config.begin(&scheduler);
+
+#ifdef CONFIG_THINGY_PIXEL_KERNELS_CHECK
+  // Compare the pixel kernels (and see how fast they are)
+  Soylent::PixelKernels::check();
+#endif
+
 // Mount the FS, yet only required when a RGB-LED is available
 #ifdef RGB_BUILTIN
   if (!LittleFS.begin(false)) {
@@ -95,8 +93,15 @@ void setup() {
   // Add EventHandler to Scheduler
   // Will also spawn the WebServer and WebSite (when ESPConnect says so...)
   EventHandler.begin(&scheduler);
+
+  // Sample stacks and heap
+  Telemetry.begin(&scheduler);
+
+  // Sleep whenever there is nothing to do
+  Power.begin(&scheduler);
 }
 
 void loop() {
-  scheduler.execute();
+  // block until the next task is due (or something else comes up)
+  Power.idle(scheduler.execute());
 }
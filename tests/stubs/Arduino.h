@@ -0,0 +1,95 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+/*
+ * Copyright (C) 2025 Robert Wendlandt
+ */
+#pragma once
+
+// What the modules under test use of the Arduino core and FreeRTOS, for the host
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+
+#ifndef __unused
+  #define __unused __attribute__((unused))
+#endif
+
+// the clock is up to the tests
+inline uint32_t hostMillis = 0;
+
+inline uint32_t millis() {
+  return hostMillis;
+}
+
+inline uint32_t micros() {
+  return hostMillis * 1000;
+}
+
+inline long random(long low, long high) {
+  return low + std::rand() % (high - low);
+}
+
+// a single thread, there's nothing to lock
+typedef int portMUX_TYPE;
+#define portMUX_INITIALIZER_UNLOCKED 0
+#define taskENTER_CRITICAL(lock)     (void)(lock)
+#define taskEXIT_CRITICAL(lock)      (void)(lock)
+
+class String {
+  public:
+    String() {}
+    String(const char* string) : _string(string != nullptr ? string : "") {}
+    const char* c_str() const {
+      return _string.c_str();
+    }
+    size_t length() const {
+      return _string.size();
+    }
+
+  private:
+    std::string _string;
+};
+
+// (as a plain number, like lwIP keeps it)
+class IPAddress {
+  public:
+    IPAddress(uint32_t address = 0) : _address(address) {}
+    operator uint32_t() const {
+      return _address;
+    }
+
+  private:
+    uint32_t _address;
+};
+
+#define portNUM_PROCESSORS 2
+
+inline uint32_t getCpuFrequencyMhz() {
+  return 240;
+}
+
+// the chip of the host (see esp_chip_info.h for the rest of it)
+class EspClass {
+  public:
+    uint32_t getFreeHeap() {
+      return 200 * 1024;
+    }
+    uint64_t getEfuseMac() {
+      return 0x123456789abcull;
+    }
+    const char* getChipModel() {
+      return "ESP32-S3";
+    }
+    uint32_t getFlashChipSize() {
+      return 8 * 1024 * 1024;
+    }
+    uint32_t getFlashChipSpeed() {
+      return 80000000;
+    }
+    uint32_t getPsramSize() {
+      return 0;
+    }
+};
+
+inline EspClass ESP;
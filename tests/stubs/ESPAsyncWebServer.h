@@ -0,0 +1,296 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+/*
+ * Copyright (C) 2025 Robert Wendlandt
+ */
+#pragma once
+
+// A request just keeps the responses it was given, so a test can look at what would have been sent
+// (and the server what was registered)
+#include <Arduino.h>
+#include <FS.h>
+#include <functional>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+typedef std::function<size_t(uint8_t* buffer, size_t maxLen, size_t index)> AwsResponseFiller;
+
+typedef enum {
+  HTTP_GET = 0b00000001,
+  HTTP_POST = 0b00000010,
+  HTTP_DELETE = 0b00000100,
+  HTTP_PUT = 0b00001000
+} WebRequestMethod;
+
+class AsyncClient {
+  public:
+    IPAddress remoteIP() const {
+      return IPAddress(0x0100a8c0);
+    }
+};
+
+class AsyncWebHeader {
+  public:
+    explicit AsyncWebHeader(const char* value) : _value(value) {}
+    const String& value() const {
+      return _value;
+    }
+
+  private:
+    String _value;
+};
+
+class AsyncWebServerResponse {
+  public:
+    int code = 0;
+    std::string contentType;
+    std::map<std::string, std::string> headers;
+
+    void addHeader(const char* name, const char* value, __attribute__((unused)) bool replace = true) {
+      headers[name] = value;
+    }
+
+    // the body, as it would be sent (in chunks as small as the TCP buffers might be)
+    std::string body() {
+      if (!filler) {
+        return content;
+      }
+      std::string body;
+      uint8_t chunk[536];
+      while (body.size() < length) {
+        size_t len = filler(chunk, std::min(sizeof(chunk), length - body.size()), body.size());
+        if (len == 0) {
+          break;
+        }
+        body.append(reinterpret_cast<const char*>(chunk), len);
+      }
+      return body;
+    }
+
+    std::string content;
+    size_t length = 0;
+    AwsResponseFiller filler;
+    // sent from the file system
+    bool streamed = false;
+};
+
+class AsyncResponseStream : public AsyncWebServerResponse {
+  public:
+    size_t print(const char* chunk) {
+      content += chunk;
+      length = content.size();
+      return strlen(chunk);
+    }
+};
+
+class AsyncWebServerRequest {
+  public:
+    void addHeader(const char* name, const char* value) {
+      _headers.emplace(name, AsyncWebHeader(value));
+    }
+    const AsyncWebHeader* getHeader(const char* name) const {
+      auto header = _headers.find(name);
+      return header != _headers.end() ? &header->second : nullptr;
+    }
+
+    AsyncWebServerResponse* beginResponse(int code, const char* contentType = "", const char* content = "") {
+      return beginResponse(code, contentType, reinterpret_cast<const uint8_t*>(content), strlen(content));
+    }
+    AsyncWebServerResponse* beginResponse(int code, const char* contentType, const uint8_t* content, size_t len) {
+      AsyncWebServerResponse* response = _begin(code, contentType);
+      response->content.assign(reinterpret_cast<const char*>(content), len);
+      response->length = len;
+      return response;
+    }
+    AsyncWebServerResponse* beginResponse(const char* contentType, size_t len, AwsResponseFiller filler) {
+      AsyncWebServerResponse* response = _begin(200, contentType);
+      response->length = len;
+      response->filler = filler;
+      return response;
+    }
+    AsyncResponseStream* beginResponseStream(const char* contentType) {
+      _responses.emplace_back(new AsyncResponseStream());
+      _responses.back()->code = 200;
+      _responses.back()->contentType = contentType;
+      return static_cast<AsyncResponseStream*>(_responses.back().get());
+    }
+    void send(AsyncWebServerResponse* response) {
+      _sent = response;
+    }
+    void send(int code, const char* contentType = "", const char* content = "") {
+      send(beginResponse(code, contentType, content));
+    }
+    void send(int code, const char* contentType, const uint8_t* content, size_t len) {
+      send(beginResponse(code, contentType, content, len));
+    }
+    // streamed from the file system (404 if it's not there)
+    void send(fs::FS& fs, const String& path, const char* contentType = "", __attribute__((unused)) bool download = false) {
+      fs::File file = fs.open(path.c_str(), "r");
+      if (!file || file.isDirectory()) {
+        send(404);
+        return;
+      }
+      std::string content(file.size(), '\0');
+      file.read(reinterpret_cast<uint8_t*>(&content[0]), content.size());
+      AsyncWebServerResponse* response = beginResponse(200, contentType, reinterpret_cast<const uint8_t*>(content.data()), content.size());
+      response->streamed = true;
+      send(response);
+    }
+
+    // what was sent, nullptr if nothing
+    AsyncWebServerResponse* sent() {
+      return _sent;
+    }
+
+    WebRequestMethod method() const {
+      return _method;
+    }
+    void setMethod(WebRequestMethod method) {
+      _method = method;
+    }
+    String url() const {
+      return String("/");
+    }
+    AsyncClient* client() {
+      return &_client;
+    }
+    void setAttribute(const char* name, long value) {
+      _attributes[name] = value;
+    }
+    long getAttribute(const char* name, long defaultValue) const {
+      auto attribute = _attributes.find(name);
+      return attribute != _attributes.end() ? attribute->second : defaultValue;
+    }
+    void onDisconnect(std::function<void()> callback) {
+      _onDisconnect = callback;
+    }
+
+  private:
+    AsyncWebServerResponse* _begin(int code, const char* contentType) {
+      _responses.emplace_back(new AsyncWebServerResponse());
+      _responses.back()->code = code;
+      _responses.back()->contentType = contentType;
+      return _responses.back().get();
+    }
+
+    WebRequestMethod _method = HTTP_GET;
+    AsyncClient _client;
+    std::map<std::string, long> _attributes;
+    std::function<void()> _onDisconnect;
+    std::map<std::string, AsyncWebHeader> _headers;
+    std::vector<std::unique_ptr<AsyncWebServerResponse>> _responses;
+    AsyncWebServerResponse* _sent = nullptr;
+};
+
+class AsyncWebSocketClient {
+  public:
+    IPAddress remoteIP() const {
+      return IPAddress(0x0200a8c0);
+    }
+};
+
+typedef std::function<void(AsyncWebServerRequest* request)> ArRequestHandlerFunction;
+typedef std::function<bool(AsyncWebServerRequest* request)> ArRequestFilterFunction;
+typedef std::function<void(void)> ArMiddlewareNext;
+typedef std::function<void(AsyncWebServerRequest* request, ArMiddlewareNext next)> ArMiddlewareCallback;
+
+// Counts its instances, so a test can tell whether handlers are allocated anew
+class AsyncWebHandler {
+  public:
+    inline static int instances = 0;
+
+    AsyncWebHandler() {
+      instances++;
+    }
+    virtual ~AsyncWebHandler() {
+      instances--;
+    }
+    virtual bool canHandle(__attribute__((unused)) AsyncWebServerRequest* request) const {
+      return false;
+    }
+    AsyncWebHandler& setFilter(ArRequestFilterFunction filter) {
+      _filter = filter;
+      return *this;
+    }
+
+  private:
+    ArRequestFilterFunction _filter;
+};
+
+class AsyncCallbackWebHandler : public AsyncWebHandler {
+  public:
+    AsyncCallbackWebHandler(const char* uri, WebRequestMethod method, ArRequestHandlerFunction onRequest) : uri(uri), method(method), onRequest(onRequest) {}
+
+    std::string uri;
+    WebRequestMethod method;
+    ArRequestHandlerFunction onRequest;
+};
+
+// Keeps what's registered (and owns the handlers, like the real one), it never listens
+class AsyncWebServer {
+  public:
+    AsyncCallbackWebHandler& on(const char* uri, WebRequestMethod method, ArRequestHandlerFunction onRequest) {
+      auto* handler = new AsyncCallbackWebHandler(uri, method, onRequest);
+      addHandler(handler);
+      return *handler;
+    }
+    AsyncWebHandler& addHandler(AsyncWebHandler* handler) {
+      _handlers.emplace_back(handler);
+      return *handler;
+    }
+    bool removeHandler(AsyncWebHandler* handler) {
+      for (auto it = _handlers.begin(); it != _handlers.end(); ++it) {
+        if (it->get() == handler) {
+          _handlers.erase(it);
+          return true;
+        }
+      }
+      return false;
+    }
+    void addMiddleware(ArMiddlewareCallback middleware) {
+      _middlewares.push_back(middleware);
+    }
+    void onNotFound(ArRequestHandlerFunction onNotFound) {
+      _onNotFound = onNotFound;
+      notFoundRegistrations++;
+    }
+    void begin() {
+      listening = true;
+      begins++;
+    }
+    void end() {
+      listening = false;
+    }
+    // drops the handlers and the 404-handler (not the middlewares)
+    void reset() {
+      _handlers.clear();
+      _onNotFound = nullptr;
+    }
+
+    size_t getHandlerCount() const {
+      return _handlers.size();
+    }
+    size_t getMiddlewareCount() const {
+      return _middlewares.size();
+    }
+    // the handler of a route, nullptr if there is none
+    const AsyncCallbackWebHandler* getRoute(const char* uri, WebRequestMethod method) const {
+      for (const auto& handler : _handlers) {
+        auto* route = dynamic_cast<const AsyncCallbackWebHandler*>(handler.get());
+        if (route != nullptr && route->uri == uri && route->method == method) {
+          return route;
+        }
+      }
+      return nullptr;
+    }
+
+    bool listening = false;
+    int begins = 0;
+    int notFoundRegistrations = 0;
+
+  private:
+    std::vector<std::unique_ptr<AsyncWebHandler>> _handlers;
+    std::vector<ArMiddlewareCallback> _middlewares;
+    ArRequestHandlerFunction _onNotFound;
+};
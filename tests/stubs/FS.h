@@ -0,0 +1,78 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+/*
+ * Copyright (C) 2025 Robert Wendlandt
+ */
+#pragma once
+
+// A file system in RAM, the files are whatever a test puts into it
+#include <Arduino.h>
+#include <map>
+#include <memory>
+#include <string>
+
+namespace fs {
+  class File {
+    public:
+      File() {}
+      File(std::shared_ptr<const std::string> content, bool directory) : _content(content), _directory(directory) {}
+      explicit operator bool() const {
+        return _content != nullptr;
+      }
+      bool isDirectory() {
+        return _directory;
+      }
+      size_t size() {
+        return _content->size();
+      }
+      size_t read(uint8_t* buffer, size_t len) {
+        len = std::min(len, _content->size() - _position);
+        memcpy(buffer, _content->data() + _position, len);
+        _position += len;
+        return len;
+      }
+      void close() {
+        _content.reset();
+      }
+
+    private:
+      std::shared_ptr<const std::string> _content;
+      bool _directory = false;
+      size_t _position = 0;
+  };
+
+  class FS {
+    public:
+      void write(const std::string& path, const std::string& content) {
+        _files[path] = std::make_shared<const std::string>(content);
+      }
+      void remove(const std::string& path) {
+        _files.erase(path);
+      }
+      bool exists(const char* path) {
+        return _files.count(path) > 0 || _isDirectory(path);
+      }
+      File open(const char* path, __attribute__((unused)) const char* mode = "r") {
+        opens++;
+        auto file = _files.find(path);
+        if (file != _files.end()) {
+          return File(file->second, false);
+        }
+        return _isDirectory(path) ? File(std::make_shared<const std::string>(), true) : File();
+      }
+
+      // files opened so far
+      uint32_t opens = 0;
+
+    private:
+      bool _isDirectory(const std::string& path) {
+        auto file = _files.lower_bound(path + "/");
+        return file != _files.end() && file->first.compare(0, path.size() + 1, path + "/") == 0;
+      }
+
+      std::map<std::string, std::shared_ptr<const std::string>> _files;
+  };
+} // namespace fs
+
+// (as FS.h of the core does)
+using fs::File;
+using fs::FS;
@@ -0,0 +1,57 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+/*
+ * Copyright (C) 2025 Robert Wendlandt
+ */
+#pragma once
+
+// The pixel types and the lib8tion math the kernels are measured against (as FastLED 3.x does them by default)
+#include <cstdint>
+
+struct CRGB {
+    union {
+        struct {
+            union {
+                uint8_t r;
+                uint8_t red;
+            };
+            union {
+                uint8_t g;
+                uint8_t green;
+            };
+            union {
+                uint8_t b;
+                uint8_t blue;
+            };
+        };
+        uint8_t raw[3];
+    };
+
+    CRGB() : r(0), g(0), b(0) {}
+    CRGB(uint8_t red, uint8_t green, uint8_t blue) : r(red), g(green), b(blue) {}
+};
+
+inline bool operator==(const CRGB& a, const CRGB& b) {
+  return a.r == b.r && a.g == b.g && a.b == b.b;
+}
+
+struct CHSV {
+    uint8_t h;
+    uint8_t s;
+    uint8_t v;
+};
+
+// FASTLED_SCALE8_FIXED
+inline uint8_t scale8(uint8_t i, uint8_t scale) {
+  return (static_cast<uint16_t>(i) * (1 + static_cast<uint16_t>(scale))) >> 8;
+}
+
+// FASTLED_BLEND_FIXED
+inline uint8_t blend8(uint8_t a, uint8_t b, uint8_t amountOfB) {
+  uint16_t partial = (a << 8) | b;
+  partial += b * amountOfB;
+  partial -= a * amountOfB;
+  return partial >> 8;
+}
+
+// (not measured, the kernels just pass it on)
+void hsv2rgb_rainbow(const CHSV* hsv, CRGB* rgb, int count);
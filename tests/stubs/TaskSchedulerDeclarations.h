@@ -0,0 +1,121 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+/*
+ * Copyright (C) 2025 Robert Wendlandt
+ */
+#pragma once
+
+// Tasks are never run by themselves on the host, a test runs them when it likes to (see run() and Scheduler::execute())
+#include <algorithm>
+#include <functional>
+#include <vector>
+
+#define TASK_MILLISECOND 1
+#define TASK_IMMEDIATE   0
+#define TASK_ONCE        1
+#define TASK_FOREVER     (-1)
+
+class Task;
+
+class Scheduler {
+  public:
+    ~Scheduler();
+    // a pass of the scheduler: every task enabled runs once (and a self-destructing one is gone after)
+    void execute();
+    size_t getTaskCount() const {
+      return _tasks.size();
+    }
+
+  private:
+    friend class Task;
+    std::vector<Task*> _tasks;
+};
+
+class StatusRequest {
+  public:
+    void setWaiting(unsigned int count = 1) {
+      _count = count;
+    }
+    bool signalComplete(int status = 0) {
+      (void)status;
+      if (_count > 0) {
+        _count--;
+      }
+      return _count == 0;
+    }
+    bool pending() {
+      return _count > 0;
+    }
+    bool completed() {
+      return _count == 0;
+    }
+
+  private:
+    unsigned int _count = 0;
+};
+
+class Task {
+  public:
+    Task(unsigned long interval, long iterations, std::function<void()> callback, Scheduler* scheduler, bool enable = false, void* onEnable = nullptr,
+         void* onDisable = nullptr, bool selfdestruct = false)
+        : _callback(callback), _interval(interval), _enabled(enable), _scheduler(scheduler), _selfdestruct(selfdestruct) {
+      (void)iterations, (void)onEnable, (void)onDisable;
+      if (_scheduler != nullptr) {
+        _scheduler->_tasks.push_back(this);
+      }
+    }
+    ~Task() {
+      if (_scheduler != nullptr) {
+        _scheduler->_tasks.erase(std::remove(_scheduler->_tasks.begin(), _scheduler->_tasks.end(), this), _scheduler->_tasks.end());
+      }
+    }
+    void enable() {
+      _enabled = true;
+    }
+    void disable() {
+      _enabled = false;
+    }
+    void restartDelayed(unsigned long delay) {
+      _delay = delay;
+      _enabled = true;
+    }
+    bool isEnabled() {
+      return _enabled;
+    }
+    unsigned long getDelay() {
+      return _delay;
+    }
+    // as if the scheduler got to it (once)
+    void run() {
+      _enabled = false;
+      _callback();
+    }
+
+  private:
+    friend class Scheduler;
+    std::function<void()> _callback;
+    unsigned long _interval;
+    unsigned long _delay = 0;
+    bool _enabled;
+    Scheduler* _scheduler;
+    bool _selfdestruct;
+};
+
+inline Scheduler::~Scheduler() {
+  for (Task* task : _tasks) {
+    task->_scheduler = nullptr;
+  }
+}
+
+inline void Scheduler::execute() {
+  std::vector<Task*> tasks = _tasks;
+  for (Task* task : tasks) {
+    // (a task run before might have deleted it)
+    if (std::find(_tasks.begin(), _tasks.end(), task) == _tasks.end() || !task->isEnabled()) {
+      continue;
+    }
+    task->run();
+    if (task->_selfdestruct) {
+      delete task;
+    }
+  }
+}
@@ -0,0 +1,30 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+/*
+ * Copyright (C) 2025 Robert Wendlandt
+ */
+#pragma once
+
+// What the app of the host says about itself
+#include <cstddef>
+#include <cstring>
+
+typedef struct {
+    char version[32];
+    char project_name[32];
+    char idf_ver[32];
+} esp_app_desc_t;
+
+inline esp_app_desc_t hostApp = {"test", "LEDThingy", "v5.4.2"};
+
+inline const esp_app_desc_t* esp_app_get_description() {
+  return &hostApp;
+}
+
+// (the hex digits of the SHA-256 of the ELF file, as many as fit)
+inline int esp_app_get_elf_sha256(char* dst, size_t size) {
+  static const char sha256[] = "0123456789abcdef0123456789abcdef0123456789abcdef0123456789abcdef";
+  size_t length = size - 1 < sizeof(sha256) - 1 ? size - 1 : sizeof(sha256) - 1;
+  memcpy(dst, sha256, length);
+  dst[length] = '\0';
+  return length;
+}
@@ -0,0 +1,28 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+/*
+ * Copyright (C) 2025 Robert Wendlandt
+ */
+#pragma once
+
+// The chip of the host is whatever a test puts into hostChip
+#include <cstdint>
+
+#define CHIP_FEATURE_EMB_FLASH  (1 << 0)
+#define CHIP_FEATURE_WIFI_BGN   (1 << 1)
+#define CHIP_FEATURE_BLE        (1 << 4)
+#define CHIP_FEATURE_BT         (1 << 5)
+#define CHIP_FEATURE_IEEE802154 (1 << 6)
+#define CHIP_FEATURE_EMB_PSRAM  (1 << 7)
+
+typedef struct {
+    int model;
+    uint32_t features;
+    uint16_t revision;
+    uint8_t cores;
+} esp_chip_info_t;
+
+inline esp_chip_info_t hostChip = {1, CHIP_FEATURE_WIFI_BGN | CHIP_FEATURE_BLE, 301, 2};
+
+inline void esp_chip_info(esp_chip_info_t* chip) {
+  *chip = hostChip;
+}
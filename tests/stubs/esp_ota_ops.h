@@ -0,0 +1,19 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+/*
+ * Copyright (C) 2025 Robert Wendlandt
+ */
+#pragma once
+
+// The host is running from whichever of hostPartitions a test puts into hostRunningPartition
+#include <esp_app_desc.h>
+#include <esp_partition.h>
+
+inline const esp_partition_t* hostRunningPartition = nullptr;
+
+inline const esp_partition_t* esp_ota_get_running_partition() {
+  return hostRunningPartition;
+}
+
+inline esp_err_t esp_ota_set_boot_partition(__attribute__((unused)) const esp_partition_t* partition) {
+  return ESP_OK;
+}
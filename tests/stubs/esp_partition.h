@@ -0,0 +1,103 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+/*
+ * Copyright (C) 2025 Robert Wendlandt
+ */
+#pragma once
+
+// The partitions of the host are whatever a test puts into hostPartitions, "mapped" right from there
+#include <cstdint>
+#include <cstring>
+#include <deque>
+#include <vector>
+
+typedef int esp_err_t;
+#define ESP_OK   0
+#define ESP_FAIL -1
+
+typedef enum {
+  ESP_PARTITION_TYPE_APP = 0x00,
+  ESP_PARTITION_TYPE_DATA = 0x01,
+  ESP_PARTITION_TYPE_ANY = 0xff
+} esp_partition_type_t;
+
+typedef enum {
+  ESP_PARTITION_SUBTYPE_APP_FACTORY = 0x00,
+  ESP_PARTITION_SUBTYPE_DATA_SPIFFS = 0x82,
+  ESP_PARTITION_SUBTYPE_ANY = 0xff
+} esp_partition_subtype_t;
+
+typedef enum {
+  ESP_PARTITION_MMAP_DATA,
+  ESP_PARTITION_MMAP_INST
+} esp_partition_mmap_memory_t;
+
+typedef uint32_t esp_partition_mmap_handle_t;
+
+typedef struct {
+    esp_partition_type_t type;
+    esp_partition_subtype_t subtype;
+    uint32_t address;
+    uint32_t size;
+    char label[17];
+} esp_partition_t;
+
+struct HostPartition {
+    esp_partition_t partition;
+    std::vector<uint8_t> content;
+};
+
+inline std::deque<HostPartition> hostPartitions;
+
+inline const esp_partition_t* esp_partition_find_first(esp_partition_type_t type, esp_partition_subtype_t subtype, const char* label) {
+  for (const HostPartition& host : hostPartitions) {
+    if ((type == ESP_PARTITION_TYPE_ANY || host.partition.type == type) && (subtype == ESP_PARTITION_SUBTYPE_ANY || host.partition.subtype == subtype) &&
+        (label == nullptr || strcmp(host.partition.label, label) == 0)) {
+      return &host.partition;
+    }
+  }
+  return nullptr;
+}
+
+struct esp_partition_iterator_opaque_ {
+    esp_partition_type_t type;
+    esp_partition_subtype_t subtype;
+    const char* label;
+    size_t index;
+};
+typedef esp_partition_iterator_opaque_* esp_partition_iterator_t;
+
+// (like ESP-IDF, the iterator is released once it's past the last partition)
+inline esp_partition_iterator_t esp_partition_next(esp_partition_iterator_t it) {
+  for (it->index++; it->index < hostPartitions.size(); it->index++) {
+    const esp_partition_t& partition = hostPartitions[it->index].partition;
+    if ((it->type == ESP_PARTITION_TYPE_ANY || partition.type == it->type) && (it->subtype == ESP_PARTITION_SUBTYPE_ANY || partition.subtype == it->subtype) &&
+        (it->label == nullptr || strcmp(partition.label, it->label) == 0)) {
+      return it;
+    }
+  }
+  delete it;
+  return nullptr;
+}
+
+inline esp_partition_iterator_t esp_partition_find(esp_partition_type_t type, esp_partition_subtype_t subtype, const char* label) {
+  // (starting right before the first one)
+  return esp_partition_next(new esp_partition_iterator_opaque_{type, subtype, label, static_cast<size_t>(-1)});
+}
+
+inline const esp_partition_t* esp_partition_get(esp_partition_iterator_t it) {
+  return &hostPartitions[it->index].partition;
+}
+
+inline esp_err_t esp_partition_mmap(const esp_partition_t* partition, size_t offset, size_t size, __attribute__((unused)) esp_partition_mmap_memory_t memory,
+                                    const void** out, esp_partition_mmap_handle_t* handle) {
+  for (const HostPartition& host : hostPartitions) {
+    if (&host.partition == partition && offset + size <= host.content.size()) {
+      *out = host.content.data() + offset;
+      *handle = 0;
+      return ESP_OK;
+    }
+  }
+  return ESP_FAIL;
+}
+
+inline void esp_partition_munmap(__attribute__((unused)) esp_partition_mmap_handle_t handle) {}
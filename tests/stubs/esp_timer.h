@@ -0,0 +1,12 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+/*
+ * Copyright (C) 2025 Robert Wendlandt
+ */
+#pragma once
+
+// Time since start-up (in us), on the clock of the tests
+#include <Arduino.h>
+
+inline int64_t esp_timer_get_time() {
+  return static_cast<int64_t>(hostMillis) * 1000;
+}
@@ -0,0 +1,146 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+/*
+ * Copyright (C) 2025 Robert Wendlandt
+ */
+#pragma once
+
+// Stands in for include/thingy.h: just the modules built for the host (see platformio.ini)
+#include <Arduino.h>
+#include <CRCx.h>
+#include <ESPAsyncWebServer.h>
+#include <string>
+
+#include <ArduinoJson.h>
+#include <AssetBundle.h>
+#include <ConfigTask.h>
+#include <FileCache.h>
+#include <LedResume.h>
+#include <SystemInfo.h>
+#include <Trace.h>
+#include <WebServerTask.h>
+
+// Stand-ins for the modules the web server reaches into (only from its routes, which the tests don't request)
+#define CONFIG_THINGY_IDLE_SLEEP         1
+#define CONFIG_THINGY_CPU_BOOST_REQUESTS 2
+#define CONFIG_THINGY_TELEMETRY_INTERVAL 10000
+
+namespace Soylent {
+  class ESPConnect {
+    public:
+      enum class State {
+        NETWORK_CONNECTED,
+        PORTAL_STARTED
+      };
+  };
+
+  class EventHandlerClass {
+    public:
+      ESPConnect::State getState() {
+        return state;
+      }
+      uint32_t getConnectedAt() {
+        return 0;
+      }
+
+      ESPConnect::State state = ESPConnect::State::NETWORK_CONNECTED;
+  };
+
+  class ESPNetworkClass {
+    public:
+      void clearConfiguration() {}
+  };
+
+  class ESPRestartClass {
+    public:
+      void restartDelayed(uint32_t, uint32_t) {}
+  };
+
+  class LedClass {
+    public:
+      enum class LedState {
+        OFF = 0
+      };
+
+      LedResume::Source getResumedFrom() {
+        return LedResume::Source::NONE;
+      }
+      LedState getLedState() {
+        return LedState::OFF;
+      }
+      uint32_t getInitializedAt() {
+        return 0;
+      }
+      uint32_t getFirstShownAt() {
+        return 0;
+      }
+  };
+
+  class PowerClass {
+    public:
+      enum Demand : uint8_t {
+        DEMAND_LED = 0,
+        DEMAND_HTTP = 1
+      };
+
+      void wake() {}
+      void boost(Demand) {}
+      void release(Demand) {}
+      bool isLightSleepSupported() { return false; }
+      bool isLightSleepAllowed() { return false; }
+      uint32_t getSleeps() { return 0; }
+      uint32_t getEarlyWakeups() { return 0; }
+      uint64_t getSleepTime() { return 0; }
+      uint64_t getLightSleepTime() { return 0; }
+      bool isScaling() { return false; }
+      bool isBoosted() { return false; }
+      uint32_t getMinFrequency() { return 80; }
+      uint32_t getMaxFrequency() { return 240; }
+      uint32_t getBoosts() { return 0; }
+      uint16_t getDemand(Demand) { return 0; }
+      uint64_t getBoostedTime() { return 0; }
+      uint64_t getUnboostedTime() { return 0; }
+      int getIdlePercent(uint8_t) { return -1; }
+  };
+
+  class TelemetryClass {
+    public:
+      enum Stack : uint8_t {
+        STACK_LOOP = 0,
+        STACK_COUNT = 1
+      };
+
+      struct Sample {
+          uint32_t at;
+          uint32_t heapFree;
+          uint32_t heapMinFree;
+          uint32_t heapLargestBlock;
+          int32_t stackFree[STACK_COUNT];
+      };
+
+      static const char* getStackName(Stack) { return ""; }
+      static uint32_t getStackSize(Stack) { return 0; }
+      int32_t getStackMinFree(Stack) { return -1; }
+      bool getSample(uint16_t, Sample*) { return false; }
+  };
+} // namespace Soylent
+
+inline Soylent::EventHandlerClass EventHandler;
+inline Soylent::ESPNetworkClass ESPNetwork;
+inline Soylent::ESPRestartClass ESPRestart;
+inline Soylent::LedClass Led;
+inline Soylent::PowerClass Power;
+inline Soylent::TelemetryClass Telemetry;
+inline Soylent::ConfigClass Config;
+
+inline portMUX_TYPE cs_spinlock = portMUX_INITIALIZER_UNLOCKED;
+
+// made by tools/version.py for the firmware
+inline const char* __COMPILED_APP_VERSION__ = "1.2.3";
+inline const char* __COMPILED_BUILD_HASH__ = "abcdef0";
+inline const char* __COMPILED_BUILD_BOARD__ = "host";
+inline const char* __COMPILED_BUILD_TIMESTAMP__ = "2025-01-01 12:00:00";
+
+#define LOGD(tag, format, ...)
+#define LOGI(tag, format, ...)
+#define LOGW(tag, format, ...)
+#define LOGE(tag, format, ...)
@@ -0,0 +1,168 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+/*
+ * Copyright (C) 2025 Robert Wendlandt
+ */
+#include <thingy.h>
+#include <esp_partition.h>
+#include <string>
+#include <unity.h>
+#include <vector>
+
+// the bundle stays mapped once it's been found valid, so the broken ones go first
+
+struct Asset {
+    const char* path;
+    const char* type;
+    std::string blob;
+};
+
+// as tools/assets.py packs them (the assets have to be sorted by path)
+static std::vector<uint8_t> pack(const std::vector<Asset>& assets) {
+  std::vector<uint8_t> body(assets.size() * sizeof(Soylent::AssetBundle::Entry));
+  std::string data;
+  uint32_t offset = sizeof(Soylent::AssetBundle::Header) + body.size();
+  for (size_t i = 0; i < assets.size(); i++) {
+    data.append(-(offset + data.size()) % ASSET_BUNDLE_ALIGNMENT, '\0');
+    Soylent::AssetBundle::Entry entry = {};
+    entry.offset = offset + data.size();
+    entry.length = assets[i].blob.size();
+    entry.crc = crcx::crc32(reinterpret_cast<const uint8_t*>(assets[i].blob.data()), assets[i].blob.size());
+    entry.flags = ASSET_FLAG_GZIP;
+    strncpy(entry.path, assets[i].path, sizeof(entry.path) - 1);
+    strncpy(entry.type, assets[i].type, sizeof(entry.type) - 1);
+    memcpy(&body[i * sizeof(entry)], &entry, sizeof(entry));
+    data += assets[i].blob;
+  }
+  body.insert(body.end(), data.begin(), data.end());
+
+  Soylent::AssetBundle::Header header = {ASSET_BUNDLE_MAGIC, ASSET_BUNDLE_VERSION, static_cast<uint16_t>(assets.size()),
+                                         static_cast<uint32_t>(sizeof(header) + body.size()), crcx::crc32(body.data(), body.size())};
+  std::vector<uint8_t> bundle(reinterpret_cast<const uint8_t*>(&header), reinterpret_cast<const uint8_t*>(&header) + sizeof(header));
+  bundle.insert(bundle.end(), body.begin(), body.end());
+  return bundle;
+}
+
+static const std::vector<Asset> ASSETS = {
+  {"/", "text/html", "<html>"},
+  {"/favicon.ico", "image/x-icon", std::string(37, 'i')},
+  {"/favicon.svg", "image/svg+xml", "<svg/>"},
+  {"/logo", "image/svg+xml", std::string(1000, 'l')},
+  {"/thingy_logo", "image/svg+xml", "<svg>thingy</svg>"},
+};
+
+// into a partition of 128 kB, erased flash after the bundle
+static void flash(const std::vector<uint8_t>& bundle) {
+  hostPartitions.clear();
+  HostPartition assets = {{ESP_PARTITION_TYPE_DATA, static_cast<esp_partition_subtype_t>(0x40), 0x3C0000, 128 * 1024, CONFIG_THINGY_ASSETS_PARTITION}, bundle};
+  assets.content.resize(assets.partition.size, 0xFF);
+  hostPartitions.push_back(assets);
+}
+
+void setUp() {}
+
+void tearDown() {}
+
+void test_no_partition() {
+  hostPartitions.clear();
+  TEST_ASSERT_FALSE(Soylent::AssetBundle::begin());
+  TEST_ASSERT_FALSE(Soylent::AssetBundle::hasPartition());
+  TEST_ASSERT_FALSE(Soylent::AssetBundle::isAvailable());
+  TEST_ASSERT_NULL(Soylent::AssetBundle::find("/"));
+
+  AsyncWebServerRequest request;
+  TEST_ASSERT_FALSE(Soylent::AssetBundle::send(&request, "/"));
+  TEST_ASSERT_NULL(request.sent());
+}
+
+void test_erased_partition() {
+  flash({});
+  TEST_ASSERT_FALSE(Soylent::AssetBundle::begin());
+  TEST_ASSERT_TRUE(Soylent::AssetBundle::hasPartition());
+  TEST_ASSERT_FALSE(Soylent::AssetBundle::isAvailable());
+}
+
+void test_corrupted_bundle() {
+  std::vector<uint8_t> bundle = pack(ASSETS);
+  bundle[bundle.size() - 1] ^= 0x01;
+  flash(bundle);
+  TEST_ASSERT_FALSE(Soylent::AssetBundle::begin());
+}
+
+void test_unsorted_index() {
+  flash(pack({ASSETS[1], ASSETS[0]}));
+  TEST_ASSERT_FALSE(Soylent::AssetBundle::begin());
+}
+
+void test_too_large_for_the_partition() {
+  std::vector<uint8_t> bundle = pack({{"/", "text/html", std::string(128 * 1024, 'x')}});
+  bundle.resize(128 * 1024);
+  flash(bundle);
+  TEST_ASSERT_FALSE(Soylent::AssetBundle::begin());
+}
+
+void test_find() {
+  flash(pack(ASSETS));
+  TEST_ASSERT_TRUE(Soylent::AssetBundle::begin());
+  TEST_ASSERT_TRUE(Soylent::AssetBundle::isAvailable());
+  TEST_ASSERT_EQUAL(ASSETS.size(), Soylent::AssetBundle::getHeader()->count);
+
+  for (const Asset& asset : ASSETS) {
+    const Soylent::AssetBundle::Entry* entry = Soylent::AssetBundle::find(asset.path);
+    TEST_ASSERT_NOT_NULL(entry);
+    TEST_ASSERT_EQUAL_STRING(asset.path, entry->path);
+    TEST_ASSERT_EQUAL(0, entry->offset % ASSET_BUNDLE_ALIGNMENT);
+    TEST_ASSERT_EQUAL(asset.blob.size(), entry->length);
+    TEST_ASSERT_EQUAL_MEMORY(asset.blob.data(), Soylent::AssetBundle::getData(*entry), entry->length);
+  }
+  TEST_ASSERT_NULL(Soylent::AssetBundle::find(""));
+  TEST_ASSERT_NULL(Soylent::AssetBundle::find("/favicon"));
+  TEST_ASSERT_NULL(Soylent::AssetBundle::find("/zzz"));
+  TEST_ASSERT_NULL(Soylent::AssetBundle::find("/images/rainbow.svg"));
+}
+
+void test_send() {
+  AsyncWebServerRequest request;
+  TEST_ASSERT_TRUE(Soylent::AssetBundle::send(&request, "/logo", "public, max-age=900"));
+  AsyncWebServerResponse* response = request.sent();
+  TEST_ASSERT_NOT_NULL(response);
+  TEST_ASSERT_EQUAL(200, response->code);
+  TEST_ASSERT_EQUAL_STRING("image/svg+xml", response->contentType.c_str());
+  TEST_ASSERT_EQUAL_STRING("gzip", response->headers["Content-Encoding"].c_str());
+  TEST_ASSERT_EQUAL_STRING("public, max-age=900", response->headers["Cache-Control"].c_str());
+  TEST_ASSERT_TRUE(response->body() == ASSETS[3].blob);
+
+  char etag[11];
+  snprintf(etag, sizeof(etag), "\"%08x\"", crcx::crc32(reinterpret_cast<const uint8_t*>(ASSETS[3].blob.data()), ASSETS[3].blob.size()));
+  TEST_ASSERT_EQUAL_STRING(etag, response->headers["ETag"].c_str());
+}
+
+void test_send_not_modified() {
+  const Soylent::AssetBundle::Entry* entry = Soylent::AssetBundle::find("/favicon.svg");
+  char etag[11];
+  snprintf(etag, sizeof(etag), "\"%08x\"", entry->crc);
+
+  AsyncWebServerRequest request;
+  request.addHeader("If-None-Match", etag);
+  TEST_ASSERT_TRUE(Soylent::AssetBundle::send(&request, "/favicon.svg"));
+  TEST_ASSERT_EQUAL(304, request.sent()->code);
+  TEST_ASSERT_EQUAL_STRING(etag, request.sent()->headers["ETag"].c_str());
+  TEST_ASSERT_EQUAL(0, request.sent()->headers.count("Cache-Control"));
+
+  AsyncWebServerRequest outdated;
+  outdated.addHeader("If-None-Match", "\"00000000\"");
+  Soylent::AssetBundle::send(&outdated, "/favicon.svg");
+  TEST_ASSERT_EQUAL(200, outdated.sent()->code);
+}
+
+int main() {
+  UNITY_BEGIN();
+  RUN_TEST(test_no_partition);
+  RUN_TEST(test_erased_partition);
+  RUN_TEST(test_corrupted_bundle);
+  RUN_TEST(test_unsorted_index);
+  RUN_TEST(test_too_large_for_the_partition);
+  RUN_TEST(test_find);
+  RUN_TEST(test_send);
+  RUN_TEST(test_send_not_modified);
+  return UNITY_END();
+}
@@ -0,0 +1,122 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+/*
+ * Copyright (C) 2025 Robert Wendlandt
+ */
+#include <thingy.h>
+#include <unity.h>
+
+// NVS is simulated in a map (see ConfigTask.cpp), it outlives an instance just like it outlives a restart
+
+void setUp() {}
+
+void tearDown() {}
+
+void test_values_survive_a_restart() {
+  {
+    Soylent::ConfigClass config;
+    config.putString("test", "string", "thingy");
+    config.putULong("test", "ulong", 4049);
+    config.putBool("test", "bool", true);
+    config.putBytes("test", "bytes", "\x01\x02\x03", 3);
+    TEST_ASSERT_EQUAL(4, config.getPending());
+    TEST_ASSERT_TRUE(config.flush());
+    TEST_ASSERT_EQUAL(0, config.getPending());
+    TEST_ASSERT_EQUAL(4, config.getStatistics().writes);
+  }
+
+  Soylent::ConfigClass config;
+  TEST_ASSERT_EQUAL_STRING("thingy", config.getString("test", "string").c_str());
+  TEST_ASSERT_EQUAL(4049, config.getULong("test", "ulong"));
+  TEST_ASSERT_TRUE(config.getBool("test", "bool"));
+  uint8_t bytes[8];
+  TEST_ASSERT_EQUAL(3, config.getBytes("test", "bytes", bytes, sizeof(bytes)));
+  TEST_ASSERT_EQUAL_UINT8(0x03, bytes[2]);
+  TEST_ASSERT_EQUAL(7, config.getULong("test", "missing", 7));
+}
+
+void test_unchanged_values_are_not_written() {
+  {
+    Soylent::ConfigClass config;
+    config.putString("unchanged", "build", "2025-01-01");
+    config.flush();
+  }
+
+  Soylent::ConfigClass config;
+  config.putString("unchanged", "build", "2025-01-01");
+  TEST_ASSERT_EQUAL(0, config.getPending());
+  TEST_ASSERT_FALSE(config.flush());
+  TEST_ASSERT_EQUAL(1, config.getStatistics().writesAvoided);
+  TEST_ASSERT_EQUAL(0, config.getStatistics().writes);
+}
+
+void test_changes_in_a_row_are_written_once() {
+  Soylent::ConfigClass config;
+  for (uint32_t state = 0; state < 5; state++) {
+    config.putULong("coalesce", "state", state);
+  }
+  TEST_ASSERT_EQUAL(1, config.getPending());
+  TEST_ASSERT_EQUAL(4, config.getStatistics().writesCoalesced);
+  config.flush();
+  TEST_ASSERT_EQUAL(1, config.getStatistics().writes);
+  // (a single entry)
+  TEST_ASSERT_EQUAL(1, config.getStatistics().entriesWritten);
+  TEST_ASSERT_EQUAL(4, config.getULong("coalesce", "state"));
+}
+
+void test_large_blobs_are_read_back_from_nvs() {
+  uint8_t logo[CONFIG_THINGY_CONFIG_CACHE_SIZE * 2];
+  for (size_t i = 0; i < sizeof(logo); i++) {
+    logo[i] = i * 7;
+  }
+
+  Soylent::ConfigClass config;
+  config.putBytes("blob", "logo", logo, sizeof(logo));
+  config.flush();
+  // blob index, header and data
+  TEST_ASSERT_EQUAL(2 + (sizeof(logo) + NVS_ENTRY_BYTES - 1) / NVS_ENTRY_BYTES, config.getStatistics().entriesWritten);
+
+  uint8_t read[sizeof(logo)] = {};
+  TEST_ASSERT_EQUAL(sizeof(logo), config.getBytes("blob", "logo", read, sizeof(read)));
+  TEST_ASSERT_EQUAL_UINT8_ARRAY(logo, read, sizeof(logo));
+  // (it's known by its crc)
+  config.putBytes("blob", "logo", logo, sizeof(logo));
+  TEST_ASSERT_EQUAL(0, config.getPending());
+}
+
+void test_a_namespace_is_flushed_on_its_own() {
+  {
+    Soylent::ConfigClass config;
+    config.putULong("led", "state", 2);
+    config.putString("safeboot", "ssid", "thingy");
+    TEST_ASSERT_TRUE(config.flush("safeboot"));
+    TEST_ASSERT_EQUAL(1, config.getPending());
+    TEST_ASSERT_FALSE(config.flush("safeboot"));
+  }
+
+  Soylent::ConfigClass config;
+  TEST_ASSERT_EQUAL_STRING("thingy", config.getString("safeboot", "ssid").c_str());
+  TEST_ASSERT_EQUAL(0, config.getULong("led", "state"));
+}
+
+void test_changes_are_flushed_once_it_got_quiet() {
+  Scheduler scheduler;
+  Soylent::ConfigClass config;
+  config.putULong("quiet", "early", 1);
+  config.begin(&scheduler);
+  config.putULong("quiet", "late", 2);
+  TEST_ASSERT_EQUAL(2, config.getPending());
+  config.end();
+  TEST_ASSERT_EQUAL(0, config.getPending());
+  TEST_ASSERT_EQUAL(1, config.getStatistics().flushes);
+}
+
+int main() {
+  UNITY_BEGIN();
+  RUN_TEST(test_values_survive_a_restart);
+  RUN_TEST(test_unchanged_values_are_not_written);
+  RUN_TEST(test_changes_in_a_row_are_written_once);
+  RUN_TEST(test_large_blobs_are_read_back_from_nvs);
+  RUN_TEST(test_a_namespace_is_flushed_on_its_own);
+  RUN_TEST(test_changes_are_flushed_once_it_got_quiet);
+  return UNITY_END();
+}
@@ -0,0 +1,153 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+/*
+ * Copyright (C) 2025 Robert Wendlandt
+ */
+#include <thingy.h>
+#include <string>
+#include <unity.h>
+
+static fs::FS* files;
+static Soylent::FileCache* cache;
+
+// a request for a path, with the ETag the client has (if any)
+static AsyncWebServerResponse* get(const char* path, const char* etag = nullptr) {
+  static AsyncWebServerRequest* request = nullptr;
+  delete request;
+  request = new AsyncWebServerRequest();
+  if (etag != nullptr) {
+    request->addHeader("If-None-Match", etag);
+  }
+  cache->send(request, path, "public, max-age=900");
+  return request->sent();
+}
+
+void setUp() {
+  files = new fs::FS();
+  files->write("/a.svg", std::string(3000, 'a'));
+  files->write("/b.svg", std::string(3000, 'b'));
+  files->write("/c.png", std::string(3000, 'c'));
+  files->write("/large.png", std::string(9000, 'l'));
+  files->write("/fire.svg.gz", "gzipped");
+  // 7000 bytes, files of 6144 bytes at most
+  cache = new Soylent::FileCache(*files, 7000, 6144);
+}
+
+void tearDown() {
+  delete cache;
+  delete files;
+}
+
+void test_read_once_then_kept() {
+  AsyncWebServerResponse* response = get("/a.svg");
+  TEST_ASSERT_EQUAL(200, response->code);
+  TEST_ASSERT_EQUAL_STRING("image/svg+xml", response->contentType.c_str());
+  TEST_ASSERT_TRUE(response->body() == std::string(3000, 'a'));
+  TEST_ASSERT_EQUAL_STRING("public, max-age=900", response->headers["Cache-Control"].c_str());
+  TEST_ASSERT_EQUAL(1, files->opens);
+
+  response = get("/a.svg");
+  TEST_ASSERT_EQUAL(200, response->code);
+  TEST_ASSERT_TRUE(response->body() == std::string(3000, 'a'));
+  TEST_ASSERT_EQUAL(1, files->opens);
+
+  const Soylent::FileCache::Statistics& statistics = cache->getStatistics();
+  TEST_ASSERT_EQUAL(1, statistics.misses);
+  TEST_ASSERT_EQUAL(1, statistics.hits);
+  TEST_ASSERT_EQUAL(1, statistics.files);
+  TEST_ASSERT_EQUAL(3000, statistics.bytes);
+}
+
+void test_etag_and_not_modified() {
+  std::string etag = get("/b.svg")->headers["ETag"];
+  char expected[11];
+  snprintf(expected, sizeof(expected), "\"%08x\"", crcx::crc32(reinterpret_cast<const uint8_t*>(std::string(3000, 'b').data()), 3000));
+  TEST_ASSERT_EQUAL_STRING(expected, etag.c_str());
+
+  AsyncWebServerResponse* response = get("/b.svg", etag.c_str());
+  TEST_ASSERT_EQUAL(304, response->code);
+  TEST_ASSERT_EQUAL_STRING(etag.c_str(), response->headers["ETag"].c_str());
+  TEST_ASSERT_EQUAL(1, cache->getStatistics().notModified);
+
+  TEST_ASSERT_EQUAL(200, get("/b.svg", "\"00000000\"")->code);
+}
+
+void test_least_recently_used_is_dropped() {
+  get("/a.svg");
+  get("/b.svg");
+  // a is used more recently than b now
+  get("/a.svg");
+  get("/c.png");
+  const Soylent::FileCache::Statistics& statistics = cache->getStatistics();
+  TEST_ASSERT_EQUAL(1, statistics.evictions);
+  TEST_ASSERT_EQUAL(2, statistics.files);
+  TEST_ASSERT_EQUAL(6000, statistics.bytes);
+
+  uint32_t opens = files->opens;
+  get("/a.svg");
+  TEST_ASSERT_EQUAL(opens, files->opens);
+  get("/b.svg");
+  TEST_ASSERT_EQUAL(opens + 1, files->opens);
+  // (c was used before a)
+  TEST_ASSERT_EQUAL(2, cache->getStatistics().evictions);
+}
+
+void test_large_files_are_streamed() {
+  AsyncWebServerResponse* response = get("/large.png");
+  TEST_ASSERT_EQUAL(200, response->code);
+  TEST_ASSERT_TRUE(response->streamed);
+  get("/large.png");
+  const Soylent::FileCache::Statistics& statistics = cache->getStatistics();
+  TEST_ASSERT_EQUAL(2, statistics.bypassed);
+  TEST_ASSERT_EQUAL(0, statistics.files);
+}
+
+void test_missing_files() {
+  TEST_ASSERT_EQUAL(404, get("/missing.svg")->code);
+  TEST_ASSERT_EQUAL(404, get("/")->code);
+  TEST_ASSERT_EQUAL(0, cache->getStatistics().misses);
+  TEST_ASSERT_EQUAL(0, cache->getStatistics().files);
+}
+
+void test_gzipped_files() {
+  AsyncWebServerResponse* response = get("/fire.svg");
+  TEST_ASSERT_EQUAL(200, response->code);
+  TEST_ASSERT_EQUAL_STRING("image/svg+xml", response->contentType.c_str());
+  TEST_ASSERT_EQUAL_STRING("gzip", response->headers["Content-Encoding"].c_str());
+  TEST_ASSERT_TRUE(response->body() == "gzipped");
+}
+
+void test_response_outlives_its_entry() {
+  AsyncWebServerResponse sending = *get("/a.svg");
+  get("/b.svg");
+  get("/c.png");
+  cache->invalidate();
+  get("/b.svg");
+  TEST_ASSERT_EQUAL(1, cache->getStatistics().evictions);
+  TEST_ASSERT_TRUE(sending.body() == std::string(3000, 'a'));
+}
+
+void test_invalidate() {
+  get("/a.svg");
+  files->write("/a.svg", "changed");
+  TEST_ASSERT_TRUE(get("/a.svg")->body() == std::string(3000, 'a'));
+
+  cache->invalidate();
+  TEST_ASSERT_TRUE(get("/a.svg")->body() == "changed");
+  const Soylent::FileCache::Statistics& statistics = cache->getStatistics();
+  TEST_ASSERT_EQUAL(1, statistics.invalidations);
+  TEST_ASSERT_EQUAL(2, statistics.misses);
+  TEST_ASSERT_EQUAL(7, statistics.bytes);
+}
+
+int main() {
+  UNITY_BEGIN();
+  RUN_TEST(test_read_once_then_kept);
+  RUN_TEST(test_etag_and_not_modified);
+  RUN_TEST(test_least_recently_used_is_dropped);
+  RUN_TEST(test_large_files_are_streamed);
+  RUN_TEST(test_missing_files);
+  RUN_TEST(test_gzipped_files);
+  RUN_TEST(test_response_outlives_its_entry);
+  RUN_TEST(test_invalidate);
+  return UNITY_END();
+}
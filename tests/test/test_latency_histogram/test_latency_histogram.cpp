@@ -0,0 +1,113 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+/*
+ * Copyright (C) 2025 Robert Wendlandt
+ */
+#include <LatencyHistogram.h>
+#include <unity.h>
+
+using Soylent::LatencyHistogram;
+
+void setUp() {
+  hostMillis = 0;
+}
+
+void tearDown() {
+}
+
+void test_small_values_exact() {
+  for (uint32_t value = 0; value < LatencyHistogram::SUB_BUCKETS; value++) {
+    TEST_ASSERT_EQUAL_UINT16(value, LatencyHistogram::bucketOf(value));
+    TEST_ASSERT_EQUAL_UINT32(value, LatencyHistogram::highestOf(value));
+  }
+}
+
+// every bucket ends right where the next one starts
+void test_buckets_adjoin() {
+  for (uint16_t bucket = 0; bucket < LatencyHistogram::BUCKETS - 1; bucket++) {
+    uint32_t highest = LatencyHistogram::highestOf(bucket);
+    TEST_ASSERT_EQUAL_UINT16(bucket, LatencyHistogram::bucketOf(highest));
+    TEST_ASSERT_EQUAL_UINT16(bucket + 1, LatencyHistogram::bucketOf(highest + 1));
+  }
+  TEST_ASSERT_EQUAL_UINT16(LatencyHistogram::BUCKETS - 1, LatencyHistogram::bucketOf(UINT32_MAX));
+}
+
+// a value is reported as the highest of its bucket, 12.5 % above it at most
+void test_error_bound() {
+  for (uint32_t value = 1; value < (1u << LatencyHistogram::MAX_MAGNITUDE); value = value * 3 / 2 + 1) {
+    uint32_t highest = LatencyHistogram::highestOf(LatencyHistogram::bucketOf(value));
+    TEST_ASSERT_GREATER_OR_EQUAL_UINT32(value, highest);
+    TEST_ASSERT_LESS_OR_EQUAL_UINT32(value / LatencyHistogram::SUB_BUCKETS, highest - value);
+  }
+}
+
+void test_empty() {
+  LatencyHistogram histogram;
+  LatencyHistogram::Summary summary = histogram.summarize(false);
+  TEST_ASSERT_EQUAL_UINT32(0, summary.count);
+  TEST_ASSERT_EQUAL_UINT32(0, summary.min);
+  TEST_ASSERT_EQUAL_UINT32(0, summary.avg);
+  TEST_ASSERT_EQUAL_UINT32(0, summary.p50);
+  TEST_ASSERT_EQUAL_UINT32(0, summary.p99);
+  TEST_ASSERT_EQUAL_UINT32(0, summary.max);
+}
+
+void test_summary() {
+  LatencyHistogram histogram;
+  for (uint32_t value = 1000; value >= 10; value -= 10) {
+    histogram.record(value);
+  }
+  LatencyHistogram::Summary summary = histogram.summarize(false);
+  TEST_ASSERT_EQUAL_UINT32(100, summary.count);
+  TEST_ASSERT_EQUAL_UINT32(10, summary.min);
+  TEST_ASSERT_EQUAL_UINT32(505, summary.avg);
+  TEST_ASSERT_EQUAL_UINT32(1000, summary.max);
+  // the 50th, 90th and 99th value, rounded up to the highest of their buckets
+  TEST_ASSERT_GREATER_OR_EQUAL_UINT32(500, summary.p50);
+  TEST_ASSERT_LESS_OR_EQUAL_UINT32(500 + 500 / 8, summary.p50);
+  TEST_ASSERT_GREATER_OR_EQUAL_UINT32(900, summary.p90);
+  TEST_ASSERT_LESS_OR_EQUAL_UINT32(900 + 900 / 8, summary.p90);
+  // (never above the max)
+  TEST_ASSERT_EQUAL_UINT32(1000, summary.p99);
+}
+
+void test_beyond_the_last_bucket() {
+  LatencyHistogram histogram;
+  histogram.record(100);
+  histogram.record(UINT32_MAX);
+  LatencyHistogram::Summary summary = histogram.summarize(false);
+  TEST_ASSERT_EQUAL_UINT32(UINT32_MAX, summary.max);
+  // (the percentiles saturate at the highest value of the last bucket, the max doesn't)
+  TEST_ASSERT_EQUAL_UINT32(LatencyHistogram::highestOf(LatencyHistogram::BUCKETS - 1), summary.p99);
+  TEST_ASSERT_EQUAL_UINT32(UINT32_MAX / 2 + 50, summary.avg);
+}
+
+void test_reset() {
+  LatencyHistogram histogram;
+  histogram.record(42);
+  hostMillis = 5000;
+  TEST_ASSERT_EQUAL_UINT32(1, histogram.summarize(false).count);
+  TEST_ASSERT_EQUAL_UINT32(1, histogram.summarize(true).count);
+
+  LatencyHistogram::Summary summary = histogram.summarize(false);
+  TEST_ASSERT_EQUAL_UINT32(0, summary.count);
+  TEST_ASSERT_EQUAL_UINT32(0, summary.p50);
+  TEST_ASSERT_EQUAL_UINT32(5000, summary.since);
+
+  histogram.record(7);
+  summary = histogram.summarize(false);
+  TEST_ASSERT_EQUAL_UINT32(7, summary.min);
+  TEST_ASSERT_EQUAL_UINT32(7, summary.max);
+  TEST_ASSERT_EQUAL_UINT32(7, summary.p50);
+}
+
+int main() {
+  UNITY_BEGIN();
+  RUN_TEST(test_small_values_exact);
+  RUN_TEST(test_buckets_adjoin);
+  RUN_TEST(test_error_bound);
+  RUN_TEST(test_empty);
+  RUN_TEST(test_summary);
+  RUN_TEST(test_beyond_the_last_bucket);
+  RUN_TEST(test_reset);
+  return UNITY_END();
+}
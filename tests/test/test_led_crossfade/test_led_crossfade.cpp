@@ -0,0 +1,111 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+/*
+ * Copyright (C) 2025 Robert Wendlandt
+ */
+#include <LedCrossfade.h>
+#include <cstdint>
+#include <unity.h>
+
+using Soylent::LedCrossfade::Timeline;
+
+// (in ms ticks, as with the default FreeRTOS tick rate)
+#define DURATION    CONFIG_THINGY_LED_TRANSITION_TIME
+#define FRAME_TICKS (1000 / CONFIG_THINGY_LED_FRAME_RATE)
+
+// runs a crossfade like LedClass does, each frame taking renderTicks to render and show
+static Timeline run(uint32_t start, uint32_t duration, uint32_t frameTicks, uint32_t renderTicks) {
+  Timeline timeline(start, duration, frameTicks);
+  for (uint32_t now = start; timeline.isRunning(now);) {
+    now += renderTicks;
+    now += timeline.next(now);
+  }
+  return timeline;
+}
+
+void setUp() {
+}
+
+void tearDown() {
+}
+
+// from all the old state at the start to all the new one at the end
+void test_endpoints() {
+  Timeline timeline(1000, DURATION, FRAME_TICKS);
+  TEST_ASSERT_TRUE(timeline.isRunning(1000));
+  TEST_ASSERT_EQUAL_UINT8(0, timeline.amountAt(1000));
+  TEST_ASSERT_TRUE(timeline.isRunning(1000 + DURATION - 1));
+  TEST_ASSERT_EQUAL_UINT8(255 * (DURATION - 1) / DURATION, timeline.amountAt(1000 + DURATION - 1));
+  TEST_ASSERT_FALSE(timeline.isRunning(1000 + DURATION));
+  TEST_ASSERT_EQUAL_UINT8(255, timeline.amountAt(1000 + DURATION));
+  TEST_ASSERT_EQUAL_UINT8(255, timeline.amountAt(1000 + 10 * DURATION));
+}
+
+// never back, and all the way (not stuck at a step) even for long transitions
+void test_monotonic() {
+  static const uint32_t DURATIONS[] = {1, 7, DURATION, 100000};
+  for (uint32_t duration : DURATIONS) {
+    Timeline timeline(0, duration, FRAME_TICKS);
+    uint8_t previous = 0;
+    uint32_t steps = 0;
+    for (uint32_t now = 0; now <= duration; now++) {
+      uint8_t amount = timeline.amountAt(now);
+      TEST_ASSERT_TRUE(amount >= previous);
+      steps += amount != previous;
+      previous = amount;
+    }
+    TEST_ASSERT_EQUAL_UINT8(255, previous);
+    if (duration >= 255) {
+      TEST_ASSERT_EQUAL_UINT32(255, steps);
+    }
+  }
+}
+
+// a frame every frameTicks, counted from the start
+void test_frames() {
+  Timeline timeline = run(1000, DURATION, FRAME_TICKS, 3);
+  TEST_ASSERT_EQUAL_UINT32(Timeline::framesOf(DURATION, FRAME_TICKS), timeline.getFrames());
+  TEST_ASSERT_EQUAL_UINT32(DURATION / FRAME_TICKS, timeline.getFrames());
+  TEST_ASSERT_EQUAL_UINT32(0, timeline.getLate());
+
+  // (a partial last frame is shown as well)
+  TEST_ASSERT_EQUAL_UINT32(3, Timeline::framesOf(41, 20));
+  TEST_ASSERT_EQUAL_UINT32(3, run(0, 41, 20, 0).getFrames());
+  // (a tick at least between frames)
+  TEST_ASSERT_EQUAL_UINT32(DURATION, run(0, DURATION, 0, 0).getFrames());
+}
+
+// rendering slower than the frame rate shows fewer frames, the transition takes no longer
+void test_late() {
+  Timeline timeline = run(1000, DURATION, FRAME_TICKS, FRAME_TICKS * 3 / 2);
+  TEST_ASSERT_TRUE(timeline.getLate() > 0);
+  TEST_ASSERT_TRUE(timeline.getFrames() < Timeline::framesOf(DURATION, FRAME_TICKS));
+  TEST_ASSERT_EQUAL_UINT32((DURATION + FRAME_TICKS * 3 / 2 - 1) / (FRAME_TICKS * 3 / 2), timeline.getFrames());
+
+  // a hiccup is caught up with, then it's back on schedule
+  Timeline hiccup(0, DURATION, FRAME_TICKS);
+  uint32_t now = 2 * FRAME_TICKS + 1;
+  TEST_ASSERT_EQUAL_UINT32(0, hiccup.next(now));
+  TEST_ASSERT_EQUAL_UINT32(0, hiccup.next(now));
+  TEST_ASSERT_EQUAL_UINT32(2, hiccup.getLate());
+  TEST_ASSERT_EQUAL_UINT32(FRAME_TICKS - 1, hiccup.next(now));
+  TEST_ASSERT_EQUAL_UINT32(FRAME_TICKS, hiccup.next(now + FRAME_TICKS - 1));
+}
+
+// the tick count wrapping around during a transition
+void test_wrap_around() {
+  uint32_t start = UINT32_MAX - DURATION / 2;
+  Timeline timeline(start, DURATION, FRAME_TICKS);
+  TEST_ASSERT_TRUE(timeline.isRunning(start + DURATION / 2 + 1));
+  TEST_ASSERT_EQUAL_UINT8(255 * (DURATION / 2 + 1) / DURATION, timeline.amountAt(start + DURATION / 2 + 1));
+  TEST_ASSERT_EQUAL_UINT32(DURATION / FRAME_TICKS, run(start, DURATION, FRAME_TICKS, 1).getFrames());
+}
+
+int main() {
+  UNITY_BEGIN();
+  RUN_TEST(test_endpoints);
+  RUN_TEST(test_monotonic);
+  RUN_TEST(test_frames);
+  RUN_TEST(test_late);
+  RUN_TEST(test_wrap_around);
+  return UNITY_END();
+}
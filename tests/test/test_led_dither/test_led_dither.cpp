@@ -0,0 +1,144 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+/*
+ * Copyright (C) 2025 Robert Wendlandt
+ */
+#include <cstring>
+#include <LedDither.h>
+#include <unity.h>
+
+using Soylent::LedDither::Dither;
+
+// what the dither is aiming at, in 1/256
+static uint32_t targetOf(uint8_t color, uint8_t adjustment, uint8_t brightness) {
+  return (static_cast<uint32_t>(color) * (adjustment + 1) * (brightness + 1)) >> 8;
+}
+
+// the sums of the 8-bit values shown per channel over the frames
+static void show(Dither& dither, uint32_t frames, uint32_t sums[3]) {
+  for (uint32_t frame = 0; frame < frames; frame++) {
+    CRGB shown;
+    dither.next(&shown);
+    for (uint8_t c = 0; c < 3; c++) {
+      sums[c] += shown.raw[c];
+    }
+  }
+}
+
+static Dither dither;
+
+void setUp() {
+  dither.reset();
+}
+
+void tearDown() {
+}
+
+// over 256 frames exactly the target, over any number of frames (beyond 256) within 1/256 of it on average
+void test_mean() {
+  static const uint32_t FRAMES[] = {256, 1000, 256 * 7, 4099};
+  for (uint16_t brightness = 0; brightness < 256; brightness += 3) {
+    for (uint16_t color = 0; color < 256; color += 5) {
+      CRGB target(color, 255 - color, color / 2);
+      CRGB adjustment(255, 200, 176);
+      for (uint32_t frames : FRAMES) {
+        dither.reset();
+        dither.setTarget(target, adjustment, brightness);
+        uint32_t sums[3] = {0, 0, 0};
+        show(dither, frames, sums);
+        for (uint8_t c = 0; c < 3; c++) {
+          uint32_t expected = targetOf(target.raw[c], adjustment.raw[c], brightness) * frames;
+          // |sum / frames - target / 256| <= 1 / 256
+          TEST_ASSERT_UINT32_WITHIN(frames, expected, sums[c] * 256);
+          if (frames % 256 == 0) {
+            TEST_ASSERT_EQUAL_UINT32(expected, sums[c] * 256);
+          }
+        }
+      }
+    }
+  }
+}
+
+// at the very top (65280 is full on, nothing to dither) and just below it
+void test_top() {
+  static const uint8_t TOP[][3] = {
+    {255, 255, 255}, // 65280
+    {255, 255, 254}, // 65025
+    {254, 255, 255}, // 65024
+    {255, 254, 254}, // 64770
+    {255, 253, 255}, // 64770
+    {253, 254, 255}, // 64515
+  };
+  static const uint32_t FRAMES[] = {256, 1000};
+  for (const auto& top : TOP) {
+    uint32_t target = targetOf(top[0], top[1], top[2]);
+    for (uint32_t frames : FRAMES) {
+      dither.reset();
+      dither.setTarget(CRGB(top[0], top[0], top[0]), CRGB(top[1], top[1], top[1]), top[2]);
+      TEST_ASSERT_EQUAL(target % 256 != 0, dither.isFractional());
+      uint32_t sums[3] = {0, 0, 0};
+      show(dither, frames, sums);
+      for (uint8_t c = 0; c < 3; c++) {
+        TEST_ASSERT_UINT32_WITHIN(frames, target * frames, sums[c] * 256);
+        // (never above full on)
+        TEST_ASSERT_LESS_OR_EQUAL_UINT32(255 * frames, sums[c]);
+      }
+    }
+  }
+  TEST_ASSERT_EQUAL_UINT32(65280, targetOf(255, 255, 255));
+}
+
+// dithering what's shown last (steady) doesn't change what's shown, nor does a new target lose what was carried over
+void test_steady() {
+  CRGB target(37, 128, 201);
+  CRGB adjustment(255, 255, 255);
+  dither.setTarget(target, adjustment, 99);
+  uint32_t sums[3] = {0, 0, 0};
+  show(dither, 100, sums);
+  dither.setSteady(true);
+  TEST_ASSERT_TRUE(dither.isSteady());
+  // (the LED task sets the target once more before it's done)
+  dither.setTarget(target, adjustment, 99);
+  show(dither, 900, sums);
+  for (uint8_t c = 0; c < 3; c++) {
+    TEST_ASSERT_UINT32_WITHIN(1000, targetOf(target.raw[c], 255, 99) * 1000, sums[c] * 256);
+  }
+
+  dither.reset();
+  TEST_ASSERT_FALSE(dither.isSteady());
+  TEST_ASSERT_FALSE(dither.isFractional());
+}
+
+// the pixels' targets on their own work the same
+void test_pixels() {
+  CRGB pixels[CONFIG_THINGY_LED_COUNT];
+  for (uint16_t i = 0; i < CONFIG_THINGY_LED_COUNT; i++) {
+    pixels[i] = CRGB(255, 1, 128);
+  }
+  dither.setTarget(pixels, CRGB(255, 255, 255), 254);
+  TEST_ASSERT_FALSE(dither.isUniform());
+  TEST_ASSERT_TRUE(dither.isFractional());
+  CRGB frame[CONFIG_THINGY_LED_COUNT];
+  uint32_t sums[CONFIG_THINGY_LED_COUNT][3] = {};
+  for (uint32_t n = 0; n < 1000; n++) {
+    dither.next(frame);
+    for (uint16_t i = 0; i < CONFIG_THINGY_LED_COUNT; i++) {
+      for (uint8_t c = 0; c < 3; c++) {
+        sums[i][c] += frame[i].raw[c];
+      }
+    }
+  }
+  for (uint16_t i = 0; i < CONFIG_THINGY_LED_COUNT; i++) {
+    for (uint8_t c = 0; c < 3; c++) {
+      TEST_ASSERT_UINT32_WITHIN(1000, targetOf(pixels[i].raw[c], 255, 254) * 1000, sums[i][c] * 256);
+    }
+  }
+}
+
+int main() {
+  UNITY_BEGIN();
+  RUN_TEST(test_mean);
+  RUN_TEST(test_top);
+  RUN_TEST(test_steady);
+  RUN_TEST(test_pixels);
+  return UNITY_END();
+}
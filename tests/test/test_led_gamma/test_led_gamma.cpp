@@ -0,0 +1,95 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+/*
+ * Copyright (C) 2025 Robert Wendlandt
+ */
+#include <LedGamma.h>
+#include <cmath>
+#include <unity.h>
+
+using namespace Soylent;
+
+#define MAX_DUTY ((1 << LED_GAMMA_RESOLUTION) - 1)
+
+// worst deviation of the hardware fades (linear in duty, per segment) from the gamma curve (in duty)
+static uint32_t worstDeviation(uint8_t from, uint8_t to, uint32_t duration) {
+  double worst = 0;
+  uint8_t level = from;
+  uint32_t start = 0;
+  for (uint8_t i = 1; i <= LED_FADE_SEGMENTS; i++) {
+    LedGamma::Segment segment = LedGamma::segment(from, to, duration, i);
+    for (uint32_t t = start; t <= segment.end; t++) {
+      double shown = segment.end == start ? LedGamma::table[segment.level]
+                                          : LedGamma::table[level] + (static_cast<double>(LedGamma::table[segment.level]) - LedGamma::table[level]) * (t - start) / (segment.end - start);
+      double exact = LedGamma::table[static_cast<uint8_t>(std::lround(from + (static_cast<double>(to) - from) * t / duration))];
+      worst = std::fmax(worst, std::fabs(shown - exact));
+    }
+    level = segment.level;
+    start = segment.end;
+  }
+  return std::lround(std::ceil(worst));
+}
+
+void setUp() {
+}
+
+void tearDown() {
+}
+
+// from off to full duty, every level at least as bright as the one before, the lowest still on
+void test_table() {
+  TEST_ASSERT_EQUAL_UINT16(0, LedGamma::table[0]);
+  TEST_ASSERT_EQUAL_UINT16(MAX_DUTY, LedGamma::table[255]);
+  for (uint16_t i = 1; i < 256; i++) {
+    TEST_ASSERT_TRUE(LedGamma::table[i] >= LedGamma::table[i - 1]);
+    TEST_ASSERT_TRUE(LedGamma::table[i] > 0);
+  }
+}
+
+// gamma 2.2, rounded (but for the lowest levels kept on)
+void test_curve() {
+  for (uint16_t i = 1; i < 256; i++) {
+    long exact = std::lround(MAX_DUTY * std::pow(i / 255.0, 2.2));
+    TEST_ASSERT_EQUAL_INT(exact < 1 ? 1 : exact, LedGamma::table[i]);
+  }
+}
+
+// the segments end at the target level and duration, they go only one way, and none is skipped (for more than a step)
+void test_segments() {
+  static const uint8_t LEVELS[][2] = {{0, 255}, {255, 0}, {17, 200}, {200, 17}, {100, 101}, {101, 100}, {42, 42}};
+  static const uint32_t DURATIONS[] = {0, 7, 150, 2432};
+  for (const auto& levels : LEVELS) {
+    for (uint32_t duration : DURATIONS) {
+      uint8_t from = levels[0], to = levels[1];
+      LedGamma::Segment previous = {from, 0};
+      for (uint8_t i = 1; i <= LED_FADE_SEGMENTS; i++) {
+        LedGamma::Segment segment = LedGamma::segment(from, to, duration, i);
+        TEST_ASSERT_TRUE(segment.end >= previous.end);
+        TEST_ASSERT_TRUE(to >= from ? segment.level >= previous.level && segment.level <= to : segment.level <= previous.level && segment.level >= to);
+        TEST_ASSERT_TRUE(segment.end - previous.end <= duration / LED_FADE_SEGMENTS + 1);
+        previous = segment;
+      }
+      TEST_ASSERT_EQUAL_UINT8(to, previous.level);
+      TEST_ASSERT_EQUAL_UINT32(duration, previous.end);
+    }
+  }
+}
+
+// the hardware fades follow the curve within 1/64 of the full duty (see tools/gamma_table.py)
+void test_fade_deviation() {
+  // (breathing: 128 * 19 ms per half period, blinking: 150 ms)
+  TEST_ASSERT_LESS_OR_EQUAL_UINT32(MAX_DUTY / 64, worstDeviation(0, 255, 2432));
+  TEST_ASSERT_LESS_OR_EQUAL_UINT32(MAX_DUTY / 64, worstDeviation(255, 0, 2432));
+  TEST_ASSERT_LESS_OR_EQUAL_UINT32(MAX_DUTY / 64, worstDeviation(0, 255, 150));
+  TEST_ASSERT_LESS_OR_EQUAL_UINT32(MAX_DUTY / 64, worstDeviation(255, 0, 150));
+  // (all the way up and down is the worst case)
+  TEST_ASSERT_LESS_OR_EQUAL_UINT32(worstDeviation(0, 255, 2432), worstDeviation(64, 192, 2432));
+}
+
+int main() {
+  UNITY_BEGIN();
+  RUN_TEST(test_table);
+  RUN_TEST(test_curve);
+  RUN_TEST(test_segments);
+  RUN_TEST(test_fade_deviation);
+  return UNITY_END();
+}
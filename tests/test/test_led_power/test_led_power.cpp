@@ -0,0 +1,150 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+/*
+ * Copyright (C) 2025 Robert Wendlandt
+ */
+#include <Arduino.h>
+#include <cstdlib>
+#include <cstring>
+// (a strip and a budget of their own, the other tests do with a single pixel)
+#undef CONFIG_THINGY_LED_COUNT
+#define CONFIG_THINGY_LED_COUNT 64
+#define CONFIG_THINGY_LED_POWER_BUDGET 500
+#include <LedPower.h>
+#include <unity.h>
+
+using Soylent::LedPower::Budget;
+
+static CRGB pixels[CONFIG_THINGY_LED_COUNT];
+
+static CRGB randomColor() {
+  return CRGB(std::rand() % 256, std::rand() % 256, std::rand() % 256);
+}
+
+// the estimate accounting for all pixels at once
+static uint32_t recomputed(const CRGB* frame) {
+  Budget budget;
+  budget.reset();
+  budget.update(frame, 0, CONFIG_THINGY_LED_COUNT);
+  return budget.getMilliamps();
+}
+
+void setUp() {
+  std::srand(42);
+  for (uint16_t i = 0; i < CONFIG_THINGY_LED_COUNT; i++) {
+    pixels[i] = randomColor();
+  }
+}
+
+void tearDown() {
+}
+
+void test_estimate() {
+  CRGB frame[CONFIG_THINGY_LED_COUNT];
+  for (uint16_t i = 0; i < CONFIG_THINGY_LED_COUNT; i++) {
+    frame[i] = CRGB(255, 255, 255);
+  }
+  TEST_ASSERT_EQUAL_UINT32((CONFIG_THINGY_LED_IDLE_CURRENT + 3 * CONFIG_THINGY_LED_CHANNEL_CURRENT) * CONFIG_THINGY_LED_COUNT, recomputed(frame));
+  for (uint16_t i = 0; i < CONFIG_THINGY_LED_COUNT; i++) {
+    frame[i] = CRGB(0, 0, 0);
+  }
+  TEST_ASSERT_EQUAL_UINT32(CONFIG_THINGY_LED_IDLE_CURRENT * CONFIG_THINGY_LED_COUNT, recomputed(frame));
+}
+
+// updating just the pixels changed comes to the same as accounting for all of them
+void test_incremental() {
+  Budget budget;
+  budget.reset();
+  budget.update(pixels, 0, CONFIG_THINGY_LED_COUNT);
+  for (uint16_t round = 0; round < 1000; round++) {
+    uint16_t first = std::rand() % CONFIG_THINGY_LED_COUNT;
+    uint16_t count = 1 + std::rand() % (CONFIG_THINGY_LED_COUNT - first);
+    for (uint16_t i = first; i < first + count; i++) {
+      pixels[i] = randomColor();
+    }
+    budget.update(pixels, first, count);
+    TEST_ASSERT_EQUAL_UINT32(recomputed(pixels), budget.getMilliamps());
+  }
+  // (a range beyond the strip is cut off)
+  pixels[CONFIG_THINGY_LED_COUNT - 1] = CRGB(0, 0, 0);
+  budget.update(pixels, CONFIG_THINGY_LED_COUNT - 1, 10);
+  TEST_ASSERT_EQUAL_UINT32(recomputed(pixels), budget.getMilliamps());
+}
+
+// after invalidate() the next update accounts for all pixels, whatever its range
+void test_invalidate() {
+  Budget budget;
+  budget.reset();
+  budget.update(pixels, 0, CONFIG_THINGY_LED_COUNT);
+  // (other pixels taken over, without telling which)
+  for (uint16_t i = 0; i < CONFIG_THINGY_LED_COUNT; i += 3) {
+    pixels[i] = randomColor();
+  }
+  budget.invalidate();
+  budget.update(pixels, 1, 1);
+  TEST_ASSERT_EQUAL_UINT32(recomputed(pixels), budget.getMilliamps());
+}
+
+// a single color is O(1), the first update after it accounts for all pixels (not just for the range changed)
+void test_leaving_uniform() {
+  Budget budget;
+  budget.reset();
+  budget.fill(CRGB(10, 20, 30));
+  uint32_t sum = 10 + 20 + 30;
+  TEST_ASSERT_EQUAL_UINT32(CONFIG_THINGY_LED_IDLE_CURRENT * CONFIG_THINGY_LED_COUNT + sum * CONFIG_THINGY_LED_COUNT * CONFIG_THINGY_LED_CHANNEL_CURRENT / 255, budget.getMilliamps());
+
+  budget.update(pixels, 5, 3);
+  TEST_ASSERT_EQUAL_UINT32(recomputed(pixels), budget.getMilliamps());
+  pixels[6] = CRGB(255, 0, 0);
+  budget.update(pixels, 6, 1);
+  TEST_ASSERT_EQUAL_UINT32(recomputed(pixels), budget.getMilliamps());
+
+  // and back to a single color
+  budget.fill(CRGB(0, 0, 0));
+  TEST_ASSERT_EQUAL_UINT32(CONFIG_THINGY_LED_IDLE_CURRENT * CONFIG_THINGY_LED_COUNT, budget.getMilliamps());
+}
+
+// what's shown at the brightness returned stays within the budget, and isn't dimmed more than needed
+void test_brightness_limit() {
+  CRGB frame[CONFIG_THINGY_LED_COUNT];
+  for (uint16_t round = 0; round < 1000; round++) {
+    // from dark to all white
+    uint8_t level = round % 256;
+    for (uint16_t i = 0; i < CONFIG_THINGY_LED_COUNT; i++) {
+      pixels[i] = round % 2 ? CRGB(level, level, level) : randomColor();
+    }
+    Budget budget;
+    budget.reset();
+    budget.update(pixels, 0, CONFIG_THINGY_LED_COUNT);
+    uint8_t brightness = budget.getBrightness();
+    if (budget.getMilliamps() <= CONFIG_THINGY_LED_POWER_BUDGET) {
+      TEST_ASSERT_EQUAL_UINT8(255, brightness);
+      TEST_ASSERT_EQUAL_UINT32(0, budget.getLimited());
+      continue;
+    }
+    TEST_ASSERT_EQUAL_UINT32(1, budget.getLimited());
+
+    // (the brightness is applied like scale8 does)
+    for (uint16_t i = 0; i < CONFIG_THINGY_LED_COUNT; i++) {
+      for (uint8_t c = 0; c < 3; c++) {
+        frame[i].raw[c] = scale8(pixels[i].raw[c], brightness);
+      }
+    }
+    TEST_ASSERT_LESS_OR_EQUAL_UINT32(CONFIG_THINGY_LED_POWER_BUDGET, recomputed(frame));
+    for (uint16_t i = 0; i < CONFIG_THINGY_LED_COUNT; i++) {
+      for (uint8_t c = 0; c < 3; c++) {
+        frame[i].raw[c] = scale8(pixels[i].raw[c], brightness + 1);
+      }
+    }
+    TEST_ASSERT_TRUE(recomputed(frame) > CONFIG_THINGY_LED_POWER_BUDGET - CONFIG_THINGY_LED_POWER_BUDGET / 20);
+  }
+}
+
+int main() {
+  UNITY_BEGIN();
+  RUN_TEST(test_estimate);
+  RUN_TEST(test_incremental);
+  RUN_TEST(test_invalidate);
+  RUN_TEST(test_leaving_uniform);
+  RUN_TEST(test_brightness_limit);
+  return UNITY_END();
+}
@@ -0,0 +1,101 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+/*
+ * Copyright (C) 2025 Robert Wendlandt
+ */
+#include <PixelKernels.h>
+#include <cstdlib>
+#include <cstring>
+#include <unity.h>
+
+using Soylent::PixelKernels::Packed;
+using Soylent::PixelKernels::Portable;
+
+#define PIXELS 256
+
+static CRGB reference[PIXELS];
+static CRGB packed[PIXELS];
+static CRGB layer[PIXELS];
+
+// the same random pixels for both, and a layer to blend
+static void randomize() {
+  for (uint16_t i = 0; i < PIXELS; i++) {
+    reference[i] = packed[i] = CRGB(std::rand() % 256, std::rand() % 256, std::rand() % 256);
+    layer[i] = CRGB(std::rand() % 256, std::rand() % 256, std::rand() % 256);
+  }
+}
+
+// whole frames and odd counts (where the last channel or pixel has no partner), pixels beyond count untouched
+static const uint16_t COUNTS[] = {1, 2, 3, 7, 64, PIXELS - 1, PIXELS};
+
+void setUp() {
+  std::srand(4049);
+}
+
+void tearDown() {}
+
+void test_the_reference() {
+  TEST_ASSERT_EQUAL(0, scale8(255, 0));
+  TEST_ASSERT_EQUAL(255, scale8(255, 255));
+  TEST_ASSERT_EQUAL(64, scale8(128, 128));
+  TEST_ASSERT_EQUAL(10, blend8(10, 200, 0));
+  TEST_ASSERT_EQUAL(200, blend8(10, 200, 255));
+}
+
+void test_scale() {
+  for (uint16_t count : COUNTS) {
+    for (uint16_t amount = 0; amount < 256; amount++) {
+      randomize();
+      Portable::scale(reference, count, static_cast<uint8_t>(amount));
+      Packed::scale(packed, count, static_cast<uint8_t>(amount));
+      TEST_ASSERT_EQUAL_MEMORY(reference, packed, sizeof(reference));
+    }
+  }
+}
+
+void test_scale_per_channel() {
+  for (uint16_t count : COUNTS) {
+    for (uint16_t amount = 0; amount < 256; amount++) {
+      randomize();
+      CRGB adjustment(amount, 255 - amount, amount >> 1);
+      Portable::scale(reference, count, adjustment);
+      Packed::scale(packed, count, adjustment);
+      TEST_ASSERT_EQUAL_MEMORY(reference, packed, sizeof(reference));
+    }
+  }
+}
+
+void test_blend() {
+  for (uint16_t count : COUNTS) {
+    for (uint16_t amount = 0; amount < 256; amount++) {
+      randomize();
+      Portable::blend(reference, layer, count, static_cast<uint8_t>(amount));
+      Packed::blend(packed, layer, count, static_cast<uint8_t>(amount));
+      TEST_ASSERT_EQUAL_MEMORY(reference, packed, sizeof(reference));
+    }
+  }
+}
+
+// all channel values against all factors, for the lanes not to interfere with each other
+void test_all_channels_and_factors() {
+  for (uint16_t amount = 0; amount < 256; amount++) {
+    for (uint16_t value = 0; value < 256; value++) {
+      reference[value] = packed[value] = CRGB(value, 255 - value, value ^ 0x5A);
+      layer[value] = CRGB(255 - value, value, value ^ 0xA5);
+    }
+    Portable::scale(reference, PIXELS, static_cast<uint8_t>(amount));
+    Packed::scale(packed, PIXELS, static_cast<uint8_t>(amount));
+    Portable::blend(reference, layer, PIXELS, static_cast<uint8_t>(amount));
+    Packed::blend(packed, layer, PIXELS, static_cast<uint8_t>(amount));
+    TEST_ASSERT_EQUAL_MEMORY(reference, packed, sizeof(reference));
+  }
+}
+
+int main() {
+  UNITY_BEGIN();
+  RUN_TEST(test_the_reference);
+  RUN_TEST(test_scale);
+  RUN_TEST(test_scale_per_channel);
+  RUN_TEST(test_blend);
+  RUN_TEST(test_all_channels_and_factors);
+  return UNITY_END();
+}
@@ -0,0 +1,119 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+/*
+ * Copyright (C) 2025 Robert Wendlandt
+ */
+#include <thingy.h>
+#include <esp_ota_ops.h>
+#include <cstring>
+#include <string>
+#include <unity.h>
+
+static std::string written() {
+  char buffer[CONFIG_THINGY_SYSINFO_SIZE];
+  Soylent::SystemInfo::write(buffer, sizeof(buffer));
+  return buffer;
+}
+
+static bool contains(const std::string& json, const char* what) {
+  return json.find(what) != std::string::npos;
+}
+
+void setUp() {
+  hostResetReason = ESP_RST_POWERON;
+  hostPartitions.clear();
+  hostPartitions.push_back({{ESP_PARTITION_TYPE_DATA, ESP_PARTITION_SUBTYPE_ANY, 0x9000, 0x5000, "nvs"}, {}});
+  hostPartitions.push_back({{ESP_PARTITION_TYPE_APP, ESP_PARTITION_SUBTYPE_APP_FACTORY, 0x10000, 0x100000, "app0"}, {}});
+  hostPartitions.push_back({{ESP_PARTITION_TYPE_DATA, ESP_PARTITION_SUBTYPE_DATA_SPIFFS, 0x110000, 0x20000, "spiffs"}, {}});
+  hostRunningPartition = &hostPartitions[1].partition;
+}
+
+void tearDown() {
+}
+
+void test_reset_reasons() {
+  TEST_ASSERT_EQUAL_STRING("panic", Soylent::SystemInfo::resetReasonOf(ESP_RST_PANIC).name);
+  TEST_ASSERT_EQUAL_STRING("cpu_lockup", Soylent::SystemInfo::resetReasonOf(ESP_RST_CPU_LOCKUP).name);
+  // anything unknown is the first entry
+  TEST_ASSERT_EQUAL_STRING("unknown", Soylent::SystemInfo::resetReasonOf(static_cast<esp_reset_reason_t>(99)).name);
+
+  hostResetReason = ESP_RST_TASK_WDT;
+  TEST_ASSERT_EQUAL(ESP_RST_TASK_WDT, Soylent::SystemInfo::getResetReason().reason);
+  TEST_ASSERT_EQUAL_STRING("task_wdt", Soylent::SystemInfo::getResetReason().name);
+}
+
+// every reason has its own entry (and name)
+void test_reset_reasons_unique() {
+  for (const auto& entry : Soylent::SystemInfo::RESET_REASONS) {
+    TEST_ASSERT_EQUAL_PTR(&entry, &Soylent::SystemInfo::resetReasonOf(entry.reason));
+    for (const auto& other : Soylent::SystemInfo::RESET_REASONS) {
+      if (&entry != &other) {
+        TEST_ASSERT_NOT_EQUAL(0, strcmp(entry.name, other.name));
+      }
+    }
+  }
+}
+
+void test_json() {
+  hostResetReason = ESP_RST_BROWNOUT;
+  std::string json = written();
+  // (it fits, with room to spare)
+  TEST_ASSERT_EQUAL(json.size(), Soylent::SystemInfo::write(nullptr, 0));
+  TEST_ASSERT_TRUE(json.size() < CONFIG_THINGY_SYSINFO_SIZE / 2);
+  TEST_ASSERT_TRUE(contains(json, "{\"reset_reason\":{\"code\":9,\"name\":\"brownout\","));
+  TEST_ASSERT_TRUE(contains(json, "\"chip\":{\"model\":\"ESP32-S3\",\"revision\":301,\"cores\":2,\"efuse_mac\":\"123456789abc\",\"features\":[\"wifi\",\"ble\"]}"));
+  TEST_ASSERT_TRUE(contains(json, "\"flash\":{\"size\":8388608,\"speed\":80000000}"));
+  TEST_ASSERT_TRUE(contains(json, "\"build\":{\"project\":\"LEDThingy\",\"version\":\"1.2.3\",\"hash\":\"abcdef0\",\"board\":\"host\",\"timestamp\":\"2025-01-01 12:00:00\","));
+  // (16 hex digits of the ELF SHA-256)
+  TEST_ASSERT_TRUE(contains(json, "\"elf_sha256\":\"0123456789abcdef\"}}"));
+  TEST_ASSERT_EQUAL('}', json.back());
+}
+
+// all partitions, the one running marked
+void test_partitions() {
+  std::string json = written();
+  TEST_ASSERT_TRUE(contains(json, "\"partitions\":[{\"label\":\"nvs\",\"type\":1,\"subtype\":255,\"address\":36864,\"size\":20480,\"running\":false},"
+                                  "{\"label\":\"app0\",\"type\":0,\"subtype\":0,\"address\":65536,\"size\":1048576,\"running\":true},"
+                                  "{\"label\":\"spiffs\",\"type\":1,\"subtype\":130,\"address\":1114112,\"size\":131072,\"running\":false}]"));
+
+  hostPartitions.clear();
+  hostRunningPartition = nullptr;
+  TEST_ASSERT_TRUE(contains(written(), "\"partitions\":[],"));
+}
+
+// like snprintf: cut off (and terminated) when it doesn't fit, still telling the length it takes
+void test_too_small() {
+  std::string json = written();
+  char buffer[32 + 4];
+  memset(buffer, '#', sizeof(buffer));
+  TEST_ASSERT_EQUAL(json.size(), Soylent::SystemInfo::write(buffer, 32));
+  TEST_ASSERT_EQUAL(31, strlen(buffer));
+  TEST_ASSERT_EQUAL(0, json.compare(0, 31, buffer));
+  TEST_ASSERT_EQUAL('#', buffer[32]);
+
+  TEST_ASSERT_EQUAL(json.size(), Soylent::SystemInfo::write(nullptr, 0));
+}
+
+// rendered just once, nothing changes while running
+void test_rendered_once() {
+  size_t length;
+  const char* json = Soylent::SystemInfo::getJson(&length);
+  TEST_ASSERT_EQUAL(strlen(json), length);
+  TEST_ASSERT_TRUE(contains(json, "\"power_on\""));
+
+  hostResetReason = ESP_RST_PANIC;
+  size_t again;
+  TEST_ASSERT_EQUAL_PTR(json, Soylent::SystemInfo::getJson(&again));
+  TEST_ASSERT_EQUAL(length, again);
+  TEST_ASSERT_TRUE(contains(json, "\"power_on\""));
+}
+
+int main() {
+  UNITY_BEGIN();
+  RUN_TEST(test_reset_reasons);
+  RUN_TEST(test_reset_reasons_unique);
+  RUN_TEST(test_json);
+  RUN_TEST(test_partitions);
+  RUN_TEST(test_too_small);
+  RUN_TEST(test_rendered_once);
+  return UNITY_END();
+}
@@ -0,0 +1,293 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+/*
+ * Copyright (C) 2025 Robert Wendlandt
+ */
+#include <SyncNode.h>
+#include <unity.h>
+
+using Soylent::SyncNode;
+
+// (ms, like CONFIG_THINGY_SYNC_INTERVAL)
+#define INTERVAL 1000
+// what the clocks of all nodes have to agree on (us)
+#define TOLERANCE 1000
+
+// A node of the simulated network: its own local clock, started at some point and running a bit fast or slow
+struct Node {
+    SyncNode sync;
+    int64_t start;
+    int32_t ppm;
+    bool running;
+
+    int64_t local(int64_t t) const {
+      return start + t + t * ppm / 1000000;
+    }
+
+    int64_t network(int64_t t) const {
+      int64_t localTime = local(t);
+      return localTime + sync.getOffsetAt(localTime);
+    }
+
+    uint32_t millis(int64_t t) const {
+      return static_cast<uint32_t>(local(t) / 1000);
+    }
+};
+
+static Node nodes[4];
+static const size_t NODES = sizeof(nodes) / sizeof(nodes[0]);
+// true time (us)
+static int64_t now;
+static uint32_t seed;
+
+// one-way delay of a packet, 100 us to 1.5 ms (us)
+static int64_t delay() {
+  seed = seed * 1664525 + 1013904223;
+  return 100 + (seed >> 8) % 1400;
+}
+
+static Node* find(uint32_t nodeId) {
+  for (Node& node : nodes) {
+    if (node.running && node.sync.getNodeId() == nodeId) {
+      return &node;
+    }
+  }
+  return nullptr;
+}
+
+static void join(size_t index, uint32_t nodeId, int64_t start, int32_t ppm) {
+  nodes[index].sync = SyncNode();
+  nodes[index].sync.begin(nodeId);
+  nodes[index].start = start;
+  nodes[index].ppm = ppm;
+  nodes[index].running = true;
+}
+
+// A sync interval, like TimeSyncClass::_syncCallback() and _onPacket() of every node running
+static void interval() {
+  for (size_t i = 0; i < NODES; i++) {
+    Node& node = nodes[i];
+    if (!node.running) {
+      continue;
+    }
+    // (the nodes aren't sending all at once)
+    int64_t t = now + static_cast<int64_t>(i) * 10000;
+    node.sync.checkLeader(node.millis(t), 3 * INTERVAL);
+
+    uint32_t nodeId = node.sync.getNodeId();
+    uint32_t leaderId = node.sync.getLeaderId();
+    for (Node& other : nodes) {
+      if (other.running && &other != &node) {
+        other.sync.onBeacon(nodeId, leaderId, other.millis(t + delay()));
+      }
+    }
+
+    Node* leader = find(leaderId);
+    if (leader != &node && leader != nullptr && leader->sync.isLeader()) {
+      int64_t t1 = node.local(t);
+      int64_t arrival = t + delay();
+      int64_t t2 = leader->network(arrival);
+      int64_t t3 = leader->network(arrival + 50);
+      int64_t t4 = node.local(arrival + 50 + delay());
+      node.sync.onResponse(leaderId, t1, t2, t3, t4);
+    }
+  }
+  now += INTERVAL * 1000;
+}
+
+// how far the network time of the nodes running is apart (us)
+static int64_t spread() {
+  int64_t lowest = INT64_MAX;
+  int64_t highest = INT64_MIN;
+  for (Node& node : nodes) {
+    if (node.running) {
+      int64_t network = node.network(now);
+      lowest = network < lowest ? network : lowest;
+      highest = network > highest ? network : highest;
+    }
+  }
+  return highest - lowest;
+}
+
+static void assertLeader(uint32_t leaderId) {
+  for (Node& node : nodes) {
+    if (node.running) {
+      TEST_ASSERT_EQUAL_UINT32(leaderId, node.sync.getLeaderId());
+      TEST_ASSERT_TRUE(node.sync.isSynced());
+    }
+  }
+}
+
+void setUp() {
+  for (Node& node : nodes) {
+    node = Node();
+  }
+  now = 0;
+  seed = 42;
+}
+
+void tearDown() {
+}
+
+void test_single_node() {
+  join(0, 0x10, 5000000, 0);
+  TEST_ASSERT_TRUE(nodes[0].sync.isLeader());
+  TEST_ASSERT_TRUE(nodes[0].sync.isSynced());
+  // leading on its own, with the clock as it is (or as it was set)
+  TEST_ASSERT_EQUAL_INT64(0, nodes[0].sync.getOffsetAt(123456));
+  nodes[0].sync.setOffset(1000000, 5000000);
+  TEST_ASSERT_EQUAL_INT64(1000000, nodes[0].sync.getOffsetAt(7000000));
+}
+
+// NTP-style: the first sample is taken at once, from then on only the one with the shortest round trip of each window
+void test_samples() {
+  SyncNode sync;
+  sync.begin(0x20);
+  TEST_ASSERT_EQUAL(SyncNode::Beacon::FOLLOWING, sync.onBeacon(0x10, 0x10, 0));
+  TEST_ASSERT_FALSE(sync.isSynced());
+
+  // (the leader is 1 s ahead, 100 us each way)
+  TEST_ASSERT_TRUE(sync.onResponse(0x10, 1000, 1001100, 1001100, 1200));
+  TEST_ASSERT_TRUE(sync.isSynced());
+  TEST_ASSERT_EQUAL_INT64(1000000, sync.getOffset());
+  TEST_ASSERT_EQUAL_INT64(200, sync.getDelay());
+
+  // only from the leader
+  TEST_ASSERT_FALSE(sync.onResponse(0x30, 2000, 1002100, 1002100, 2200));
+  // 100 us there, 900 us back: off by 400 us, but not taken as the round trip of the next one is shorter
+  TEST_ASSERT_FALSE(sync.onResponse(0x10, 2000, 1002100, 1002100, 3000));
+  TEST_ASSERT_FALSE(sync.onResponse(0x10, 3000, 1003100, 1003100, 3200));
+  TEST_ASSERT_FALSE(sync.onResponse(0x10, 4000, 1004200, 1004200, 4400));
+  TEST_ASSERT_TRUE(sync.onResponse(0x10, 5000, 1005200, 1005200, 5400));
+  TEST_ASSERT_EQUAL_INT64(1000000, sync.getOffset());
+  TEST_ASSERT_EQUAL_INT64(200, sync.getDelay());
+}
+
+// way off, the clock is stepped instead of slewed
+void test_step() {
+  SyncNode sync;
+  sync.begin(0x20);
+  sync.onBeacon(0x10, 0x10, 0);
+  sync.onResponse(0x10, 1000, 1001100, 1001100, 1200);
+  for (int64_t at = 2000; at < 6000; at += 1000) {
+    sync.onResponse(0x10, at, at + 1000100 + SYNC_STEP_THRESHOLD * 2, at + 1000100 + SYNC_STEP_THRESHOLD * 2, at + 200);
+  }
+  TEST_ASSERT_EQUAL_INT64(1000000 + SYNC_STEP_THRESHOLD * 2, sync.getOffset());
+  TEST_ASSERT_EQUAL_FLOAT(0, sync.getDrift());
+}
+
+// all nodes follow the one with the lowest id, their clocks agree
+void test_converge() {
+  join(0, 0x30, 7000000, 50);
+  join(1, 0x10, 1000000, -30);
+  join(2, 0x40, 123456789, -50);
+  join(3, 0x20, 42, 20);
+  for (int i = 0; i < 10; i++) {
+    interval();
+  }
+  assertLeader(0x10);
+  TEST_ASSERT_TRUE(nodes[1].sync.isLeader());
+  TEST_ASSERT_LESS_OR_EQUAL_INT64(TOLERANCE, spread());
+
+  // and keep on agreeing, the drift is estimated
+  for (int i = 0; i < 600; i++) {
+    interval();
+    TEST_ASSERT_LESS_OR_EQUAL_INT64(TOLERANCE, spread());
+  }
+  // (noisy, just the direction: a local clock faster than the leader's is behind more and more)
+  TEST_ASSERT_TRUE(nodes[0].sync.getDrift() < 0);
+  TEST_ASSERT_TRUE(nodes[2].sync.getDrift() > 0);
+}
+
+// the leader is gone: the one with the next lowest id takes over, the clocks keep on running
+void test_handover() {
+  join(0, 0x30, 7000000, 50);
+  join(1, 0x10, 1000000, -30);
+  join(2, 0x40, 123456789, -50);
+  join(3, 0x20, 42, 20);
+  for (int i = 0; i < 60; i++) {
+    interval();
+  }
+  assertLeader(0x10);
+
+  nodes[1].running = false;
+  int64_t before = nodes[0].network(now);
+  for (int i = 0; i < 10; i++) {
+    int64_t previous[NODES];
+    for (size_t n = 0; n < NODES; n++) {
+      previous[n] = nodes[n].network(now);
+    }
+    interval();
+    // (no node is stepping its clock)
+    for (size_t n = 0; n < NODES; n++) {
+      if (nodes[n].running) {
+        TEST_ASSERT_INT64_WITHIN(TOLERANCE, INTERVAL * 1000, nodes[n].network(now) - previous[n]);
+      }
+    }
+  }
+  assertLeader(0x20);
+  TEST_ASSERT_TRUE(nodes[3].sync.isLeader());
+  TEST_ASSERT_LESS_OR_EQUAL_INT64(TOLERANCE, spread());
+  TEST_ASSERT_INT64_WITHIN(TOLERANCE, 10 * INTERVAL * 1000, nodes[0].network(now) - before);
+
+  for (int i = 0; i < 60; i++) {
+    interval();
+    TEST_ASSERT_LESS_OR_EQUAL_INT64(TOLERANCE, spread());
+  }
+}
+
+// a node with a lower id joining: its clock is the one of the network from then on
+void test_join_lower() {
+  join(0, 0x30, 7000000, 50);
+  join(1, 0x10, 1000000, -30);
+  join(2, 0x40, 123456789, -50);
+  for (int i = 0; i < 30; i++) {
+    interval();
+  }
+  assertLeader(0x10);
+
+  join(3, 0x08, 987654321, 0);
+  // the leader follows the new one, its followers lead on their own until they hear from it
+  TEST_ASSERT_EQUAL(SyncNode::Beacon::FOLLOWING, nodes[1].sync.onBeacon(0x08, 0x08, nodes[1].millis(now)));
+  TEST_ASSERT_EQUAL(SyncNode::Beacon::LEADER_LEFT, nodes[0].sync.onBeacon(0x10, 0x08, nodes[0].millis(now)));
+  TEST_ASSERT_TRUE(nodes[0].sync.isLeader());
+  TEST_ASSERT_EQUAL(SyncNode::Beacon::FOLLOWING, nodes[0].sync.onBeacon(0x08, 0x08, nodes[0].millis(now)));
+
+  for (int i = 0; i < 10; i++) {
+    interval();
+  }
+  assertLeader(0x08);
+  TEST_ASSERT_TRUE(nodes[3].sync.isLeader());
+  TEST_ASSERT_LESS_OR_EQUAL_INT64(TOLERANCE, spread());
+  TEST_ASSERT_INT64_WITHIN(TOLERANCE, nodes[3].local(now), nodes[0].network(now));
+}
+
+// a follower sticks to its leader, even if a node with a lower id shows up
+void test_follower_sticks() {
+  SyncNode sync;
+  sync.begin(0x30);
+  sync.onBeacon(0x20, 0x20, 0);
+  TEST_ASSERT_EQUAL(SyncNode::Beacon::NONE, sync.onBeacon(0x10, 0x10, 100));
+  TEST_ASSERT_EQUAL_UINT32(0x20, sync.getLeaderId());
+
+  // until the leader is gone for longer than the timeout
+  TEST_ASSERT_EQUAL(SyncNode::Beacon::LEADER_SEEN, sync.onBeacon(0x20, 0x20, 1000));
+  TEST_ASSERT_EQUAL_UINT32(0, sync.checkLeader(1000 + 3 * INTERVAL, 3 * INTERVAL));
+  TEST_ASSERT_EQUAL_UINT32(0x20, sync.checkLeader(1001 + 3 * INTERVAL, 3 * INTERVAL));
+  TEST_ASSERT_TRUE(sync.isLeader());
+  TEST_ASSERT_EQUAL(SyncNode::Beacon::FOLLOWING, sync.onBeacon(0x10, 0x10, 5000));
+
+  sync.end();
+  TEST_ASSERT_TRUE(sync.isLeader());
+}
+
+int main() {
+  UNITY_BEGIN();
+  RUN_TEST(test_single_node);
+  RUN_TEST(test_samples);
+  RUN_TEST(test_step);
+  RUN_TEST(test_converge);
+  RUN_TEST(test_handover);
+  RUN_TEST(test_join_lower);
+  RUN_TEST(test_follower_sticks);
+  return UNITY_END();
+}
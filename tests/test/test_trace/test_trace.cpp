@@ -0,0 +1,114 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+/*
+ * Copyright (C) 2025 Robert Wendlandt
+ */
+#include <Trace.h>
+#include <string>
+#include <unity.h>
+
+// collects what's exported, like a response stream would
+struct Output {
+    std::string json;
+
+    void print(const char* chunk) {
+      json += chunk;
+    }
+};
+
+static std::string exported() {
+  Output output;
+  Soylent::Trace::write(output);
+  return output.json;
+}
+
+static size_t count(const std::string& json, const std::string& what) {
+  size_t found = 0;
+  for (size_t at = json.find(what); at != std::string::npos; at = json.find(what, at + 1)) {
+    found++;
+  }
+  return found;
+}
+
+void setUp() {
+  Soylent::Trace::clear();
+}
+
+void tearDown() {
+}
+
+void test_empty() {
+  TEST_ASSERT_EQUAL_UINT32(0, Soylent::Trace::getRecorded());
+  TEST_ASSERT_EQUAL_STRING("{\"traceEvents\":[],\"displayTimeUnit\":\"ms\",\"otherData\":{\"recorded\":0}}", exported().c_str());
+}
+
+void test_scope() {
+  {
+    TRACE_SCOPE("test.scope");
+  }
+  std::string json = exported();
+  TEST_ASSERT_EQUAL_UINT32(1, Soylent::Trace::getRecorded());
+  TEST_ASSERT_EQUAL(1, count(json, "{\"name\":\"test.scope\",\"cat\":\"thingy\",\"ph\":\"X\",\"ts\":0,"));
+  TEST_ASSERT_EQUAL(1, count(json, ",\"dur\":"));
+}
+
+void test_instant_and_async() {
+  uint16_t id = TRACE_NEXT_ID();
+  TRACE_ASYNC_BEGIN("test.async", id);
+  TRACE_INSTANT("test.instant");
+  TRACE_ASYNC_END("test.async", id);
+  std::string json = exported();
+  TEST_ASSERT_EQUAL_UINT32(3, Soylent::Trace::getRecorded());
+  TEST_ASSERT_EQUAL(1, count(json, "\"ph\":\"i\""));
+  TEST_ASSERT_EQUAL(1, count(json, "\"s\":\"t\"}"));
+  std::string pairId = ",\"id\":" + std::to_string(id) + "}";
+  TEST_ASSERT_EQUAL(1, count(json, "\"ph\":\"b\""));
+  TEST_ASSERT_EQUAL(1, count(json, "\"ph\":\"e\""));
+  TEST_ASSERT_EQUAL(2, count(json, pairId));
+  // events are separated, the JSON is closed
+  TEST_ASSERT_EQUAL(2, count(json, "},{"));
+  TEST_ASSERT_EQUAL(0, json.compare(json.size() - 2, 2, "}}"));
+}
+
+// the oldest events are overwritten, but still counted
+void test_ring_overwrites() {
+  static const char* const names[] = {"test.old", "test.new"};
+  for (uint32_t i = 0; i < CONFIG_THINGY_TRACE_EVENTS + 10; i++) {
+    Soylent::Trace::record(Soylent::Trace::INSTANT, names[i >= 10], 0, i);
+  }
+  std::string json = exported();
+  TEST_ASSERT_EQUAL_UINT32(CONFIG_THINGY_TRACE_EVENTS + 10, Soylent::Trace::getRecorded());
+  TEST_ASSERT_EQUAL(0, count(json, "test.old"));
+  TEST_ASSERT_EQUAL(CONFIG_THINGY_TRACE_EVENTS, count(json, "test.new"));
+  TEST_ASSERT_EQUAL(1, count(json, "\"recorded\":" + std::to_string(CONFIG_THINGY_TRACE_EVENTS + 10) + "}"));
+}
+
+// timestamps count from the oldest event kept
+void test_timestamps() {
+  uint32_t now = Soylent::Trace::now();
+  Soylent::Trace::record(Soylent::Trace::INSTANT, "test.first", 0, now - 5000);
+  Soylent::Trace::record(Soylent::Trace::COMPLETE, "test.second", 0, now - 1000, 250);
+  std::string json = exported();
+  TEST_ASSERT_EQUAL(1, count(json, "\"name\":\"test.first\",\"cat\":\"thingy\",\"ph\":\"i\",\"ts\":0,"));
+  TEST_ASSERT_EQUAL(1, count(json, "\"name\":\"test.second\",\"cat\":\"thingy\",\"ph\":\"X\",\"ts\":4000,"));
+  TEST_ASSERT_EQUAL(1, count(json, ",\"dur\":250}"));
+}
+
+// 0 is left for what's not traced, even when the ids wrap around
+void test_ids_never_zero() {
+  uint16_t first = TRACE_NEXT_ID();
+  for (uint32_t i = 0; i < 0x10000; i++) {
+    TEST_ASSERT_NOT_EQUAL(0, TRACE_NEXT_ID());
+  }
+  TEST_ASSERT_NOT_EQUAL(0, first);
+}
+
+int main() {
+  UNITY_BEGIN();
+  RUN_TEST(test_empty);
+  RUN_TEST(test_scope);
+  RUN_TEST(test_instant_and_async);
+  RUN_TEST(test_ring_overwrites);
+  RUN_TEST(test_timestamps);
+  RUN_TEST(test_ids_never_zero);
+  return UNITY_END();
+}
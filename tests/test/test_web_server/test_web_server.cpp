@@ -0,0 +1,119 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+/*
+ * Copyright (C) 2025 Robert Wendlandt
+ */
+#include <thingy.h>
+#include <unity.h>
+
+#define ROUNDS 10
+
+static AsyncWebServer* webServer;
+static Soylent::WebServerClass* server;
+static Scheduler* scheduler;
+
+// begin() (or a resume) as the scheduler carries it out
+static void begin() {
+  server->begin(scheduler);
+  scheduler->execute();
+}
+
+void setUp() {
+  EventHandler.state = Soylent::ESPConnect::State::NETWORK_CONNECTED;
+  webServer = new AsyncWebServer();
+  server = new Soylent::WebServerClass(*webServer);
+  scheduler = new Scheduler();
+}
+
+void tearDown() {
+  delete server;
+  delete webServer;
+  delete scheduler;
+}
+
+void test_start() {
+  begin();
+  TEST_ASSERT_TRUE(webServer->listening);
+  TEST_ASSERT_TRUE(server->getStatusRequest()->completed());
+  TEST_ASSERT_NOT_NULL(webServer->getRoute("/metrics", HTTP_GET));
+  TEST_ASSERT_NOT_NULL(webServer->getRoute("/restart", HTTP_GET));
+  TEST_ASSERT_EQUAL(1, webServer->getMiddlewareCount());
+  TEST_ASSERT_EQUAL(1, webServer->notFoundRegistrations);
+  // (the task starting it is gone)
+  TEST_ASSERT_EQUAL(0, scheduler->getTaskCount());
+}
+
+// suspended and resumed over and over, the routes are registered once and no handler is allocated anew
+void test_suspend_resume() {
+  begin();
+  size_t handlers = webServer->getHandlerCount();
+  int instances = AsyncWebHandler::instances;
+  const AsyncCallbackWebHandler* metrics = webServer->getRoute("/metrics", HTTP_GET);
+
+  for (int round = 0; round < ROUNDS; round++) {
+    server->suspend();
+    TEST_ASSERT_TRUE(server->isSuspended());
+    TEST_ASSERT_FALSE(webServer->listening);
+    TEST_ASSERT_TRUE(server->getStatusRequest()->pending());
+    // (suspending once more changes nothing)
+    server->suspend();
+
+    begin();
+    TEST_ASSERT_FALSE(server->isSuspended());
+    TEST_ASSERT_TRUE(webServer->listening);
+    TEST_ASSERT_TRUE(server->getStatusRequest()->completed());
+    TEST_ASSERT_EQUAL(round + 2, webServer->begins);
+    TEST_ASSERT_EQUAL(handlers, webServer->getHandlerCount());
+    TEST_ASSERT_EQUAL(instances, AsyncWebHandler::instances);
+    TEST_ASSERT_EQUAL_PTR(metrics, webServer->getRoute("/metrics", HTTP_GET));
+    TEST_ASSERT_EQUAL(1, webServer->getMiddlewareCount());
+    TEST_ASSERT_EQUAL(1, webServer->notFoundRegistrations);
+    TEST_ASSERT_EQUAL(0, scheduler->getTaskCount());
+  }
+}
+
+// the 404-handler is left out for the captive portal, and registered (once) with the resume after it
+void test_resume_after_portal() {
+  EventHandler.state = Soylent::ESPConnect::State::PORTAL_STARTED;
+  begin();
+  TEST_ASSERT_EQUAL(0, webServer->notFoundRegistrations);
+  TEST_ASSERT_NOT_NULL(webServer->getRoute("/logo", HTTP_GET));
+
+  EventHandler.state = Soylent::ESPConnect::State::NETWORK_CONNECTED;
+  for (int round = 0; round < ROUNDS; round++) {
+    server->suspend();
+    begin();
+    TEST_ASSERT_EQUAL(1, webServer->notFoundRegistrations);
+  }
+}
+
+// end() drops all of it, the next begin() registers the routes anew (but not the admission)
+void test_end() {
+  begin();
+  size_t handlers = webServer->getHandlerCount();
+  int instances = AsyncWebHandler::instances;
+
+  server->end();
+  TEST_ASSERT_FALSE(webServer->listening);
+  TEST_ASSERT_FALSE(server->isSuspended());
+  TEST_ASSERT_EQUAL(0, webServer->getHandlerCount());
+  TEST_ASSERT_EQUAL(instances - static_cast<int>(handlers), AsyncWebHandler::instances);
+  // (nothing to resume)
+  server->suspend();
+  TEST_ASSERT_FALSE(server->isSuspended());
+
+  begin();
+  TEST_ASSERT_TRUE(webServer->listening);
+  TEST_ASSERT_EQUAL(handlers, webServer->getHandlerCount());
+  TEST_ASSERT_EQUAL(instances, AsyncWebHandler::instances);
+  TEST_ASSERT_EQUAL(1, webServer->getMiddlewareCount());
+  TEST_ASSERT_EQUAL(2, webServer->notFoundRegistrations);
+}
+
+int main() {
+  UNITY_BEGIN();
+  RUN_TEST(test_start);
+  RUN_TEST(test_suspend_resume);
+  RUN_TEST(test_resume_after_portal);
+  RUN_TEST(test_end);
+  return UNITY_END();
+}
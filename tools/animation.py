@@ -0,0 +1,207 @@
+# Encode animations for LEDThingy (see include/LedAnimation.h) and benchmark their playback
+#
+# usage: python tools/animation.py encode frames.rgb data/fire.leda --pixels 60 --fps 30 [--keyframes 50]
+#        python tools/animation.py encode --demo rainbow data/rainbow.leda --pixels 60 --fps 30 --frames 256
+#        python tools/animation.py info data/fire.leda
+#        python tools/animation.py bench ledthingy.local --state-idx 4 [--seconds 10]
+#
+# frames.rgb are raw 8-bit RGB frames back to back, e.g. from a video scaled to one pixel row:
+#        ffmpeg -i fire.mp4 -vf scale=60:1 -r 30 -pix_fmt rgb24 -f rawvideo frames.rgb
+# copy the .leda files into data/, upload them with "pio run -t uploadfs" and add them to led_states.json:
+#        {"name": "Fire!", "src": "/images/fire.svg", "animation": "/fire.leda"}
+import argparse
+import colorsys
+import http.client
+import json
+import math
+import struct
+import sys
+import time
+
+MAGIC = b"LEDA"
+VERSION = 1
+HEADER = struct.Struct("<4sBBHIHH")
+FRAME = struct.Struct("<BH")
+KEYFRAME = ord("K")
+DELTA = ord("D")
+MAX_SKIP = 0x80
+MAX_LITERAL = 0x80
+
+
+def encode_ops(data):
+    # runs of zeros are skipped, anything else is sent literally
+    ops = bytearray()
+    i = 0
+    while i < len(data):
+        if data[i] == 0:
+            run = 1
+            while i + run < len(data) and data[i + run] == 0 and run < MAX_SKIP:
+                run += 1
+            # skipping the rest of the frame is implicit
+            if i + run < len(data):
+                ops.append(run - 1)
+            i += run
+        else:
+            run = 1
+            # a single zero in between is cheaper to send than to skip
+            while i + run < len(data) and run < MAX_LITERAL and (data[i + run] != 0 or (i + run + 1 < len(data) and data[i + run + 1] != 0)):
+                run += 1
+            ops.append(0x7F + run)
+            ops += data[i : i + run]
+            i += run
+    return bytes(ops)
+
+
+def encode(frames, pixels, fps, keyframes):
+    out = bytearray(HEADER.pack(MAGIC, VERSION, fps, pixels, len(frames), keyframes, 0))
+    previous = bytes(pixels * 3)
+    for index, frame in enumerate(frames):
+        keyframe = index % keyframes == 0
+        base = bytes(pixels * 3) if keyframe else previous
+        ops = encode_ops(bytes(a ^ b for a, b in zip(frame, base)))
+        if len(ops) > 0xFFFF:
+            raise Exception(f"frame {index} is too large")
+        out += FRAME.pack(KEYFRAME if keyframe else DELTA, len(ops)) + ops
+        previous = frame
+    return bytes(out)
+
+
+def decode(data):
+    magic, version, fps, pixels, count, keyframes, _ = HEADER.unpack_from(data, 0)
+    if magic != MAGIC or version != VERSION:
+        raise Exception("not an animation")
+    offset = HEADER.size
+    frame = bytearray(pixels * 3)
+    frames = []
+    for index in range(count):
+        kind, length = FRAME.unpack_from(data, offset)
+        offset += FRAME.size
+        if kind == KEYFRAME:
+            frame = bytearray(pixels * 3)
+        elif kind != DELTA or index == 0:
+            raise Exception(f"frame {index} is broken")
+        position = 0
+        end = offset + length
+        while offset < end:
+            op = data[offset]
+            offset += 1
+            if op < 0x80:
+                position += op + 1
+            else:
+                for value in data[offset : offset + op - 0x7F]:
+                    frame[position] ^= value
+                    position += 1
+                offset += op - 0x7F
+        frames.append(bytes(frame))
+    return {"fps": fps, "pixels": pixels, "keyframes": keyframes}, frames
+
+
+def demo(name, pixels, count):
+    frames = []
+    for index in range(count):
+        frame = bytearray()
+        for i in range(pixels):
+            if name == "rainbow":
+                r, g, b = colorsys.hsv_to_rgb(((index + i * 4) % 256) / 256.0, 0.94, 1.0)
+            else:
+                # a dot running back and forth on black
+                position = int((math.sin(index / count * 2 * math.pi) + 1) / 2 * (pixels - 1))
+                r, g, b = (1.0, 0.5, 0.0) if i == position else (0.0, 0.0, 0.0)
+            frame += bytes([int(r * 255), int(g * 255), int(b * 255)])
+        frames.append(bytes(frame))
+    return frames
+
+
+def command_encode(args):
+    if args.demo:
+        frames = demo(args.demo, args.pixels, args.frames)
+    else:
+        with open(args.input, "rb") as file:
+            raw = file.read()
+        size = args.pixels * 3
+        frames = [raw[i : i + size] for i in range(0, len(raw) - size + 1, size)]
+    if not frames:
+        raise Exception("no frames")
+    data = encode(frames, args.pixels, args.fps, args.keyframes)
+    # make sure it's played as it was meant to
+    if decode(data)[1] != frames:
+        raise Exception("encoder is broken")
+    with open(args.output, "wb") as file:
+        file.write(data)
+    raw_size = len(frames) * args.pixels * 3
+    sys.stderr.write(f"animation.py: {len(frames)} frames, {raw_size} bytes raw, {len(data)} bytes encoded ({len(data) / raw_size:.1%})\n")
+
+
+def command_info(args):
+    with open(args.input, "rb") as file:
+        data = file.read()
+    start = time.perf_counter()
+    header, frames = decode(data)
+    elapsed = time.perf_counter() - start
+    sys.stderr.write(
+        f"animation.py: {len(frames)} frames of {header['pixels']} pixels at {header['fps']} fps (keyframe every {header['keyframes']}), "
+        f"{len(data)} bytes ({len(data) / (len(frames) * header['pixels'] * 3):.1%} of raw), "
+        f"decoded at {len(frames) / elapsed:.0f} fps on this host\n"
+    )
+
+
+def command_bench(args):
+    connection = http.client.HTTPConnection(args.host, 80, timeout=5)
+
+    def get(path):
+        connection.request("GET", path)
+        return json.loads(connection.getresponse().read())
+
+    before = get("/led/animation")
+    connection.request("PUT", "/led/state", body=json.dumps({"state_idx": args.state_idx}), headers={"Content-Type": "application/json"})
+    if connection.getresponse().read() != b"OK":
+        raise Exception(f"can't switch to state_idx {args.state_idx}")
+    time.sleep(args.seconds)
+    after = get("/led/animation")
+    if after["playing"] is None:
+        raise Exception(f"state_idx {args.state_idx} isn't an animation")
+
+    frames = after["frames"] - before["frames"]
+    # the averages are cumulative, so take the difference of the sums
+    decode_time = after["decode_avg_us"] * after["frames"] - before["decode_avg_us"] * before["frames"]
+    decode_avg = decode_time / max(frames, 1)
+    sys.stderr.write(
+        f"animation.py: {after['playing']}: {frames / args.seconds:5.1f} fps shown, decode avg {decode_avg:7.1f} us "
+        f"({1e6 / max(decode_avg, 1):.0f} fps, max so far {after['decode_max_us']} us), "
+        f"{after['reads'] - before['reads']} reads, {after['keyframes'] - before['keyframes']} keyframes, {after['errors'] - before['errors']} errors\n"
+    )
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Animations for LEDThingy")
+    commands = parser.add_subparsers(dest="command", required=True)
+    parser_encode = commands.add_parser("encode", help="encode raw RGB frames (or a demo)")
+    parser_encode.add_argument("input", nargs="?")
+    parser_encode.add_argument("output")
+    parser_encode.add_argument("--demo", choices=["rainbow", "dot"])
+    parser_encode.add_argument("--pixels", type=int, required=True)
+    parser_encode.add_argument("--fps", type=int, default=30)
+    parser_encode.add_argument("--frames", type=int, default=256, help="frames of the demo")
+    parser_encode.add_argument("--keyframes", type=int, default=50, help="frames from one keyframe to the next")
+    parser_info = commands.add_parser("info", help="verify an animation and decode it on this host")
+    parser_info.add_argument("input")
+    parser_bench = commands.add_parser("bench", help="play an animation on a thingy and report how fast it's decoded")
+    parser_bench.add_argument("host")
+    parser_bench.add_argument("--state-idx", type=int, required=True, help="the led_states.json entry of the animation")
+    parser_bench.add_argument("--seconds", type=float, default=10)
+    args = parser.parse_args()
+
+    if args.command == "encode":
+        if (args.input is None) == (args.demo is None):
+            parser.error("either an input or --demo is needed")
+        if not 1 <= args.fps <= 255:
+            parser.error("--fps out of range")
+        command_encode(args)
+    elif args.command == "info":
+        command_info(args)
+    else:
+        command_bench(args)
+
+
+if __name__ == "__main__":
+    main()
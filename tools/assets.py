@@ -1,11 +1,25 @@
 import gzip
 import os
+import struct
 import sys
+import zlib
+
+Import("env")
+
+# has to match include/AssetBundle.h
+MAGIC = 0x54534154
+VERSION = 1
+ALIGNMENT = 16
+PATH_SIZE = 40
+TYPE_SIZE = 24
+FLAG_GZIP = 0x01
+HEADER = struct.Struct("<IHHII")
+ENTRY = struct.Struct(f"<IIIB3x{PATH_SIZE}s{TYPE_SIZE}s")
 
 os.makedirs('.pio/assets', exist_ok=True)
 
 # list the files for gzipping here!
-# don't forget to list them in platformio.ini as well!
+# don't forget to list them in ASSETS below as well!
 for filename in ['logo_captive.svg', 'apple-touch-icon.png', 'favicon-96x96.png', 'favicon.ico', 'favicon.svg', 'logo_thingy.svg', 'logo_safeboot.svg']:
     skip = False
     if os.path.isfile('.pio/assets/' + filename + '.timestamp'):
@@ -16,8 +30,67 @@ for filename in ['logo_captive.svg', 'apple-touch-icon.png', 'favicon-96x96.png'
         sys.stderr.write(f"assets.py: {filename} up to date\n")
         continue
     with open('assets/' + filename, 'rb') as inputFile:
-        with gzip.open('.pio/assets/' + filename + '.gz', 'wb') as outputFile:            
+        # (no time in the gzip header, so the ETag only changes along with the asset)
+        with gzip.GzipFile('.pio/assets/' + filename + '.gz', 'wb', mtime=0) as outputFile:
             sys.stderr.write(f"assets.py: gzip \'assets/{filename}\' to \'.pio/assets/{filename}.gz\'\n")
             outputFile.writelines(inputFile)
     with open('.pio/assets/' + filename + '.timestamp', 'w', -1, 'utf-8') as timestampFile:
-        timestampFile.write(str(os.path.getmtime('assets/' + filename)))
\ No newline at end of file
+        timestampFile.write(str(os.path.getmtime('assets/' + filename)))
+
+# path served (see WebSiteTask.cpp and WebServerTask.cpp), gzipped file, content type
+# (thingy.html.gz is made by customize_thingy_html.py, which has to run first)
+ASSETS = [
+    ("/", "thingy.html.gz", "text/html"),
+    ("/logo", "logo_captive.svg.gz", "image/svg+xml"),
+    ("/thingy_logo", "logo_thingy.svg.gz", "image/svg+xml"),
+    ("/safeboot_logo", "logo_safeboot.svg.gz", "image/svg+xml"),
+    ("/favicon.svg", "favicon.svg.gz", "image/svg+xml"),
+    ("/apple-touch-icon.png", "apple-touch-icon.png.gz", "image/png"),
+    ("/favicon-96x96.png", "favicon-96x96.png.gz", "image/png"),
+    ("/favicon.ico", "favicon.ico.gz", "image/x-icon"),
+]
+# (the images in data/ stay on LittleFS, so a file system update shows up right away)
+
+
+def partition_of(label):
+    """Offset and size of a partition in the partition table of the build"""
+    with open(env.GetProjectOption("board_build.partitions"), "r") as table:
+        for line in table:
+            columns = [column.strip() for column in line.split("#")[0].split(",")]
+            if len(columns) >= 5 and columns[0] == label:
+                return tuple(int(value[:-1], 0) * 1024 if value.endswith("K") else int(value, 0) for value in columns[3:5])
+    return None
+
+
+def pack():
+    blobs = []
+    for path, filename, content_type in ASSETS:
+        with open('.pio/assets/' + filename, 'rb') as assetFile:
+            blobs.append((path, content_type, assetFile.read()))
+
+    # sorted by path, so the firmware finds them by bisection
+    blobs.sort(key=lambda blob: blob[0].encode())
+    offset = HEADER.size + ENTRY.size * len(blobs)
+    index = b""
+    data = b""
+    for path, content_type, blob in blobs:
+        if len(path) >= PATH_SIZE or len(content_type) >= TYPE_SIZE:
+            raise Exception(f"path or content type too long: {path} ({content_type})")
+        padding = -(offset + len(data)) % ALIGNMENT
+        data += b"\0" * padding
+        index += ENTRY.pack(offset + len(data), len(blob), zlib.crc32(blob), FLAG_GZIP, path.encode(), content_type.encode())
+        data += blob
+    body = index + data
+    bundle = HEADER.pack(MAGIC, VERSION, len(blobs), HEADER.size + len(body), zlib.crc32(body)) + body
+
+    partition = partition_of("assets")
+    if partition is None:
+        raise Exception("no partition 'assets' in the partition table")
+    if len(bundle) > partition[1]:
+        raise Exception(f"asset bundle too large: {len(bundle)} > {partition[1]}")
+    with open('.pio/assets/assets.bin', 'wb') as bundleFile:
+        bundleFile.write(bundle)
+    sys.stderr.write(f"assets.py: packed {len(blobs)} assets into '.pio/assets/assets.bin' ({len(bundle)} of {partition[1]} bytes, flash it at {hex(partition[0])})\n")
+
+
+pack()
@@ -0,0 +1,72 @@
+# Upload the asset bundle (made by assets.py at build time) to a LEDThingy, without touching the app:
+# restarts it into SafeBoot, switches SafeBoot to filesystem mode and uploads the bundle there
+# (SafeBoot tells the bundle by its magic and writes it to the partition "assets", the thingy restarts afterwards)
+#
+# usage: python tools/assets_upload.py ledthingy.local [--bundle .pio/assets/assets.bin] [--wait 60]
+import argparse
+import http.client
+import sys
+import time
+import uuid
+
+
+def request(host, method, path, body=None, headers={}, timeout=10):
+    connection = http.client.HTTPConnection(host, 80, timeout=timeout)
+    connection.request(method, path, body=body, headers=headers)
+    response = connection.getresponse()
+    content = response.read()
+    connection.close()
+    return response.status, content
+
+
+def main():
+    parser = argparse.ArgumentParser()
+    parser.add_argument("host")
+    parser.add_argument("--bundle", default=".pio/assets/assets.bin")
+    parser.add_argument("--wait", type=float, default=60, help="seconds to wait for SafeBoot to come up")
+    args = parser.parse_args()
+
+    with open(args.bundle, "rb") as bundleFile:
+        bundle = bundleFile.read()
+    if bundle[:4] != b"TAST":
+        sys.stderr.write(f"assets_upload.py: {args.bundle} is no asset bundle\n")
+        sys.exit(1)
+
+    # SafeBoot serves /sbversion, the app doesn't
+    try:
+        status, _ = request(args.host, "GET", "/sbversion")
+    except OSError:
+        status = None
+    if status != 200:
+        sys.stderr.write(f"assets_upload.py: restarting {args.host} into SafeBoot\n")
+        try:
+            request(args.host, "GET", "/safeboot")
+        except OSError:
+            pass
+        deadline = time.monotonic() + args.wait
+        while True:
+            time.sleep(2)
+            try:
+                status, version = request(args.host, "GET", "/sbversion", timeout=3)
+                if status == 200:
+                    break
+            except OSError:
+                pass
+            if time.monotonic() > deadline:
+                sys.stderr.write(f"assets_upload.py: SafeBoot didn't come up on {args.host}\n")
+                sys.exit(1)
+        sys.stderr.write(f"assets_upload.py: SafeBoot {version.decode()} is up\n")
+
+    request(args.host, "GET", "/ota_mode_fs")
+    boundary = uuid.uuid4().hex
+    body = (f"--{boundary}\r\nContent-Disposition: form-data; name=\"file\"; filename=\"assets.bin\"\r\n"
+            f"Content-Type: application/octet-stream\r\n\r\n").encode() + bundle + f"\r\n--{boundary}--\r\n".encode()
+    start = time.perf_counter()
+    status, content = request(args.host, "POST", f"/update?size={len(bundle)}", body=body,
+                              headers={"Content-Type": f"multipart/form-data; boundary={boundary}"}, timeout=60)
+    sys.stderr.write(f"assets_upload.py: {len(bundle)} bytes uploaded in {time.perf_counter() - start:.1f} s: {status} {content.decode(errors='replace')}\n")
+    sys.exit(0 if status == 200 else 1)
+
+
+if __name__ == "__main__":
+    main()
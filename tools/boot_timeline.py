@@ -0,0 +1,64 @@
+# Restart a LEDThingy in a given LED state and print how fast the LED was showing it again, compared to the network
+#
+# usage: python tools/boot_timeline.py ledthingy.local [--state-idx 3] [--restarts 3]
+import argparse
+import http.client
+import json
+import sys
+import time
+
+
+def request(host, method, path, body=None, headers=None):
+    connection = http.client.HTTPConnection(host, 80, timeout=5)
+    connection.request(method, path, body=body, headers=headers or {})
+    response = connection.getresponse()
+    data = response.read()
+    connection.close()
+    return response.status, data
+
+
+def wait_for_boot(host, timeout):
+    # the thingy is gone for a moment, then /boot answers again
+    deadline = time.monotonic() + timeout
+    while time.monotonic() < deadline:
+        try:
+            status, data = request(host, "GET", "/boot")
+            if status == 200:
+                return json.loads(data)
+        except OSError:
+            pass
+        time.sleep(0.5)
+    return None
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Boot timeline of a LEDThingy")
+    parser.add_argument("host")
+    parser.add_argument("--state-idx", type=int, default=3, help="LED state to be resumed (the rainbow shows its phase)")
+    parser.add_argument("--restarts", type=int, default=3)
+    parser.add_argument("--timeout", type=float, default=60, help="seconds to wait for the thingy to come back")
+    args = parser.parse_args()
+
+    request(args.host, "PUT", "/led/state", json.dumps({"state_idx": args.state_idx}), {"Content-Type": "application/json"})
+    for restart in range(args.restarts):
+        request(args.host, "GET", "/restart")
+        # let it go down first
+        time.sleep(2)
+        boot = wait_for_boot(args.host, args.timeout)
+        if boot is None:
+            sys.stderr.write(f"boot_timeline.py: the thingy didn't come back within {args.timeout:.0f} s\n")
+            return
+        first_frame = boot["led_first_frame_us"]
+        network = boot["network_up_us"]
+        sys.stderr.write(
+            f"boot_timeline.py: restart {restart + 1}: resumed state {boot['led_state']} from {boot['led_resumed_from']}, "
+            f"LED initialized at {boot['led_initialized_us'] / 1000:7.1f} ms, first frame at {first_frame / 1000:7.1f} ms, "
+            f"network up at {network / 1000:7.1f} ms ({(network - first_frame) / 1000:+.1f} ms after the first frame)\n"
+        )
+        _, data = request(args.host, "GET", "/led/state")
+        if json.loads(data)["state_idx"] != args.state_idx:
+            sys.stderr.write(f"boot_timeline.py: expected state_idx {args.state_idx}, got {json.loads(data)['state_idx']}\n")
+
+
+if __name__ == "__main__":
+    main()
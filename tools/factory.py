@@ -41,6 +41,10 @@ def generateFactooryImage(source, target, env):
     fs_offset = 0x3E0000
     fs_image = env.subst("$BUILD_DIR/littlefs.bin")
 
+    # the web assets, packed by assets.py (see the partition "assets")
+    assets_offset = 0x3C0000
+    assets_image = ".pio/assets/assets.bin"
+
     safeboot_offset = 0x10000
     safeboot_image = ""
 
@@ -129,6 +133,10 @@ def generateFactooryImage(source, target, env):
     status(f" -  {hex(app_offset)} | {app_image}")
     cmd += [hex(app_offset), app_image]
 
+    if os.path.isfile(assets_image):
+        status(f" - {hex(assets_offset)} | {assets_image}")
+        cmd += [hex(assets_offset), assets_image]
+
     if fs_image != 0 and os.path.isfile(fs_image):
         status(f" - {hex(fs_offset)} | {fs_image}")
         cmd += [hex(fs_offset), fs_image]
@@ -0,0 +1,97 @@
+# Create include/LedGamma.h, a lookup table from 8-bit perceived brightness to 12-bit LEDC duty
+# and check the piecewise-linear hardware fades against the exact curve
+#
+# usage: python tools/gamma_table.py [--gamma 2.2] [--segments 8]
+import argparse
+import sys
+
+RESOLUTION = 12
+MAX_DUTY = (1 << RESOLUTION) - 1
+
+
+def gamma_table(gamma):
+    table = []
+    for i in range(256):
+        duty = round(MAX_DUTY * (i / 255.0) ** gamma)
+        # keep the lowest levels distinguishable from off
+        table.append(max(duty, 1) if i > 0 else 0)
+    return table
+
+
+def write_header(table, gamma, segments, filename):
+    rows = []
+    for i in range(0, 256, 16):
+        rows.append("      " + ", ".join(f"{value:4d}" for value in table[i : i + 16]) + ",")
+    with open(filename, "w") as header:
+        header.write(
+            "// SPDX-License-Identifier: GPL-3.0-or-later\n"
+            "/*\n"
+            " * Copyright (C) 2025 Robert Wendlandt\n"
+            " */\n"
+            "// DO NOT EDIT - Created by tools/gamma_table.py\n"
+            "#pragma once\n"
+            "\n"
+            "#include <cstdint>\n"
+            "\n"
+            f"#define LED_GAMMA_RESOLUTION {RESOLUTION}\n"
+            f"// fades are split into this many hardware fades along the gamma curve\n"
+            f"#define LED_FADE_SEGMENTS {segments}\n"
+            "\n"
+            "namespace Soylent {\n"
+            "  namespace LedGamma {\n"
+            f"    // 8-bit perceived brightness to {RESOLUTION}-bit duty (gamma {gamma})\n"
+            "    static constexpr uint16_t table[256] = {\n" + "\n".join(rows) + "\n"
+            "    };\n"
+            "\n"
+            "    // the level a fade from one level to another reaches at the end of one of its segments (1 to LED_FADE_SEGMENTS),\n"
+            "    // and when, in ms after the start of the fade\n"
+            "    struct Segment {\n"
+            "        uint8_t level;\n"
+            "        uint32_t end;\n"
+            "    };\n"
+            "    static constexpr Segment segment(uint8_t from, uint8_t to, uint32_t duration, uint8_t index) {\n"
+            "      return {static_cast<uint8_t>(from + (to - from) * index / LED_FADE_SEGMENTS), duration * index / LED_FADE_SEGMENTS};\n"
+            "    }\n"
+            "  } // namespace LedGamma\n"
+            "} // namespace Soylent\n"
+        )
+
+
+def check_fade(table, segments, duration, step):
+    # worst deviation of the piecewise-linear hardware fade from the exact curve (in duty)
+    worst = 0
+    for t in range(duration + 1):
+        exact = table[round(255 * t / duration)]
+        segment = min(segments - 1, t * segments // duration)
+        t0 = segment * duration // segments
+        t1 = (segment + 1) * duration // segments
+        a = table[round(255 * segment / segments)]
+        b = table[round(255 * (segment + 1) / segments)]
+        approx = a + (b - a) * (t - t0) / (t1 - t0)
+        worst = max(worst, abs(approx - exact))
+    software_wakeups = duration / step
+    sys.stderr.write(
+        f"gamma_table.py: {duration} ms fade, {segments} hardware segments: worst deviation {worst:.1f} of {MAX_DUTY} duty, "
+        f"{segments} wake-ups instead of {software_wakeups:.0f} with software stepping every {step} ms\n"
+    )
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Gamma lookup table for LEDC dimming")
+    parser.add_argument("--gamma", type=float, default=2.2)
+    parser.add_argument("--segments", type=int, default=8)
+    parser.add_argument("--output", default="include/LedGamma.h")
+    args = parser.parse_args()
+
+    table = gamma_table(args.gamma)
+    if any(b < a for a, b in zip(table, table[1:])):
+        raise Exception("gamma table is not monotonic")
+    write_header(table, args.gamma, args.segments, args.output)
+    sys.stderr.write(f"gamma_table.py: wrote {args.output}\n")
+    # breathing (see LedClass: 128 * 19 ms per half period) and blink fades
+    check_fade(table, args.segments, 2432, 19)
+    check_fade(table, args.segments, 150, 10)
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,123 @@
+# Flood a LEDThingy with GET requests while measuring the latency of setting the LED
+# and the frame jitter of the crossfades it is causing (compare builds with CONFIG_THINGY_LED_PIPELINE=0 and 1)
+#
+# usage: python tools/http_load.py ledthingy.local [--flooders 8] [--duration 20]
+import argparse
+import http.client
+import json
+import statistics
+import sys
+import threading
+import time
+
+
+def flood(host, stop, counters, lock):
+    while not stop.is_set():
+        try:
+            connection = http.client.HTTPConnection(host, 80, timeout=5)
+            connection.request("GET", "/")
+            status = connection.getresponse().status
+            connection.close()
+        except OSError:
+            status = "error"
+        with lock:
+            counters[status] = counters.get(status, 0) + 1
+
+
+def control(host, stop, latencies, interval):
+    idx = 0
+    while not stop.is_set():
+        start = time.perf_counter()
+        try:
+            connection = http.client.HTTPConnection(host, 80, timeout=5)
+            connection.request("PUT", "/led/state", body=json.dumps({"state_idx": idx}), headers={"Content-Type": "application/json"})
+            status = connection.getresponse().status
+            connection.close()
+        except OSError:
+            status = "error"
+        latencies.append(((time.perf_counter() - start) * 1e3, status))
+        idx = (idx + 1) % 2
+        time.sleep(interval)
+
+
+def report(name, latencies):
+    times = sorted(latency for latency, status in latencies if status == 200)
+    failed = len(latencies) - len(times)
+    if not times:
+        sys.stderr.write(f"http_load.py: {name}: no successful PUT (failed: {failed})\n")
+        return
+    sys.stderr.write(
+        f"http_load.py: {name}: PUT /led/state median {statistics.median(times):7.2f} ms, "
+        f"p99 {times[max(0, int(len(times) * 0.99) - 1)]:7.2f} ms, max {times[-1]:7.2f} ms, failed {failed}\n"
+    )
+
+
+def pipeline(host):
+    try:
+        connection = http.client.HTTPConnection(host, 80, timeout=5)
+        connection.request("GET", "/led/pipeline")
+        stats = json.loads(connection.getresponse().read())
+        connection.close()
+        return stats
+    except (OSError, ValueError):
+        return None
+
+
+def report_jitter(name, before, after):
+    if before is None or after is None:
+        sys.stderr.write(f"http_load.py: {name}: no frame statistics\n")
+        return
+    scheduled = after["scheduled"] - before["scheduled"]
+    jitter = (after["jitter_sum_us"] - before["jitter_sum_us"]) / scheduled if scheduled else 0
+    sys.stderr.write(
+        f"http_load.py: {name}: {scheduled} frames, jitter avg {jitter:7.0f} us (max so far {after['jitter_max_us']} us), "
+        f"dropped {after['dropped'] - before['dropped']} "
+        f"(pipelined: {after['pipelined']}, render core {after['render_core']}, output core {after['output_core']})\n"
+    )
+
+
+def main():
+    parser = argparse.ArgumentParser(description="HTTP load test for LEDThingy")
+    parser.add_argument("host")
+    parser.add_argument("--flooders", type=int, default=8)
+    parser.add_argument("--duration", type=float, default=20.0)
+    parser.add_argument("--interval", type=float, default=0.25, help="seconds between LED changes")
+    args = parser.parse_args()
+
+    # baseline without load
+    frames_start = pipeline(args.host)
+    stop = threading.Event()
+    baseline = []
+    worker = threading.Thread(target=control, args=(args.host, stop, baseline, args.interval))
+    worker.start()
+    time.sleep(args.duration / 2)
+    stop.set()
+    worker.join()
+    report("idle", baseline)
+    frames_idle = pipeline(args.host)
+    report_jitter("idle", frames_start, frames_idle)
+
+    # now with a flood of GETs
+    stop = threading.Event()
+    loaded = []
+    counters = {}
+    lock = threading.Lock()
+    workers = [threading.Thread(target=flood, args=(args.host, stop, counters, lock)) for _ in range(args.flooders)]
+    workers.append(threading.Thread(target=control, args=(args.host, stop, loaded, args.interval)))
+    for worker in workers:
+        worker.start()
+    time.sleep(args.duration)
+    stop.set()
+    for worker in workers:
+        worker.join()
+    report(f"{args.flooders} flooders", loaded)
+    report_jitter(f"{args.flooders} flooders", frames_idle, pipeline(args.host))
+    sys.stderr.write(f"http_load.py: GET / responses: {counters}\n")
+
+    connection = http.client.HTTPConnection(args.host, 80, timeout=5)
+    connection.request("GET", "/metrics")
+    sys.stderr.write(f"http_load.py: thingy reports {connection.getresponse().read().decode()}\n")
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,99 @@
+# Measure the latency of fetching an image from LittleFS, cold and warm, plain and revalidated (If-None-Match)
+# compare builds with CONFIG_THINGY_FILE_CACHE_SIZE=0 and the default
+#
+# usage: python tools/image_bench.py ledthingy.local /images/my_image.svg [--requests 200] [--clients 4]
+import argparse
+import http.client
+import json
+import statistics
+import sys
+import threading
+import time
+
+
+def fetch(host, path, headers={}):
+    start = time.perf_counter()
+    connection = http.client.HTTPConnection(host, 80, timeout=5)
+    connection.request("GET", path, headers=headers)
+    response = connection.getresponse()
+    response.read()
+    connection.close()
+    return (time.perf_counter() - start) * 1e3, response.status, response.getheader("ETag")
+
+
+def image_cache(host):
+    try:
+        connection = http.client.HTTPConnection(host, 80, timeout=5)
+        connection.request("GET", "/metrics")
+        metrics = json.loads(connection.getresponse().read())
+        connection.close()
+        return metrics.get("image_cache")
+    except (OSError, ValueError):
+        return None
+
+
+def run(host, path, requests, clients, headers):
+    latencies = []
+    statuses = {}
+    lock = threading.Lock()
+
+    def client(count):
+        for _ in range(count):
+            try:
+                latency, status, _ = fetch(host, path, headers)
+            except OSError:
+                latency, status = None, "error"
+            with lock:
+                statuses[status] = statuses.get(status, 0) + 1
+                if latency is not None and status in (200, 304):
+                    latencies.append(latency)
+
+    workers = [threading.Thread(target=client, args=(requests // clients,)) for _ in range(clients)]
+    for worker in workers:
+        worker.start()
+    for worker in workers:
+        worker.join()
+    return sorted(latencies), statuses
+
+
+def report(name, latencies, statuses):
+    if not latencies:
+        sys.stderr.write(f"image_bench.py: {name}: no successful request {statuses}\n")
+        return
+    sys.stderr.write(
+        f"image_bench.py: {name}: median {statistics.median(latencies):7.2f} ms, "
+        f"p90 {latencies[int(len(latencies) * 0.9) - 1]:7.2f} ms, p99 {latencies[max(0, int(len(latencies) * 0.99) - 1)]:7.2f} ms, "
+        f"max {latencies[-1]:7.2f} ms {statuses}\n"
+    )
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Image latency benchmark for LEDThingy")
+    parser.add_argument("host")
+    parser.add_argument("path")
+    parser.add_argument("--requests", type=int, default=200)
+    parser.add_argument("--clients", type=int, default=4)
+    args = parser.parse_args()
+
+    before = image_cache(args.host)
+    latency, status, etag = fetch(args.host, args.path)
+    sys.stderr.write(f"image_bench.py: first request (cold): {latency:7.2f} ms ({status}, ETag {etag})\n")
+
+    report("sequential", *run(args.host, args.path, args.requests, 1, {}))
+    report(f"{args.clients} clients", *run(args.host, args.path, args.requests, args.clients, {}))
+    if etag:
+        report("revalidated", *run(args.host, args.path, args.requests, 1, {"If-None-Match": etag}))
+
+    after = image_cache(args.host)
+    if before is None or after is None:
+        sys.stderr.write("image_bench.py: no image cache on the thingy (built with CONFIG_THINGY_FILE_CACHE_SIZE=0?)\n")
+        return
+    sys.stderr.write(
+        "image_bench.py: cache "
+        + ", ".join(f"{key} +{after[key] - before[key]}" for key in ("hits", "misses", "bypassed", "not_modified", "evictions"))
+        + f", {after['files']} files ({after['bytes']} of {after['capacity']} bytes)\n"
+    )
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,61 @@
+# Keep switching the LED of a LEDThingy and scrape how long the commands took until they were shown
+#
+# usage: python tools/latency_scrape.py ledthingy.local [--interval 5] [--scrapes 6] [--rate 4] [--binary]
+import argparse
+import http.client
+import json
+import struct
+import sys
+import time
+
+
+def request(host, method, path, body=None, headers=None):
+    connection = http.client.HTTPConnection(host, 80, timeout=5)
+    connection.request(method, path, body=body, headers=headers or {})
+    response = connection.getresponse()
+    data = response.read()
+    connection.close()
+    return response.status, data
+
+
+def main():
+    parser = argparse.ArgumentParser(description="LED command latency of a LEDThingy")
+    parser.add_argument("host")
+    parser.add_argument("--interval", type=float, default=5, help="seconds between scrapes")
+    parser.add_argument("--scrapes", type=int, default=6)
+    parser.add_argument("--rate", type=float, default=4, help="commands per second")
+    parser.add_argument("--binary", action="store_true", help="switch via /led/command instead of PUT /led/state")
+    args = parser.parse_args()
+
+    # start over
+    request(args.host, "GET", "/led/latency")
+    state_idx = 0
+    sent = 0
+    for _ in range(args.scrapes):
+        deadline = time.monotonic() + args.interval
+        while time.monotonic() < deadline:
+            # off, on, blink and rainbow in turn (each one is a change)
+            state_idx = (state_idx + 1) % 4
+            if args.binary:
+                # see LedCommand.h: magic, version, SET_STATE and the index
+                request(args.host, "PUT", "/led/command", struct.pack("<BBBB", 0x4C, 1, 1, state_idx), {"Content-Type": "application/octet-stream"})
+            else:
+                request(args.host, "PUT", "/led/state", json.dumps({"state_idx": state_idx}), {"Content-Type": "application/json"})
+            sent += 1
+            time.sleep(1 / args.rate)
+
+        status, data = request(args.host, "GET", "/led/latency")
+        if status != 200:
+            sys.stderr.write(f"latency_scrape.py: /led/latency answered {status}\n")
+            return
+        latency = json.loads(data)
+        sys.stderr.write(
+            f"latency_scrape.py: {latency['count']:4d} of {sent:4d} commands in {latency['since_ms'] / 1000:5.1f} s: "
+            f"p50 {latency['p50_us'] / 1000:7.2f} ms, p90 {latency['p90_us'] / 1000:7.2f} ms, p99 {latency['p99_us'] / 1000:7.2f} ms, "
+            f"max {latency['max_us'] / 1000:7.2f} ms (min {latency['min_us'] / 1000:.2f} ms, avg {latency['avg_us'] / 1000:.2f} ms)\n"
+        )
+        sent = 0
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,57 @@
+# Measure the frame time of the layer compositor of a LEDThingy as the number of layers grows
+# the number of pixels is fixed at compile time (CONFIG_THINGY_LED_COUNT), run it once per build
+#
+# usage: python tools/layer_bench.py ledthingy.local [--seconds 5]
+import argparse
+import http.client
+import json
+import sys
+import time
+
+BLEND_MODES = ["alpha", "add", "multiply", "screen"]
+
+
+def request(connection, method, path, body=None):
+    headers = {"Content-Type": "application/json"} if body is not None else {}
+    connection.request(method, path, body=json.dumps(body) if body is not None else None, headers=headers)
+    response = connection.getresponse()
+    data = response.read()
+    if response.status != 200:
+        raise Exception(f"{path}: response status {response.status}")
+    return data
+
+
+def stats(connection):
+    return json.loads(request(connection, "GET", "/led/layers"))
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Layer compositor benchmark for LEDThingy")
+    parser.add_argument("host")
+    parser.add_argument("--seconds", type=float, default=5)
+    args = parser.parse_args()
+
+    connection = http.client.HTTPConnection(args.host, 80, timeout=5)
+    layers = len(stats(connection)["layers"])
+    # rainbow below everything
+    request(connection, "PUT", "/led/state", {"state_idx": 3})
+    try:
+        for count in range(1, layers + 1):
+            request(connection, "PUT", "/led/layer", {"layer": count - 1, "state_idx": 2, "opacity": 128, "blend": BLEND_MODES[(count - 1) % len(BLEND_MODES)]})
+            before = stats(connection)
+            time.sleep(args.seconds)
+            after = stats(connection)
+            frames = after["frames"] - before["frames"]
+            # the averages are cumulative, so take the difference of the sums
+            total = after["frame_time_avg_us"] * after["frames"] - before["frame_time_avg_us"] * before["frames"]
+            sys.stderr.write(
+                f"layer_bench.py: {after['pixels']:4d} pixels, {count} layer(s): {frames / args.seconds:5.1f} fps, "
+                f"frame time avg {total / max(frames, 1):7.1f} us (max so far {after['frame_time_max_us']} us)\n"
+            )
+    finally:
+        for layer in range(layers):
+            request(connection, "PUT", "/led/layer", {"layer": layer, "state_idx": -1})
+
+
+if __name__ == "__main__":
+    main()
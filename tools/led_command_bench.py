@@ -0,0 +1,54 @@
+# Compare the JSON-API with the binary command (see include/LedCommand.h) of a LEDThingy
+# reports round trip times and bytes on the wire (request line, headers and body)
+#
+# usage: python tools/led_command_bench.py ledthingy.local [--count 100]
+import argparse
+import http.client
+import json
+import statistics
+import struct
+import sys
+import time
+
+LED_COMMAND = struct.Struct("<BBBB")
+LED_COMMAND_MAGIC = 0x4C
+LED_COMMAND_VERSION = 1
+SET_STATE = 1
+
+
+def run(connection, path, body, content_type, count):
+    times = []
+    for i in range(count):
+        payload = body(i % 2)
+        start = time.perf_counter()
+        connection.request("PUT", path, body=payload, headers={"Content-Type": content_type})
+        response = connection.getresponse()
+        response.read()
+        times.append((time.perf_counter() - start) * 1e3)
+        if response.status != 200:
+            raise Exception(f"{path}: response status {response.status}")
+    request_line = f"PUT {path} HTTP/1.1\r\nHost: x\r\nContent-Type: {content_type}\r\nContent-Length: {len(payload)}\r\n\r\n"
+    return times, len(payload), len(request_line) + len(payload)
+
+
+def main():
+    parser = argparse.ArgumentParser(description="JSON vs. binary LED command benchmark for LEDThingy")
+    parser.add_argument("host")
+    parser.add_argument("--count", type=int, default=100)
+    args = parser.parse_args()
+
+    connection = http.client.HTTPConnection(args.host, 80, timeout=5)
+    results = {
+        "json": run(connection, "/led/state", lambda idx: json.dumps({"state_idx": idx}, separators=(",", ":")), "application/json", args.count),
+        "binary": run(connection, "/led/command", lambda idx: LED_COMMAND.pack(LED_COMMAND_MAGIC, LED_COMMAND_VERSION, SET_STATE, idx), "application/octet-stream", args.count),
+    }
+
+    for name, (times, body, wire) in results.items():
+        sys.stderr.write(
+            f"led_command_bench.py: {name:6s} body {body:3d} bytes, request {wire:3d} bytes, "
+            f"round trip median {statistics.median(times):6.2f} ms, p99 {sorted(times)[int(len(times) * 0.99) - 1]:6.2f} ms\n"
+        )
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,66 @@
+# Report how much a LEDThingy gets to sleep and at which CPU clock it runs in a few LED states, from the "power" numbers of /metrics
+#
+# usage: python tools/power_report.py ledthingy.local [--states 0 1 2 3] [--seconds 10]
+import argparse
+import http.client
+import json
+import sys
+import time
+
+
+def request(host, method, path, body=None):
+    connection = http.client.HTTPConnection(host, 80, timeout=5)
+    headers = {"Content-Type": "application/json"} if body is not None else {}
+    connection.request(method, path, body=body, headers=headers)
+    data = connection.getresponse().read()
+    connection.close()
+    return data
+
+
+def power(host):
+    return json.loads(request(host, "GET", "/metrics"))["power"]
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Sleep report for LEDThingy")
+    parser.add_argument("host")
+    parser.add_argument("--states", type=int, nargs="+", default=[0, 1, 2, 3], help="state_idx of the LED states to compare")
+    parser.add_argument("--seconds", type=float, default=10)
+    args = parser.parse_args()
+
+    first = power(args.host)
+    if not first["idle_sleep"]:
+        sys.stderr.write("power_report.py: the main loop doesn't sleep (CONFIG_THINGY_IDLE_SLEEP=0)\n")
+    if not first["light_sleep"]["supported"]:
+        sys.stderr.write("power_report.py: no light sleep in this firmware (see custom_sdkconfig in platformio.ini)\n")
+
+    for state in args.states:
+        if request(args.host, "PUT", "/led/state", json.dumps({"state_idx": state})) != b"OK":
+            sys.stderr.write(f"power_report.py: can't switch to state_idx {state}\n")
+            continue
+        # let the transition settle
+        time.sleep(1)
+        before = power(args.host)
+        start = time.monotonic()
+        time.sleep(args.seconds)
+        after = power(args.host)
+        elapsed_ms = (time.monotonic() - start) * 1000
+        # (our own requests wake the loop as well, two of them per state)
+        sleeps = after["sleeps"] - before["sleeps"]
+        slept = (after["slept_ms"] - before["slept_ms"]) / elapsed_ms
+        light = (after["light_sleep"]["allowed_ms"] - before["light_sleep"]["allowed_ms"]) / elapsed_ms
+        sys.stderr.write(
+            f"power_report.py: state_idx {state}: loop slept {slept:6.1%} of the time ({sleeps / args.seconds:6.1f} sleeps/s, "
+            f"{(after['early_wakeups'] - before['early_wakeups']) / args.seconds:5.1f} early wake-ups/s), light sleep allowed {light:6.1%}"
+        )
+        # time per CPU clock, as a share of the time measured
+        clocks = {entry["mhz"]: entry["ms"] for entry in before["cpu"]["time"]}
+        shares = [f"{(entry['ms'] - clocks.get(entry['mhz'], 0)) / elapsed_ms:.0%} at {entry['mhz']} MHz" for entry in after["cpu"]["time"]]
+        sys.stderr.write(f", CPU {', '.join(shares)}")
+        if "cpu_idle_percent" in after:
+            sys.stderr.write(f", CPU idle since start-up {after['cpu_idle_percent']} %")
+        sys.stderr.write("\n")
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,118 @@
+# Measure what the live preview of a LEDThingy costs per subscriber, in CPU time on the thingy and in bytes on air
+#
+# usage: python tools/preview_cost.py ledthingy.local [--subscribers 2] [--rate 10] [--seconds 10] [--state-idx 3]
+import argparse
+import base64
+import http.client
+import json
+import os
+import socket
+import struct
+import sys
+import threading
+import time
+
+
+def get(host, path):
+    connection = http.client.HTTPConnection(host, 80, timeout=5)
+    connection.request("GET", path)
+    data = json.loads(connection.getresponse().read())
+    connection.close()
+    return data
+
+
+def receive_exactly(sock, count):
+    data = b""
+    while len(data) < count:
+        chunk = sock.recv(count - len(data))
+        if not chunk:
+            raise OSError("connection closed")
+        data += chunk
+    return data
+
+
+def subscribe(host, rate, stop, counters, lock):
+    # just enough of a WebSocket client (RFC 6455) for binary messages
+    sock = socket.create_connection((host, 80), timeout=5)
+    key = base64.b64encode(os.urandom(16)).decode()
+    sock.sendall(
+        f"GET /led/preview/ws HTTP/1.1\r\nHost: {host}\r\nUpgrade: websocket\r\nConnection: Upgrade\r\n"
+        f"Sec-WebSocket-Key: {key}\r\nSec-WebSocket-Version: 13\r\n\r\n".encode()
+    )
+    response = b""
+    while b"\r\n\r\n" not in response:
+        response += receive_exactly(sock, 1)
+    if b" 101 " not in response.split(b"\r\n")[0]:
+        raise OSError("no WebSocket")
+
+    # the rate asked for: a single byte, masked as clients have to
+    mask = os.urandom(4)
+    sock.sendall(bytes([0x82, 0x81]) + mask + bytes([rate ^ mask[0]]))
+
+    sock.settimeout(0.5)
+    while not stop.is_set():
+        try:
+            header = receive_exactly(sock, 2)
+        except socket.timeout:
+            continue
+        length = header[1] & 0x7F
+        if length == 126:
+            length = struct.unpack(">H", receive_exactly(sock, 2))[0]
+        elif length == 127:
+            length = struct.unpack(">Q", receive_exactly(sock, 8))[0]
+        receive_exactly(sock, length)
+        with lock:
+            counters["messages"] += 1
+            # the WebSocket framing is on air as well
+            counters["bytes"] += length + (2 if length < 126 else 4)
+    sock.close()
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Live preview cost for LEDThingy")
+    parser.add_argument("host")
+    parser.add_argument("--subscribers", type=int, default=2)
+    parser.add_argument("--rate", type=int, default=10, help="frames per second asked for")
+    parser.add_argument("--seconds", type=float, default=10)
+    parser.add_argument("--state-idx", type=int, default=3, help="LED state to be previewed (the rainbow keeps on changing)")
+    args = parser.parse_args()
+
+    connection = http.client.HTTPConnection(args.host, 80, timeout=5)
+    connection.request("PUT", "/led/state", body=json.dumps({"state_idx": args.state_idx}), headers={"Content-Type": "application/json"})
+    connection.getresponse().read()
+    connection.close()
+
+    stop = threading.Event()
+    lock = threading.Lock()
+    counters = {"messages": 0, "bytes": 0}
+    workers = [threading.Thread(target=subscribe, args=(args.host, args.rate, stop, counters, lock)) for _ in range(args.subscribers)]
+    for worker in workers:
+        worker.start()
+    # let the subscriptions settle
+    time.sleep(1)
+    with lock:
+        counters["messages"] = 0
+        counters["bytes"] = 0
+    before = get(args.host, "/led/preview")
+    time.sleep(args.seconds)
+    after = get(args.host, "/led/preview")
+    with lock:
+        messages, received = counters["messages"], counters["bytes"]
+    stop.set()
+    for worker in workers:
+        worker.join()
+    time.sleep(1)
+    idle = get(args.host, "/led/preview")
+
+    subscribers = max(after["subscribers"], 1)
+    cpu = (after["send_time_sum_us"] - before["send_time_sum_us"]) / (args.seconds * 1e6)
+    sys.stderr.write(
+        f"preview_cost.py: {after['subscribers']} subscriber(s) at {args.rate} fps: {messages / args.seconds / subscribers:5.1f} frames/s, "
+        f"{received / args.seconds / subscribers:7.0f} bytes/s on air and {cpu / subscribers:.3%} CPU per subscriber, "
+        f"{after['skipped'] - before['skipped']} frames skipped (send queue full)\n"
+    )
+    sys.stderr.write(f"preview_cost.py: after unsubscribing: {idle['subscribers']} subscriber(s), {idle['frames'] - after['frames']} frames sent\n")
+
+
+if __name__ == "__main__":
+    main()
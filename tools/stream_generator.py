@@ -0,0 +1,103 @@
+# Send a rainbow as DDP or E1.31 stream to a LEDThingy and report its streaming statistics
+#
+# usage: python tools/stream_generator.py ledthingy.local --protocol ddp --fps 40 --duration 10 --reorder 0.05
+import argparse
+import colorsys
+import json
+import random
+import socket
+import sys
+import time
+import urllib.request
+
+DDP_PORT = 4048
+E131_PORT = 5568
+
+
+def ddp_packet(sequence, pixels):
+    # version 1, push
+    header = bytes([0x41, sequence & 0x0F, 0x01, 0x01, 0, 0, 0, 0, len(pixels) >> 8, len(pixels) & 0xFF])
+    return header + pixels
+
+
+def e131_packet(sequence, universe, pixels):
+    cid = bytes(range(16))
+    source = b"stream_generator".ljust(64, b"\0")
+    dmp = bytes([0x02, 0xA1, 0x00, 0x00, 0x00, 0x01]) + (len(pixels) + 1).to_bytes(2, "big") + b"\0" + pixels
+    dmp = (0x7000 | (len(dmp) + 2)).to_bytes(2, "big") + dmp
+    framing = (
+        (0x00000002).to_bytes(4, "big")
+        + source
+        + bytes([100])
+        + (0).to_bytes(2, "big")
+        + bytes([sequence & 0xFF, 0])
+        + universe.to_bytes(2, "big")
+        + dmp
+    )
+    framing = (0x7000 | (len(framing) + 2)).to_bytes(2, "big") + framing
+    root = (0x00000004).to_bytes(4, "big") + cid + framing
+    root = (0x7000 | (len(root) + 2)).to_bytes(2, "big") + root
+    return bytes([0x00, 0x10, 0x00, 0x00]) + b"ASC-E1.17\0\0\0" + root
+
+
+def rainbow(hue, count):
+    pixels = bytearray()
+    for i in range(count):
+        r, g, b = colorsys.hsv_to_rgb(((hue + i * 8) % 256) / 256.0, 0.94, 1.0)
+        pixels += bytes([int(r * 255), int(g * 255), int(b * 255)])
+    return bytes(pixels)
+
+
+def main():
+    parser = argparse.ArgumentParser(description="DDP / E1.31 packet generator for LEDThingy")
+    parser.add_argument("host")
+    parser.add_argument("--protocol", choices=["ddp", "e131"], default="ddp")
+    parser.add_argument("--universe", type=int, default=1)
+    parser.add_argument("--pixels", type=int, default=1)
+    parser.add_argument("--fps", type=float, default=40.0)
+    parser.add_argument("--duration", type=float, default=10.0)
+    parser.add_argument("--reorder", type=float, default=0.0, help="fraction of packets sent out of order")
+    args = parser.parse_args()
+
+    address = socket.gethostbyname(args.host)
+    sock = socket.socket(socket.AF_INET, socket.SOCK_DGRAM)
+    port = DDP_PORT if args.protocol == "ddp" else E131_PORT
+
+    sent = 0
+    reordered = 0
+    held = None
+    hue = 0
+    interval = 1.0 / args.fps
+    next_frame = time.monotonic()
+    end = next_frame + args.duration
+    while time.monotonic() < end:
+        if args.protocol == "ddp":
+            # DDP sequence numbers are running from 1 to 15
+            packet = ddp_packet(sent % 15 + 1, rainbow(hue, args.pixels))
+        else:
+            packet = e131_packet(sent, args.universe, rainbow(hue, args.pixels))
+        sent += 1
+        hue = (hue + 1) % 256
+
+        if held is None and random.random() < args.reorder:
+            # hold this packet back, it'll arrive late after the next one
+            held = packet
+            reordered += 1
+        else:
+            sock.sendto(packet, (address, port))
+            if held is not None:
+                sock.sendto(held, (address, port))
+                held = None
+
+        next_frame += interval
+        time.sleep(max(0.0, next_frame - time.monotonic()))
+
+    sys.stderr.write(f"stream_generator.py: sent {sent} packets ({reordered} out of order) at {args.fps} fps\n")
+
+    with urllib.request.urlopen(f"http://{args.host}/led/stream", timeout=5) as response:
+        stats = json.load(response)
+    sys.stderr.write(f"stream_generator.py: thingy reports {json.dumps(stats)}\n")
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,53 @@
+# Right-size the stacks of a LEDThingy and watch its heap, from the samples served at /telemetry
+#
+# usage: python tools/telemetry_report.py ledthingy.local [--margin 512]
+# exercise the thingy for a while first (animations, streaming, the web page,...), as only stack used so far is seen
+import argparse
+import http.client
+import json
+import sys
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Stack and heap telemetry of LEDThingy")
+    parser.add_argument("host")
+    parser.add_argument("--margin", type=int, default=512, help="bytes of stack to keep free on top of what was used")
+    args = parser.parse_args()
+
+    connection = http.client.HTTPConnection(args.host, 80, timeout=5)
+    connection.request("GET", "/telemetry")
+    telemetry = json.loads(connection.getresponse().read())
+    connection.close()
+    samples = telemetry["samples"]
+
+    for stack in telemetry["stacks"]:
+        if stack["size"] == 0:
+            continue
+        if stack["min_free"] < 0:
+            sys.stderr.write(f"telemetry_report.py: {stack['task']:>10}: {stack['size']:6d} bytes, never seen running\n")
+            continue
+        used = stack["size"] - stack["min_free"]
+        # stack sizes are best kept in multiples of 256 bytes
+        suggested = -(-(used + args.margin) // 256) * 256
+        sys.stderr.write(
+            f"telemetry_report.py: {stack['task']:>10}: {stack['size']:6d} bytes, {used:6d} used at most ({used / stack['size']:4.0%}), "
+            f"{suggested:6d} would do\n"
+        )
+
+    if len(samples) < 2:
+        sys.stderr.write("telemetry_report.py: not enough samples for the heap yet\n")
+        return
+    first, last = samples[0], samples[-1]
+    hours = max(last["at"] - first["at"], 1) / 3600000
+    # fragmentation: how much of the free heap can't be had in one piece
+    fragmentation = [1 - sample["heap_largest_block"] / max(sample["heap_free"], 1) for sample in samples]
+    sys.stderr.write(
+        f"telemetry_report.py: heap: {last['heap_free']} bytes free ({last['heap_min_free']} at least), largest block {last['heap_largest_block']}, "
+        f"over {len(samples)} samples: free {(last['heap_free'] - first['heap_free']) / hours:+.0f} bytes/h, "
+        f"largest block {(last['heap_largest_block'] - first['heap_largest_block']) / hours:+.0f} bytes/h, "
+        f"fragmentation {fragmentation[0]:.0%} -> {fragmentation[-1]:.0%}\n"
+    )
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,65 @@
+# Listen to the sync beacons of all LEDThingys in the network and report their phase error
+#
+# usage: python tools/timesync_monitor.py [--duration 60]
+import argparse
+import socket
+import struct
+import sys
+import time
+
+SYNC_GROUP = "239.255.76.84"
+SYNC_PORT = 4049
+# see TimeSyncClass::SyncPacket
+SYNC_PACKET = struct.Struct("<4sBBHIIqqq")
+SYNC_BEACON = 1
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Phase error monitor for LEDThingy time sync")
+    parser.add_argument("--duration", type=float, default=60.0)
+    parser.add_argument("--period", type=float, default=5.0, help="seconds between reports")
+    args = parser.parse_args()
+
+    sock = socket.socket(socket.AF_INET, socket.SOCK_DGRAM, socket.IPPROTO_UDP)
+    sock.setsockopt(socket.SOL_SOCKET, socket.SO_REUSEADDR, 1)
+    sock.bind(("", SYNC_PORT))
+    membership = struct.pack("4sl", socket.inet_aton(SYNC_GROUP), socket.INADDR_ANY)
+    sock.setsockopt(socket.IPPROTO_IP, socket.IP_ADD_MEMBERSHIP, membership)
+    sock.settimeout(0.5)
+
+    # latest (network time - local time of arrival) per node
+    nodes = {}
+    leaders = {}
+    worst = 0.0
+    start = time.monotonic()
+    next_report = start + args.period
+    while time.monotonic() - start < args.duration:
+        try:
+            data, _ = sock.recvfrom(64)
+            arrival = time.monotonic_ns() // 1000
+        except socket.timeout:
+            data = None
+
+        if data is not None and len(data) == SYNC_PACKET.size:
+            magic, version, packet_type, _, node, leader, t1, _, _ = SYNC_PACKET.unpack(data)
+            if magic == b"LTSY" and packet_type == SYNC_BEACON:
+                nodes[node] = t1 - arrival
+                leaders[node] = leader
+
+        if time.monotonic() >= next_report and nodes:
+            next_report += args.period
+            leader = min(nodes)
+            line = f"{time.monotonic() - start:7.1f}s"
+            for node in sorted(nodes):
+                # includes the jitter of the beacon's way through the network
+                error = (nodes[node] - nodes[leader]) / 1000.0
+                if node != leader:
+                    worst = max(worst, abs(error))
+                line += f"  {node:08x}->{leaders[node]:08x}: {error:+8.2f} ms"
+            print(line)
+
+    sys.stderr.write(f"timesync_monitor.py: {len(nodes)} thingys, worst phase error {worst:.2f} ms\n")
+
+
+if __name__ == "__main__":
+    main()
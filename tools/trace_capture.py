@@ -0,0 +1,54 @@
+# Capture what a LEDThingy is doing while switching LED states, as a Chrome trace (chrome://tracing or https://ui.perfetto.dev)
+#
+# usage: python tools/trace_capture.py ledthingy.local [--switches 10] [--output thingy.trace.json]
+import argparse
+import http.client
+import json
+import sys
+import time
+from collections import defaultdict
+
+
+def request(host, method, path, body=None):
+    connection = http.client.HTTPConnection(host, 80, timeout=5)
+    headers = {"Content-Type": "application/json"} if body is not None else {}
+    connection.request(method, path, body=body, headers=headers)
+    data = connection.getresponse().read()
+    connection.close()
+    return data
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Trace capture for LEDThingy")
+    parser.add_argument("host")
+    parser.add_argument("--switches", type=int, default=10, help="PUT /led/state this often, alternating between off and on")
+    parser.add_argument("--output", default="thingy.trace.json")
+    args = parser.parse_args()
+
+    request(args.host, "DELETE", "/trace")
+    for i in range(args.switches):
+        start = time.perf_counter()
+        request(args.host, "PUT", "/led/state", json.dumps({"state_idx": i % 2}))
+        sys.stderr.write(f"trace_capture.py: PUT /led/state took {(time.perf_counter() - start) * 1000:6.1f} ms on this side\n")
+        time.sleep(0.2)
+    trace = json.loads(request(args.host, "GET", "/trace"))
+    with open(args.output, "w") as file:
+        json.dump(trace, file)
+
+    # where the time goes: scopes by name, async pairs by begin and end
+    durations = defaultdict(list)
+    begun = {}
+    for event in trace["traceEvents"]:
+        if event["ph"] == "X":
+            durations[event["name"]].append(event["dur"])
+        elif event["ph"] == "b":
+            begun[(event["name"], event["id"])] = event["ts"]
+        elif event["ph"] == "e" and (event["name"], event["id"]) in begun:
+            durations[event["name"]].append(event["ts"] - begun[(event["name"], event["id"])])
+    for name, values in sorted(durations.items()):
+        sys.stderr.write(f"trace_capture.py: {name:>28}: {len(values):4d}x, avg {sum(values) / len(values):8.1f} us, max {max(values):7d} us\n")
+    sys.stderr.write(f"trace_capture.py: {len(trace['traceEvents'])} events ({trace['otherData']['recorded']} recorded) written to {args.output}\n")
+
+
+if __name__ == "__main__":
+    main()